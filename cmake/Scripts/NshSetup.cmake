@@ -38,6 +38,21 @@ function(nsh_add_test)
     nsh_platform_add_test(${ARGV})
 endfunction()
 
+# Define Nsh wrapper to add a copy of the main Nsh library built with its own configuration
+# The compile definitions (NSH_FEATURE_USE_* for instance) are given as target_compile_definitions arguments
+function(nsh_add_library_variant TARGET)
+    nsh_add_library(${TARGET} STATIC)
+    get_target_property(nsh_sources Nsh::Nsh SOURCES)
+    get_target_property(nsh_include_dirs Nsh::Nsh INCLUDE_DIRECTORIES)
+    get_target_property(nsh_compile_features Nsh::Nsh COMPILE_FEATURES)
+    get_target_property(nsh_link_libraries Nsh::Nsh LINK_LIBRARIES)
+    target_sources(${TARGET} PRIVATE ${nsh_sources})
+    target_link_libraries(${TARGET} PUBLIC ${nsh_link_libraries})
+    target_include_directories(${TARGET} PUBLIC ${nsh_include_dirs})
+    target_compile_features(${TARGET} PUBLIC ${nsh_compile_features})
+    target_compile_definitions(${TARGET} ${ARGN})
+endfunction()
+
 # Define Nsh wrapper to add a platform-agnostic tool
 function(nsh_add_tool TARGET)
     nsh_add_executable(${TARGET} ${ARGN})
@@ -5,26 +5,265 @@
 #include <nsh/nsh_cmd_array.h>
 #include <nsh/nsh_config.h>
 #include <nsh/nsh_history.h>
+#include <nsh/nsh_history_log.h>
+#include <nsh/nsh_io_plugin.h>
+#include <nsh/nsh_job.h>
 #include <nsh/nsh_line_buffer.h>
+#include <nsh/nsh_log.h>
+#include <nsh/nsh_pipe.h>
+#include <nsh/nsh_redirect.h>
+#include <nsh/nsh_script.h>
+
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+
+/**
+ * @brief Capacities of a shell instance, given to nsh_init_with_arena().
+ *
+ * They replace NSH_LINE_BUFFER_SIZE, NSH_CMD_MAX_COUNT, NSH_CMD_ARGS_MAX_COUNT
+ * and NSH_CMD_HISTORY_SIZE, with the same constraints.
+ */
+typedef struct nsh_limits {
+    unsigned int line_buffer_size;
+    unsigned int cmd_max_count;
+    unsigned int cmd_args_max_count;
+    unsigned int cmd_history_size; ///< Ignored if NSH_FEATURE_USE_HISTORY == 0
+} nsh_limits_t;
+
+#if NSH_FEATURE_USE_HISTORY == 1
+#define NSH_ARENA_HISTORY_SIZE_(cmd_history_size) (cmd_history_size)
+#else
+#define NSH_ARENA_HISTORY_SIZE_(cmd_history_size) 0u
+#endif
+
+/**
+ * @def NSH_ARENA_SIZE(<line-buffer-size>, <cmd-max-count>, <cmd-args-max-count>, <cmd-history-size>)
+ * @brief Exact number of bytes of the arena required by the given limits, usable to size a static buffer.
+ */
+#define NSH_ARENA_SIZE(line_buffer_size, cmd_max_count, cmd_args_max_count, cmd_history_size) \
+    ((cmd_max_count) * sizeof(nsh_cmd_t) + (cmd_args_max_count) * (sizeof(char*) + NSH_MAX_STRING_SIZE) \
+        + (line_buffer_size) + NSH_ARENA_HISTORY_SIZE_(cmd_history_size))
+
+#endif // NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+
+/*
+ * All the state of a shell instance is held by nsh_t, so that several
+ * instances can run concurrently, each one with its own I/O.
+ */
 typedef struct nsh_s {
+    nsh_io_t io;
     nsh_line_buffer_t line;
     nsh_cmd_array_t cmds;
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+    char (*args)[NSH_MAX_STRING_SIZE]; ///< Arguments of the command line after splitting
+    char** argv;
+    unsigned int args_max_count;
+#endif
+    nsh_cancel_token_t cancel; ///< Cancel token of the command running in the foreground
+    nsh_clock_t* clock;
+    unsigned int command_timeout_ms;
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    nsh_cycle_counter_t* cycle_counter;
+    uint32_t cycle_counter_frequency_hz;
+#endif
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+    nsh_cmd_handler_t* command_not_found_handler; ///< Null to report the unknown commands
+#endif
+#if NSH_FEATURE_USE_PIPES == 1
+    nsh_pipeline_t pipeline; ///< Filters of the command running in the foreground
+#endif
+#if NSH_FEATURE_USE_REDIRECTION == 1
+    nsh_redirect_t redirect; ///< File the output of the command running in the foreground is redirected to
+#endif
+#if NSH_FEATURE_USE_SCRIPTS == 1
+    nsh_script_t script; ///< Last script compiled by the script command
+#endif
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+    void* stack_limit; ///< Lowest address of the painted stack, null if unknown
+    size_t stack_size;
+#endif
 #if NSH_FEATURE_USE_HISTORY == 1
     nsh_history_t history;
     unsigned int current_history_entry;
+    bool history_entry_shown; ///< The displayed line is the current history entry, not yet copied into 'line'
+    unsigned int history_candidates[NSH_HISTORY_CANDIDATE_CACHE_SIZE]; ///< Most recent entries starting with 'line'
+    unsigned int history_candidate_count;
+    unsigned int history_candidate_index; ///< Index of the current entry, or count if past the cached ones
+#endif
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+    nsh_history_log_t history_log;
+#endif
+#if NSH_FEATURE_USE_JOBS == 1
+    nsh_job_table_t jobs;
+#endif
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+    nsh_log_queue_t log;
+    unsigned int log_dropped_reported; ///< Dropped messages count already reported to the user
 #endif
 } nsh_t;
 
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+/**
+ * @brief Return the exact number of bytes of the arena required by 'limits', see NSH_ARENA_SIZE().
+ */
+size_t nsh_arena_size(const nsh_limits_t* limits) NSH_NON_NULL(1);
+
+/**
+ * @brief Initialize 'nsh', carving all its tables out of 'arena' according to 'limits'.
+ *
+ * Nothing is allocated on the heap. 'arena' must be aligned as a pointer, and
+ * must outlive 'nsh'. Return NSH_STATUS_BUFFER_OVERFLOW if 'arena_size' is below
+ * nsh_arena_size(limits), and NSH_STATUS_WRONG_ARG if 'arena' is misaligned or
+ * if a limit is invalid, such as a 'cmd_max_count' too small for the builtins.
+ */
+nsh_status_t nsh_init_with_arena(nsh_t* nsh, void* arena, size_t arena_size, const nsh_limits_t* limits)
+    NSH_NON_NULL(1, 2, 4);
+#else
+/**
+ * @brief Return an initialized shell by value.
+ *
+ * The whole nsh_t is built on the stack then copied, prefer nsh_init_inplace()
+ * where the stack is scarce. 'status' is set to NSH_STATUS_MAX_CMD_NB_REACH if
+ * NSH_CMD_MAX_COUNT is too small for the builtins.
+ */
 nsh_t nsh_init(nsh_status_t* status) NSH_NON_NULL(1);
 
+/**
+ * @brief Initialize the shell pointed by 'nsh' without any copy, so that it can live in static storage.
+ *
+ * Return NSH_STATUS_MAX_CMD_NB_REACH if NSH_CMD_MAX_COUNT is too small for the builtins.
+ */
+nsh_status_t nsh_init_inplace(nsh_t* nsh) NSH_NON_NULL(1);
+#endif
+
 nsh_status_t nsh_register_command(nsh_t* nsh, const char* name, nsh_cmd_handler_t* handler);
 
-void nsh_run(nsh_t* nsh);
+/**
+ * @brief Replace the I/O backend of the shell, which defaults to nsh_io_stdio_backend.
+ *
+ * 'ctx' is given to each backend operation and must outlive 'nsh'.
+ */
+void nsh_set_io(nsh_t* nsh, const nsh_io_backend_t* backend, void* ctx) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Replace the prompt of the shell, which defaults to NSH_DEFAULT_PROMPT. 'prompt' must outlive 'nsh'.
+ */
+void nsh_set_prompt(nsh_t* nsh, const char* prompt) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Set the clock used to cancel the commands running for too long. May be null to disable the timeouts.
+ */
+void nsh_set_clock(nsh_t* nsh, nsh_clock_t* clock) NSH_NON_NULL(1);
+
+/**
+ * @brief Cancel the foreground commands running for more than 'timeout_ms', or never if 0.
+ *
+ * Defaults to NSH_DEFAULT_COMMAND_TIMEOUT_MS. Requires a clock, see nsh_set_clock().
+ */
+void nsh_set_command_timeout(nsh_t* nsh, unsigned int timeout_ms) NSH_NON_NULL(1);
+
+/**
+ * @brief Cancel the command running in the foreground, as Ctrl-C does in a terminal.
+ *
+ * May be called from another thread, an interrupt handler (on the reception of
+ * a Ctrl-C byte for instance) or a signal handler. The command stops once its
+ * handler sees its cancel token set, see nsh_cmd_is_cancelled().
+ */
+void nsh_interrupt(nsh_t* nsh) NSH_NON_NULL(1);
+
+#if NSH_FEATURE_USE_CMD_STATS == 1
+/**
+ * @brief Set the counter measuring the latency of the commands, ticking at 'frequency_hz'.
+ *
+ * The "stats" builtin displays the latencies in microseconds, or in ticks if
+ * 'frequency_hz' is 0. Without counter, only the calls and errors are counted.
+ */
+void nsh_set_cycle_counter(nsh_t* nsh, nsh_cycle_counter_t* counter, uint32_t frequency_hz) NSH_NON_NULL(1);
+#endif
+
+#if NSH_FEATURE_USE_TRACE == 1
+/**
+ * @brief Record the phases of the shell, and of its jobs and pipes, into 'trace', null to stop tracing.
+ *
+ * 'trace' must outlive 'nsh', and can be shared by several shells, each record naming its I/O.
+ */
+void nsh_set_trace(nsh_t* nsh, nsh_trace_t* trace) NSH_NON_NULL(1);
+#endif
+
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+/**
+ * @brief Set the handler running the foreground command lines whose command is not registered, null to report them.
+ *
+ * The handler gets the whole command line, the unknown command being argv[0].
+ * It returns NSH_STATUS_CMD_NOT_FOUND if it cannot run the command either.
+ */
+void nsh_set_command_not_found_handler(nsh_t* nsh, nsh_cmd_handler_t* handler) NSH_NON_NULL(1);
+#endif
+
+#if NSH_FEATURE_USE_REDIRECTION == 1
+/**
+ * @brief Replace the backend providing the files the output is redirected to, nsh_redirect_stdio_backend by default.
+ */
+void nsh_set_redirect_backend(nsh_t* nsh, const nsh_redirect_backend_t* backend) NSH_NON_NULL(1, 2);
+#endif
+
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+/**
+ * @brief Paint the free part of the stack the shell runs on, so that the "mem" builtin reports its peak usage.
+ *
+ * 'stack_limit' is the lowest address of the stack, which grows downward (the
+ * stack buffer given to the RTOS task for instance). Must be called from the
+ * thread running the shell, before nsh_run().
+ * Return NSH_STATUS_WRONG_ARG if the caller is not running on this stack.
+ */
+nsh_status_t nsh_set_stack(nsh_t* nsh, void* stack_limit, size_t stack_size) NSH_NON_NULL(1, 2);
+#endif
+
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+/**
+ * @brief Restore the history saved into 'storage', and save the new entries into it.
+ *
+ * 'storage' must outlive 'nsh'. New entries are saved by batches of
+ * NSH_HISTORY_LOG_BATCH_SIZE after the command execution, and when the shell exits.
+ */
+nsh_status_t nsh_set_history_storage(nsh_t* nsh, const nsh_history_storage_t* storage) NSH_NON_NULL(1, 2);
+#endif
+
+#if NSH_FEATURE_USE_JOBS == 1
+/**
+ * @brief Set the executor running the background jobs. 'executor' must outlive 'nsh'.
+ *
+ * Background handlers run concurrently with the shell, so they shall only use
+ * the I/O and the cancel token of their context.
+ */
+void nsh_set_executor(nsh_t* nsh, const nsh_executor_t* executor) NSH_NON_NULL(1, 2);
+#endif
+
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+/**
+ * @brief Queue a log line to be displayed above the line being edited, without blocking.
+ *
+ * May be called from any thread or interrupt handler. The message is copied,
+ * and displayed on its own line when the shell waits for input, the prompt
+ * and the typed characters being redrawn below it.
+ *
+ * @return NSH_STATUS_BUFFER_OVERFLOW if NSH_LOG_QUEUE_SIZE messages are already
+ * queued, the message being dropped.
+ */
+nsh_status_t nsh_log_async(nsh_t* nsh, const char* message) NSH_NON_NULL(1, 2);
+#endif
+
+/**
+ * @brief Run the shell until the exit command is executed or the input is exhausted.
+ *
+ * The background jobs still running on exit are cancelled, and waited for.
+ */
+void nsh_run(nsh_t* nsh) NSH_NON_NULL(1);
 
 #ifdef __cplusplus
 }
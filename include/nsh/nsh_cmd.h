@@ -3,16 +3,75 @@
 
 #include <nsh/nsh_common_defs.h>
 #include <nsh/nsh_config.h>
+#include <nsh/nsh_io_plugin.h>
+
+#include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef nsh_status_t nsh_cmd_handler_t(unsigned int, char**);
+struct nsh_s;
+
+/**
+ * @brief Clock giving the current time in milliseconds, wrapping around at UINT_MAX.
+ */
+typedef unsigned int nsh_clock_t(void);
+
+/**
+ * @brief Cooperative cancellation request of a running command, set by the shell and polled by the handler.
+ *
+ * The request is made explicitly (Ctrl-C, kill command...), or once the
+ * deadline of the token is reached.
+ */
+typedef struct nsh_cancel_token {
+    volatile bool cancelled;
+    bool timed_out;     ///< Cancelled because the deadline was reached
+    nsh_clock_t* clock; ///< Null if the token has no deadline
+    unsigned int deadline_ms;
+} nsh_cancel_token_t;
+
+/**
+ * @brief Context given to a command handler.
+ *
+ * Handlers shall only interact with the shell through this context, so that
+ * several shell instances can run concurrently.
+ */
+typedef struct nsh_cmd_ctx {
+    struct nsh_s* nsh;          ///< Shell executing the command
+    nsh_io_t* io;               ///< Input/output of the command
+    nsh_cancel_token_t* cancel; ///< Null if the command cannot be cancelled
+} nsh_cmd_ctx_t;
+
+typedef nsh_status_t nsh_cmd_handler_t(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
+
+#if NSH_FEATURE_USE_CMD_STATS == 1
+
+/**
+ * @brief Counter of CPU cycles, or of any other time unit, wrapping around at UINT32_MAX.
+ */
+typedef uint32_t nsh_cycle_counter_t(void);
+
+/**
+ * @brief Execution statistics of a command, the latencies being in cycle counter ticks.
+ */
+typedef struct nsh_cmd_stats {
+    uint32_t call_count;
+    uint32_t error_count; ///< Calls returning neither NSH_STATUS_OK nor NSH_STATUS_QUIT
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+} nsh_cmd_stats_t;
+
+#endif
 
 typedef struct nsh_cmd {
     nsh_cmd_handler_t* handler;
     char name[NSH_MAX_STRING_SIZE];
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    nsh_cmd_stats_t stats;
+#endif
 } nsh_cmd_t;
 
 nsh_status_t nsh_cmd_init_empty(nsh_cmd_t* cmd) NSH_NON_NULL(1);
@@ -23,6 +82,38 @@ void nsh_cmd_copy(nsh_cmd_t* dst, const nsh_cmd_t* src) NSH_NON_NULL(1, 2);
 
 void nsh_cmd_swap(nsh_cmd_t* cmd1, nsh_cmd_t* cmd2) NSH_NON_NULL(1, 2);
 
+#if NSH_FEATURE_USE_CMD_STATS == 1
+void nsh_cmd_stats_reset(nsh_cmd_stats_t* stats) NSH_NON_NULL(1);
+
+/**
+ * @brief Account for a call which lasted 'cycles', and failed if 'error' is true.
+ */
+void nsh_cmd_stats_record(nsh_cmd_stats_t* stats, uint32_t cycles, bool error) NSH_NON_NULL(1);
+#endif
+
+/**
+ * @brief Reset the token, expiring 'timeout_ms' after now if both 'clock' is not null and 'timeout_ms' is not 0.
+ */
+void nsh_cancel_token_init(nsh_cancel_token_t* token, nsh_clock_t* clock, unsigned int timeout_ms) NSH_NON_NULL(1);
+
+/**
+ * @brief Request the cancellation. May be called from another thread, an interrupt or a signal handler.
+ */
+void nsh_cancel_token_cancel(nsh_cancel_token_t* token) NSH_NON_NULL(1);
+
+/**
+ * @brief Return true if the cancellation was requested, or if the deadline is reached.
+ */
+bool nsh_cancel_token_is_cancelled(nsh_cancel_token_t* token) NSH_NON_NULL(1);
+
+/**
+ * @brief Return true if the command shall stop as soon as possible.
+ *
+ * Long-running handlers shall poll it regularly, and return NSH_STATUS_CANCELLED
+ * once it is true.
+ */
+bool nsh_cmd_is_cancelled(const nsh_cmd_ctx_t* ctx) NSH_NON_NULL(1);
+
 #ifdef __cplusplus
 }
 #endif
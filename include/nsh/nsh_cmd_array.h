@@ -10,10 +10,33 @@ extern "C" {
 #endif
 
 typedef struct nsh_cmd_array {
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+    nsh_cmd_t* array;
+    unsigned int capacity;
+#else
     nsh_cmd_t array[NSH_CMD_MAX_COUNT];
+#endif
     unsigned int count;
 } nsh_cmd_array_t;
 
+/**
+ * @def NSH_CMD_ARRAY_CAPACITY(<cmds>)
+ * @brief Maximum number of commands, a constant without NSH_FEATURE_USE_RUNTIME_LIMITS.
+ */
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+#define NSH_CMD_ARRAY_CAPACITY(cmds) ((cmds)->capacity)
+#else
+#define NSH_CMD_ARRAY_CAPACITY(cmds) NSH_CMD_MAX_COUNT
+#endif
+
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+/**
+ * @brief Give the 'capacity' commands of 'storage' to the array, before initializing it.
+ */
+void nsh_cmd_array_set_storage(nsh_cmd_array_t* cmds, nsh_cmd_t* storage, unsigned int capacity)
+    NSH_NON_NULL(1, 2);
+#endif
+
 nsh_status_t nsh_cmd_array_init(nsh_cmd_array_t* cmds)
     NSH_NON_NULL(1);
 
@@ -1,17 +1,74 @@
 #ifndef NSH_CMD_BUILTINS_H_
 #define NSH_CMD_BUILTINS_H_
 
+#include <nsh/nsh_cmd.h>
 #include <nsh/nsh_common_defs.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-nsh_status_t cmd_builtin_help(unsigned int argc, char** argv);
+nsh_status_t cmd_builtin_help(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
 
-nsh_status_t cmd_builtin_exit(unsigned int argc, char** argv);
+nsh_status_t cmd_builtin_exit(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
 
-nsh_status_t cmd_builtin_version(unsigned int argc, char** argv);
+nsh_status_t cmd_builtin_version(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
+
+#if NSH_FEATURE_USE_JOBS == 1
+
+/**
+ * @brief List the background jobs.
+ */
+nsh_status_t cmd_builtin_jobs(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
+
+/**
+ * @brief Wait for a background job ("fg [id]", the last started one by default), displaying its output.
+ *
+ * Once cancelled, stop waiting and leave the job in the background.
+ */
+nsh_status_t cmd_builtin_fg(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
+
+/**
+ * @brief Request a background job to stop ("kill <id>").
+ */
+nsh_status_t cmd_builtin_kill(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
+
+#endif
+
+#if NSH_FEATURE_USE_CMD_STATS == 1
+
+/**
+ * @brief Display the statistics of the commands called since the last reset, the most time-consuming first.
+ *
+ * "stats reset" clears the statistics.
+ */
+nsh_status_t cmd_builtin_stats(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
+
+#endif
+
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+
+/**
+ * @brief Display the peak usage and the remaining headroom of the buffers and of the stack of the shell.
+ */
+nsh_status_t cmd_builtin_mem(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
+
+#endif
+
+#if NSH_FEATURE_USE_SCRIPTS == 1
+
+/**
+ * @brief Compile and run the script made of the arguments ("script for i in 1..3; echo $i; end"), or run the
+ * last compiled script again if there is none.
+ *
+ * The script is split like any command line first. It thus fits on one line of
+ * NSH_LINE_BUFFER_SIZE bytes, with at most NSH_CMD_ARGS_MAX_COUNT - 1 words of
+ * at most NSH_MAX_STRING_SIZE - 1 characters each, a separate ';' being a word.
+ * Longer scripts can be compiled with nsh_script_compile().
+ */
+nsh_status_t cmd_builtin_script(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv);
+
+#endif
 
 #ifdef __cplusplus
 }
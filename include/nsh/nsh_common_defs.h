@@ -62,6 +62,43 @@
 #define NSH_RESTRICT restrict
 #endif
 
+/**
+ * @def NSH_ATOMIC_LOAD(<ptr>)
+ * @def NSH_ATOMIC_STORE(<ptr>, <value>)
+ * @brief Access a variable shared between threads (or an interrupt handler) without a lock.
+ *
+ * The store publishes all the writes made before it to the thread loading the
+ * stored value. Without GCC or Clang builtins, the variable shall be volatile
+ * and the target shall not reorder memory accesses (single-core MCU for instance).
+ */
+#if defined(__GNUC__) || defined(__GNUG__) || defined(__clang__)
+#define NSH_ATOMIC_LOAD(ptr)         __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define NSH_ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#else
+#define NSH_ATOMIC_LOAD(ptr)         (*(ptr))
+#define NSH_ATOMIC_STORE(ptr, value) ((void)(*(ptr) = (value)))
+#endif
+
+/**
+ * @def NSH_ATOMIC_COMPARE_EXCHANGE(<ptr>, <expected-ptr>, <desired>)
+ * @def NSH_ATOMIC_FETCH_ADD(<ptr>, <value>)
+ * @brief Read-modify-write a variable shared between several writers without a lock.
+ *
+ * The compare-exchange stores 'desired' and evaluates to true if the variable
+ * equals '*expected', else it copies the variable into '*expected' and
+ * evaluates to false. Without GCC or Clang builtins, the writers shall not
+ * preempt each other.
+ */
+#if defined(__GNUC__) || defined(__GNUG__) || defined(__clang__)
+#define NSH_ATOMIC_COMPARE_EXCHANGE(ptr, expected, desired) \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define NSH_ATOMIC_FETCH_ADD(ptr, value) __atomic_fetch_add((ptr), (value), __ATOMIC_ACQ_REL)
+#else
+#define NSH_ATOMIC_COMPARE_EXCHANGE(ptr, expected, desired) \
+    ((*(ptr) == *(expected)) ? ((*(ptr) = (desired)), true) : ((*(expected) = *(ptr)), false))
+#define NSH_ATOMIC_FETCH_ADD(ptr, value) ((*(ptr) += (value)) - (value))
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -81,6 +118,8 @@ typedef enum nsh_status {
     NSH_STATUS_CMD_NOT_FOUND,     ///< The entered command was not found
     NSH_STATUS_MAX_CMD_NB_REACH,  ///< The maximum number of commands was registered
     NSH_STATUS_MAX_ARGS_NB_REACH, ///< The maximum number of arguments was entered
+    NSH_STATUS_PENDING,           ///< The operation was started and will complete asynchronously
+    NSH_STATUS_CANCELLED,         ///< The operation was interrupted (Ctrl-C) or timed out
 } nsh_status_t;
 
 #ifdef __cplusplus
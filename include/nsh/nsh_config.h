@@ -44,15 +44,48 @@
 #endif
 
 /*
- * Maximum number of command memorized into the history.
- * If you exceed this number, oldest commands will be overwritten by recent
- * ones.
- * NB: this history takes NSH_CMD_HISTORY_SIZE*NSH_LINE_BUFFER_SIZE bytes
- * in BSS region, which can be pretty huge...
+ * Number of bytes reserved to memorize the commands into the history.
+ * Each command takes its own length plus a few bytes of bookkeeping (2 bytes,
+ * or 6 bytes with NSH_FEATURE_USE_HISTORY_SEARCH), so short commands are
+ * packed together. If the history is full, oldest commands are dropped until
+ * the new one fits.
+ * Must be able to hold at least one command of NSH_LINE_BUFFER_SIZE bytes.
  * Requires: NSH_FEATURE_USE_HISTORY == 1
  */
 #ifndef NSH_CMD_HISTORY_SIZE
-#define NSH_CMD_HISTORY_SIZE 16u
+#define NSH_CMD_HISTORY_SIZE 2048u
+#endif
+
+/*
+ * Take the line buffer size, the maximum numbers of commands and arguments,
+ * and the history size at runtime from nsh_init_with_arena(), which carves the
+ * corresponding tables out of a buffer given by the caller. A single library
+ * binary can then be shipped to targets with different RAM budgets.
+ * When disabled, the tables are fixed-size arrays of nsh_t sized by the macros
+ * above, and nsh_init() is used instead.
+ */
+#ifndef NSH_FEATURE_USE_RUNTIME_LIMITS
+#define NSH_FEATURE_USE_RUNTIME_LIMITS 0
+#endif
+
+/*
+ * Number of history entries matching the typed line that are remembered when
+ * navigating through the history with arrow keys. Older matches are still
+ * reachable, but are found by scanning the history at each keypress.
+ * Requires: NSH_FEATURE_USE_HISTORY == 1
+ */
+#ifndef NSH_HISTORY_CANDIDATE_CACHE_SIZE
+#define NSH_HISTORY_CANDIDATE_CACHE_SIZE 16u
+#endif
+
+/*
+ * Number of new history entries kept in RAM before being appended to the
+ * history storage. Entries are written after the command execution, and on
+ * exit, never while a line is being typed.
+ * Requires: NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+ */
+#ifndef NSH_HISTORY_LOG_BATCH_SIZE
+#define NSH_HISTORY_LOG_BATCH_SIZE 4u
 #endif
 
 /*
@@ -62,6 +95,40 @@
 #define NSH_DEFAULT_PROMPT "> "
 #endif
 
+/*
+ * Default time a command may run before being cancelled, in milliseconds, or 0
+ * to let commands run until they complete. Only used once a clock is given
+ * with nsh_set_clock(), see nsh_set_command_timeout().
+ */
+#ifndef NSH_DEFAULT_COMMAND_TIMEOUT_MS
+#define NSH_DEFAULT_COMMAND_TIMEOUT_MS 0u
+#endif
+
+/*
+ * Size of the output buffer of each shell instance, in bytes.
+ * The output is written to the I/O backend when the buffer is full, and before
+ * waiting for input.
+ */
+#ifndef NSH_IO_OUTPUT_BUFFER_SIZE
+#define NSH_IO_OUTPUT_BUFFER_SIZE 64u
+#endif
+
+/*
+ * Capacity of the receive rings (see nsh_rx_ring.h) buffering the input bytes
+ * between an interrupt handler and the shell, in bytes. Must be a power of two.
+ */
+#ifndef NSH_RX_RING_SIZE
+#define NSH_RX_RING_SIZE 256u
+#endif
+
+/*
+ * Size of each of the two transmit buffers of the DMA I/O backend (see
+ * nsh_io_dma.h), in bytes. Writing blocks only when both buffers are full.
+ */
+#ifndef NSH_IO_DMA_TX_BUFFER_SIZE
+#define NSH_IO_DMA_TX_BUFFER_SIZE 128u
+#endif
+
 /*
  * Allow command auto-completion using tabulation key.
  */
@@ -77,6 +144,219 @@
 #define NSH_FEATURE_USE_HISTORY 1
 #endif
 
+/*
+ * Allow incremental reverse search through the history using Ctrl-R.
+ * Each history entry is indexed by a 32-bit character presence bitmap, so that
+ * entries which cannot match the searched pattern are skipped without being
+ * scanned.
+ * Requires: NSH_FEATURE_USE_HISTORY == 1
+ */
+#ifndef NSH_FEATURE_USE_HISTORY_SEARCH
+#define NSH_FEATURE_USE_HISTORY_SEARCH 1
+#endif
+
+/*
+ * Allow the history to be saved into an append-only log (a file, a Flash
+ * sector...) and restored at startup. See nsh_set_history_storage().
+ * Requires: NSH_FEATURE_USE_HISTORY == 1
+ */
+#ifndef NSH_FEATURE_USE_HISTORY_PERSISTENCE
+#define NSH_FEATURE_USE_HISTORY_PERSISTENCE 0
+#endif
+
+/*
+ * Allow running commands in the background with a trailing '&', and provide
+ * the jobs, fg and kill commands. The jobs are run by an executor given with
+ * nsh_set_executor(), and their output is displayed between two keystrokes.
+ */
+#ifndef NSH_FEATURE_USE_JOBS
+#define NSH_FEATURE_USE_JOBS 0
+#endif
+
+/*
+ * Maximum number of background jobs running at the same time.
+ * Requires: NSH_FEATURE_USE_JOBS == 1
+ */
+#ifndef NSH_JOB_MAX_COUNT
+#define NSH_JOB_MAX_COUNT 4u
+#endif
+
+/*
+ * Size of the buffer holding the output of a background job until it is
+ * displayed, in bytes. Further output is dropped.
+ * Requires: NSH_FEATURE_USE_JOBS == 1
+ */
+#ifndef NSH_JOB_OUTPUT_BUFFER_SIZE
+#define NSH_JOB_OUTPUT_BUFFER_SIZE 256u
+#endif
+
+/*
+ * Allow other threads or interrupt handlers to log messages with
+ * nsh_log_async() without blocking. The messages are queued, and displayed
+ * above the line being edited when the shell waits for input.
+ */
+#ifndef NSH_FEATURE_USE_ASYNC_LOG
+#define NSH_FEATURE_USE_ASYNC_LOG 0
+#endif
+
+/*
+ * Maximum number of log messages queued until they are displayed. Further
+ * messages are dropped and counted. Must be a power of two.
+ * Requires: NSH_FEATURE_USE_ASYNC_LOG == 1
+ */
+#ifndef NSH_LOG_QUEUE_SIZE
+#define NSH_LOG_QUEUE_SIZE 8u
+#endif
+
+/*
+ * Maximum size of a log message, in bytes. Longer messages are truncated.
+ * Requires: NSH_FEATURE_USE_ASYNC_LOG == 1
+ */
+#ifndef NSH_LOG_MESSAGE_SIZE
+#define NSH_LOG_MESSAGE_SIZE 80u
+#endif
+
+/*
+ * Period at which the queued log messages are displayed while the shell waits
+ * for input, in milliseconds. Only used if the I/O backend can wait with a
+ * timeout, otherwise the messages are displayed between two keystrokes.
+ * Requires: NSH_FEATURE_USE_ASYNC_LOG == 1
+ */
+#ifndef NSH_LOG_POLL_PERIOD_MS
+#define NSH_LOG_POLL_PERIOD_MS 50u
+#endif
+
+/*
+ * Record the number of calls, the number of errors and the latency of each
+ * command, displayed by the "stats" builtin. The latency is measured with the
+ * counter given to nsh_set_cycle_counter().
+ */
+#ifndef NSH_FEATURE_USE_CMD_STATS
+#define NSH_FEATURE_USE_CMD_STATS 0
+#endif
+
+/*
+ * Record the time spent in each phase of the processing of a line (waiting
+ * for input, echo, split, lookup, handler, output flush) into a ring buffer
+ * given to the shell with nsh_set_trace(), the trace points compiling to
+ * nothing when disabled. See nsh_trace.h.
+ */
+#ifndef NSH_FEATURE_USE_TRACE
+#define NSH_FEATURE_USE_TRACE 0
+#endif
+
+/*
+ * Number of trace records kept, the oldest being overwritten. Must be a power of two.
+ * Requires: NSH_FEATURE_USE_TRACE == 1
+ */
+#ifndef NSH_TRACE_RING_SIZE
+#define NSH_TRACE_RING_SIZE 256u
+#endif
+
+/*
+ * Paint the line buffer, the history ring, the output buffer and the stack of
+ * the shell with a pattern, the "mem" builtin reporting the peak usage of each
+ * one and its remaining headroom. See nsh_mem.h.
+ */
+#ifndef NSH_FEATURE_USE_HIGH_WATER_MARKS
+#define NSH_FEATURE_USE_HIGH_WATER_MARKS 0
+#endif
+
+/*
+ * Run the command lines whose command is not registered with the handler given
+ * to nsh_set_command_not_found_handler(), for instance nsh_posix_spawn_command()
+ * launching a program from the PATH on native builds.
+ */
+#ifndef NSH_FEATURE_USE_EXTERNAL_COMMANDS
+#define NSH_FEATURE_USE_EXTERNAL_COMMANDS 0
+#endif
+
+/*
+ * Allow piping the output of a command into filters with '|', for instance
+ * "dump | grep ERR | head -n 5". The filters grep, head, wc and hex run on the
+ * output as it is flushed, so that only their own output reaches the terminal.
+ */
+#ifndef NSH_FEATURE_USE_PIPES
+#define NSH_FEATURE_USE_PIPES 0
+#endif
+
+/*
+ * Maximum number of filters following a command in a pipeline.
+ * Requires: NSH_FEATURE_USE_PIPES == 1
+ */
+#ifndef NSH_PIPE_MAX_FILTERS
+#define NSH_PIPE_MAX_FILTERS 2u
+#endif
+
+/*
+ * Size of the line buffer of the line-oriented filters (grep), in bytes.
+ * Longer lines are filtered as several lines.
+ * Requires: NSH_FEATURE_USE_PIPES == 1
+ */
+#ifndef NSH_PIPE_LINE_SIZE
+#define NSH_PIPE_LINE_SIZE 80u
+#endif
+
+/*
+ * Allow redirecting the output of a command into a file with "> file", or
+ * appending it to a file with ">> file". The files are provided by the backend
+ * given to nsh_set_redirect_backend(), stdio files by default.
+ */
+#ifndef NSH_FEATURE_USE_REDIRECTION
+#define NSH_FEATURE_USE_REDIRECTION 0
+#endif
+
+/*
+ * Allow running scripts with variables, if, for and while, compiled once into
+ * bytecode calling the command handlers directly, and provide the script
+ * command compiling and running the script given on its command line.
+ */
+#ifndef NSH_FEATURE_USE_SCRIPTS
+#define NSH_FEATURE_USE_SCRIPTS 0
+#endif
+
+/*
+ * Maximum number of bytecode instructions of a compiled script, one being kept
+ * for its end. A command call or a let takes one instruction, an if with an
+ * else or a while two, and a for loop four.
+ * Requires: NSH_FEATURE_USE_SCRIPTS == 1
+ */
+#ifndef NSH_SCRIPT_MAX_INSTRUCTIONS
+#define NSH_SCRIPT_MAX_INSTRUCTIONS 32u
+#endif
+
+/*
+ * Maximum number of command arguments of a compiled script, command names included.
+ * Requires: NSH_FEATURE_USE_SCRIPTS == 1
+ */
+#ifndef NSH_SCRIPT_MAX_ARGS
+#define NSH_SCRIPT_MAX_ARGS 32u
+#endif
+
+/*
+ * Size of the buffer holding the command arguments of a compiled script, in bytes, at most 65536.
+ * Requires: NSH_FEATURE_USE_SCRIPTS == 1
+ */
+#ifndef NSH_SCRIPT_STRING_POOL_SIZE
+#define NSH_SCRIPT_STRING_POOL_SIZE 256u
+#endif
+
+/*
+ * Maximum number of variables of a script, including one per for loop holding its upper bound.
+ * Requires: NSH_FEATURE_USE_SCRIPTS == 1
+ */
+#ifndef NSH_SCRIPT_MAX_VARIABLES
+#define NSH_SCRIPT_MAX_VARIABLES 8u
+#endif
+
+/*
+ * Maximum nesting depth of the if, for and while blocks of a script.
+ * Requires: NSH_FEATURE_USE_SCRIPTS == 1
+ */
+#ifndef NSH_SCRIPT_MAX_DEPTH
+#define NSH_SCRIPT_MAX_DEPTH 4u
+#endif
+
 /*
  * Define a printf-like function, which can be resource hungry...
  */
@@ -105,6 +385,47 @@
 #define NSH_FEATURE_USE_RETURN_CODE_PRINTING 0
 #endif
 
+/*
+ * The output buffer must be able to hold at least one character.
+ */
+#if NSH_IO_OUTPUT_BUFFER_SIZE == 0
+#error "NSH_IO_OUTPUT_BUFFER_SIZE cannot be 0"
+#endif
+
+/*
+ * The receive ring indexes are wrapped with a mask.
+ */
+#if NSH_RX_RING_SIZE == 0 || (NSH_RX_RING_SIZE & (NSH_RX_RING_SIZE - 1u)) != 0
+#error "NSH_RX_RING_SIZE must be a power of two"
+#endif
+
+/*
+ * The log queue indexes are wrapped with a mask.
+ */
+#if NSH_LOG_QUEUE_SIZE == 0 || (NSH_LOG_QUEUE_SIZE & (NSH_LOG_QUEUE_SIZE - 1u)) != 0
+#error "NSH_LOG_QUEUE_SIZE must be a power of two"
+#endif
+
+/*
+ * The trace ring index is wrapped with a mask.
+ */
+#if NSH_TRACE_RING_SIZE == 0 || (NSH_TRACE_RING_SIZE & (NSH_TRACE_RING_SIZE - 1u)) != 0
+#error "NSH_TRACE_RING_SIZE must be a power of two"
+#endif
+
+/*
+ * History entries store their size in a single byte, and the history must be
+ * able to hold the longest possible entry.
+ */
+#if NSH_FEATURE_USE_HISTORY == 1
+#if NSH_LINE_BUFFER_SIZE > 256u
+#error "NSH_LINE_BUFFER_SIZE cannot exceed 256 when NSH_FEATURE_USE_HISTORY == 1"
+#endif
+#if NSH_CMD_HISTORY_SIZE < NSH_LINE_BUFFER_SIZE + 5u
+#error "NSH_CMD_HISTORY_SIZE is too small to hold an entry of NSH_LINE_BUFFER_SIZE bytes"
+#endif
+#endif
+
 /*
  * Undef NSH_CMD_HISTORY_SIZE if NSH_FEATURE_USE_HISTORY == 0,
  * this symbol should not be used if the history is not used.
@@ -113,4 +434,22 @@
 #undef NSH_CMD_HISTORY_SIZE
 #endif
 
+/*
+ * Overwrite NSH_FEATURE_USE_HISTORY_SEARCH to 0 if
+ * NSH_FEATURE_USE_HISTORY == 0.
+ */
+#if NSH_FEATURE_USE_HISTORY == 0
+#undef NSH_FEATURE_USE_HISTORY_SEARCH
+#define NSH_FEATURE_USE_HISTORY_SEARCH 0
+#endif
+
+/*
+ * Overwrite NSH_FEATURE_USE_HISTORY_PERSISTENCE to 0 if
+ * NSH_FEATURE_USE_HISTORY == 0.
+ */
+#if NSH_FEATURE_USE_HISTORY == 0
+#undef NSH_FEATURE_USE_HISTORY_PERSISTENCE
+#define NSH_FEATURE_USE_HISTORY_PERSISTENCE 0
+#endif
+
 #endif // NSH_CONFIG_H_
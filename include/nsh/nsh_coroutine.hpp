@@ -0,0 +1,563 @@
+#ifndef NSH_COROUTINE_HPP_
+#define NSH_COROUTINE_HPP_
+
+/*
+ * Optional C++20 layer running command handlers as coroutines.
+ *
+ * A coroutine handler returns nsh::Task<nsh_status_t>, and co_awaits nsh::sleep_for()
+ * or nsh::wait_until() instead of blocking. When nsh::CoroutineExecutor is the
+ * executor of the shell, the background coroutine handlers are all resumed from
+ * the shell thread while it waits for input, so that many long-running commands
+ * progress concurrently without one stack per command.
+ *
+ * Example:
+ *
+ *     nsh::Task<nsh_status_t> cmd_blink(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+ *     {
+ *         while (co_await nsh::sleep_for(std::chrono::milliseconds(500))) {
+ *             toggle_led();
+ *         }
+ *         co_return NSH_STATUS_OK; // Cancelled
+ *     }
+ *
+ *     nsh::CoroutineExecutor executor;
+ *     nsh_set_executor(&nsh, executor.executor());
+ *     nsh_register_command(&nsh, "blink", nsh::coroutine_handler<cmd_blink>);
+ */
+
+#include <nsh/nsh.h>
+
+#if NSH_FEATURE_USE_JOBS == 1 && defined(__cpp_impl_coroutine)
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace nsh {
+
+template <typename T>
+class Task;
+
+class CoroutineExecutor;
+
+namespace detail {
+
+enum class WakeReason {
+    Ready,     ///< The awaited condition is satisfied
+    Timeout,   ///< The deadline was reached first
+    Cancelled, ///< The command was cancelled first
+};
+
+/*
+ * A command in progress: its outermost coroutine, and what its innermost
+ * suspended coroutine waits for.
+ */
+struct Fiber {
+    nsh_cmd_ctx_t* ctx = nullptr;
+    std::coroutine_handle<> root;
+    std::chrono::milliseconds (*now)() = nullptr;
+
+    std::coroutine_handle<> waiting; ///< Null if not suspended
+    bool (*ready)(void* arg) = nullptr;
+    void* ready_arg = nullptr;
+    bool timed = false;
+    std::chrono::milliseconds deadline {};
+    WakeReason reason = WakeReason::Ready;
+
+    void suspend(std::coroutine_handle<> handle, bool (*ready_fn)(void*), void* arg) noexcept
+    {
+        waiting = handle;
+        ready = ready_fn;
+        ready_arg = arg;
+        timed = false;
+    }
+
+    void suspend(std::coroutine_handle<> handle, bool (*ready_fn)(void*), void* arg,
+        std::chrono::milliseconds timeout) noexcept
+    {
+        suspend(handle, ready_fn, arg);
+        timed = true;
+        deadline = now() + timeout;
+    }
+
+    // Resume the suspended coroutine if it can progress, and return true if it was resumed
+    bool wake_if_ready()
+    {
+        if (!waiting) {
+            return false;
+        }
+        if (nsh_cmd_is_cancelled(ctx)) {
+            reason = WakeReason::Cancelled;
+        } else if (ready != nullptr && ready(ready_arg)) {
+            reason = WakeReason::Ready;
+        } else if (timed && now() >= deadline) {
+            reason = WakeReason::Timeout;
+        } else {
+            return false;
+        }
+        std::exchange(waiting, nullptr).resume();
+        return true;
+    }
+
+    // Delay before the suspended coroutine may be resumed, a predicate being checked every 'poll_period'
+    std::chrono::milliseconds delay(std::chrono::milliseconds poll_period) const
+    {
+        std::chrono::milliseconds result = std::chrono::milliseconds::max();
+        if (waiting && ready != nullptr) {
+            result = poll_period;
+        }
+        if (waiting && timed) {
+            std::chrono::milliseconds remaining = deadline - now();
+            if (remaining < std::chrono::milliseconds::zero()) {
+                remaining = std::chrono::milliseconds::zero();
+            }
+            result = std::min(result, remaining);
+        }
+        return result;
+    }
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation; ///< Coroutine awaiting this one, null for the outermost one
+    Fiber* fiber = nullptr;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept { }
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() const noexcept { std::terminate(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    T value {};
+
+    Task<T> get_return_object() noexcept;
+    void return_value(T result) { value = std::move(result); }
+    T result() { return std::move(value); }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept { }
+    void result() const noexcept { }
+};
+
+} // namespace detail
+
+/**
+ * @brief Coroutine started when awaited, or when returned by a handler given to nsh::coroutine_handler.
+ */
+template <typename T = void>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit Task(handle_type handle) noexcept
+        : m_handle(handle)
+    {
+    }
+
+    Task(Task&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, nullptr))
+    {
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { destroy(); }
+
+    bool done() const noexcept { return !m_handle || m_handle.done(); }
+
+    class Awaiter {
+    public:
+        explicit Awaiter(handle_type handle) noexcept
+            : m_handle(handle)
+        {
+        }
+
+        bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> caller) noexcept
+        {
+            m_handle.promise().continuation = caller;
+            m_handle.promise().fiber = caller.promise().fiber;
+            return m_handle;
+        }
+
+        T await_resume() { return m_handle.promise().result(); }
+
+    private:
+        handle_type m_handle;
+    };
+
+    /**
+     * @brief Run the task until it completes, the awaiting coroutine being suspended meanwhile.
+     */
+    Awaiter operator co_await() && noexcept { return Awaiter(m_handle); }
+
+private:
+    friend class CoroutineExecutor;
+
+    handle_type release() noexcept { return std::exchange(m_handle, nullptr); }
+
+    void destroy() noexcept
+    {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+    handle_type m_handle;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept
+{
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept
+{
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+/**
+ * @brief Awaitable returned by nsh::sleep_for().
+ */
+class SleepFor {
+public:
+    explicit SleepFor(std::chrono::milliseconds delay) noexcept
+        : m_delay(delay)
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) noexcept
+    {
+        m_fiber = handle.promise().fiber;
+        m_fiber->suspend(handle, nullptr, nullptr, m_delay);
+    }
+
+    bool await_resume() const noexcept { return m_fiber->reason != detail::WakeReason::Cancelled; }
+
+private:
+    std::chrono::milliseconds m_delay;
+    detail::Fiber* m_fiber = nullptr;
+};
+
+/**
+ * @brief Awaitable returned by nsh::wait_until().
+ */
+template <typename Predicate>
+class WaitUntil {
+public:
+    WaitUntil(Predicate predicate, std::chrono::milliseconds timeout, bool timed)
+        : m_predicate(std::move(predicate))
+        , m_timeout(timeout)
+        , m_timed(timed)
+    {
+    }
+
+    bool await_ready()
+    {
+        m_ready = m_predicate();
+        return m_ready;
+    }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) noexcept
+    {
+        detail::Fiber* fiber = handle.promise().fiber;
+        if (m_timed) {
+            fiber->suspend(handle, &WaitUntil::check, this, m_timeout);
+        } else {
+            fiber->suspend(handle, &WaitUntil::check, this);
+        }
+        m_fiber = fiber;
+    }
+
+    bool await_resume() const noexcept { return m_ready || m_fiber->reason == detail::WakeReason::Ready; }
+
+private:
+    static bool check(void* self) { return static_cast<WaitUntil*>(self)->m_predicate(); }
+
+    Predicate m_predicate;
+    std::chrono::milliseconds m_timeout;
+    bool m_timed;
+    bool m_ready = false;
+    detail::Fiber* m_fiber = nullptr;
+};
+
+/**
+ * @brief Suspend the coroutine for 'delay' (at least one executor iteration if zero).
+ * @return false if the command was cancelled first.
+ */
+inline SleepFor sleep_for(std::chrono::milliseconds delay) noexcept
+{
+    return SleepFor(delay);
+}
+
+/**
+ * @brief Suspend the coroutine until 'predicate()' returns true (a peripheral ready, some input available...).
+ *
+ * The predicate is checked every time the executor polls, so it shall be cheap and non-blocking.
+ * @return false if the command was cancelled first.
+ */
+template <typename Predicate>
+WaitUntil<std::decay_t<Predicate>> wait_until(Predicate&& predicate)
+{
+    return WaitUntil<std::decay_t<Predicate>>(std::forward<Predicate>(predicate), {}, false);
+}
+
+/**
+ * @brief Same as wait_until(predicate), but giving up after 'timeout'.
+ * @return false if the command was cancelled or the timeout expired first.
+ */
+template <typename Predicate>
+WaitUntil<std::decay_t<Predicate>> wait_until(Predicate&& predicate, std::chrono::milliseconds timeout)
+{
+    return WaitUntil<std::decay_t<Predicate>>(std::forward<Predicate>(predicate), timeout, true);
+}
+
+/**
+ * @brief Executor of background jobs resuming the coroutine handlers from the shell thread.
+ *
+ * The coroutine frames are allocated with operator new. Other handlers started
+ * in the background run to completion in nsh_job_start(), blocking the shell.
+ */
+class CoroutineExecutor {
+public:
+    using Clock = std::chrono::milliseconds (*)();
+    using Idle = void (*)(std::chrono::milliseconds delay);
+
+    static std::chrono::milliseconds steady_clock_now()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch());
+    }
+
+    /**
+     * @param now Monotonic clock of the timers
+     * @param idle Called to wait while no coroutine can progress, if not null (busy-waiting otherwise)
+     * @param poll_period Period at which the conditions given to nsh::wait_until() are checked
+     */
+    explicit CoroutineExecutor(Clock now = &steady_clock_now, Idle idle = nullptr,
+        std::chrono::milliseconds poll_period = std::chrono::milliseconds(10)) noexcept
+        : m_now(now)
+        , m_idle(idle)
+        , m_poll_period(poll_period)
+    {
+        m_executor.submit = &CoroutineExecutor::submit;
+        m_executor.lock = &CoroutineExecutor::lock;
+        m_executor.unlock = &CoroutineExecutor::unlock;
+        m_executor.yield = &CoroutineExecutor::yield;
+        m_executor.poll = &CoroutineExecutor::poll;
+        m_executor.ctx = this;
+    }
+
+    CoroutineExecutor(const CoroutineExecutor&) = delete;
+    CoroutineExecutor& operator=(const CoroutineExecutor&) = delete;
+
+    ~CoroutineExecutor()
+    {
+        for (detail::Fiber& fiber : m_fibers) {
+            if (fiber.root) {
+                fiber.root.destroy();
+            }
+        }
+    }
+
+    /**
+     * @brief Interface to give to nsh_set_executor().
+     */
+    const nsh_executor_t* executor() const noexcept { return &m_executor; }
+
+    /**
+     * @brief Return the coroutine executor of the shell running the command, or null if it has another executor.
+     */
+    static CoroutineExecutor* from(const nsh_cmd_ctx_t* ctx) noexcept
+    {
+        const nsh_executor_t* executor = ctx->nsh->jobs.executor;
+        if (executor == nullptr || executor->submit != &CoroutineExecutor::submit) {
+            return nullptr;
+        }
+        return static_cast<CoroutineExecutor*>(executor->ctx);
+    }
+
+    /*
+     * Run the task as the handler of the command 'ctx': in the background if it
+     * is being started by this executor, until completion otherwise.
+     */
+    static nsh_status_t run(CoroutineExecutor* executor, nsh_cmd_ctx_t* ctx, Task<nsh_status_t> task)
+    {
+        if (executor != nullptr && executor->m_starting != nullptr && executor->m_starting->ctx == ctx) {
+            return executor->start(*executor->m_starting, std::move(task));
+        }
+
+        // The task keeps owning the coroutine, only read through a handle known not to be null
+        Task<nsh_status_t>::handle_type handle = task.m_handle;
+        if (!handle) {
+            return NSH_STATUS_FAILURE;
+        }
+        detail::Fiber fiber;
+        fiber.ctx = ctx;
+        fiber.now = (executor != nullptr) ? executor->m_now : &steady_clock_now;
+        fiber.root = handle;
+        handle.promise().fiber = &fiber;
+        handle.resume();
+        while (!handle.done()) {
+            if (fiber.wake_if_ready()) {
+                continue;
+            }
+            // Let the background coroutines progress meanwhile
+            if (executor != nullptr) {
+                std::chrono::milliseconds delay = std::min(executor->step(), fiber.delay(executor->m_poll_period));
+                executor->wait_idle(delay);
+            }
+        }
+        return handle.promise().result();
+    }
+
+private:
+    nsh_status_t start(detail::Fiber& fiber, Task<nsh_status_t> task)
+    {
+        Task<nsh_status_t>::handle_type handle = task.release();
+        handle.promise().fiber = &fiber;
+        fiber.root = handle;
+        fiber.now = m_now;
+        handle.resume();
+        if (!handle.done()) {
+            return NSH_STATUS_PENDING;
+        }
+        nsh_status_t status = handle.promise().result();
+        handle.destroy();
+        fiber = detail::Fiber {};
+        return status;
+    }
+
+    // Resume the coroutines ready to progress, and return the delay before the next step is needed
+    std::chrono::milliseconds step()
+    {
+        std::chrono::milliseconds delay = std::chrono::milliseconds::max();
+        for (detail::Fiber& fiber : m_fibers) {
+            if (!fiber.root) {
+                continue;
+            }
+            fiber.wake_if_ready();
+            if (fiber.root.done()) {
+                auto handle = std::coroutine_handle<detail::Promise<nsh_status_t>>::from_address(fiber.root.address());
+                nsh_status_t status = handle.promise().result();
+                nsh_cmd_ctx_t* ctx = fiber.ctx;
+                handle.destroy();
+                fiber = detail::Fiber {};
+                nsh_job_complete(ctx, status);
+                continue;
+            }
+            delay = std::min(delay, fiber.delay(m_poll_period));
+        }
+        return delay;
+    }
+
+    void wait_idle(std::chrono::milliseconds delay)
+    {
+        if (m_idle != nullptr && delay > std::chrono::milliseconds::zero()) {
+            m_idle(std::min(delay, m_poll_period));
+        }
+    }
+
+    static nsh_status_t submit(void* ctx, void (*task)(void* arg), void* arg)
+    {
+        CoroutineExecutor* self = static_cast<CoroutineExecutor*>(ctx);
+        for (detail::Fiber& fiber : self->m_fibers) {
+            if (!fiber.root) {
+                // 'arg' is the job, whose handler gives its coroutine to start() through m_starting
+                fiber.ctx = &static_cast<nsh_job_t*>(arg)->ctx;
+                self->m_starting = &fiber;
+                task(arg);
+                self->m_starting = nullptr;
+                if (!fiber.root) {
+                    fiber = detail::Fiber {};
+                }
+                return NSH_STATUS_OK;
+            }
+        }
+        return NSH_STATUS_FAILURE;
+    }
+
+    // All the coroutines run on the shell thread
+    static void lock(void*) { }
+    static void unlock(void*) { }
+
+    static void yield(void* ctx)
+    {
+        CoroutineExecutor* self = static_cast<CoroutineExecutor*>(ctx);
+        self->wait_idle(self->step());
+    }
+
+    static unsigned int poll(void* ctx)
+    {
+        std::chrono::milliseconds delay = static_cast<CoroutineExecutor*>(ctx)->step();
+        if (delay >= std::chrono::milliseconds(NSH_IO_WAIT_FOREVER)) {
+            return NSH_IO_WAIT_FOREVER;
+        }
+        return static_cast<unsigned int>(delay.count());
+    }
+
+    nsh_executor_t m_executor {};
+    Clock m_now;
+    Idle m_idle;
+    std::chrono::milliseconds m_poll_period;
+    std::array<detail::Fiber, NSH_JOB_MAX_COUNT> m_fibers {};
+    detail::Fiber* m_starting = nullptr;
+};
+
+/**
+ * @brief Adapt a coroutine handler to nsh_cmd_handler_t, to register it with nsh_register_command().
+ */
+template <Task<nsh_status_t> (*Handler)(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)>
+nsh_status_t coroutine_handler(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    return CoroutineExecutor::run(CoroutineExecutor::from(ctx), ctx, Handler(ctx, argc, argv));
+}
+
+} // namespace nsh
+
+#endif // NSH_FEATURE_USE_JOBS == 1 && defined(__cpp_impl_coroutine)
+
+#endif // NSH_COROUTINE_HPP_
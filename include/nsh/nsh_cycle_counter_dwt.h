@@ -0,0 +1,49 @@
+#ifndef NSH_CYCLE_COUNTER_DWT_H_
+#define NSH_CYCLE_COUNTER_DWT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cycle counter of the Data Watchpoint and Trace unit of the Cortex-M3/M4/M7
+ * cores, counting the core clock cycles. Give nsh_dwt_cycle_counter() to
+ * nsh_set_cycle_counter() with the core clock frequency (SystemCoreClock with
+ * CMSIS) to measure the latency of the commands.
+ *
+ * The functions are defined inline so that the Nsh library does not depend on
+ * the core it runs on.
+ */
+
+#define NSH_DWT_DEMCR (*(volatile uint32_t*)0xE000EDFCu)
+#define NSH_DWT_CTRL (*(volatile uint32_t*)0xE0001000u)
+#define NSH_DWT_CYCCNT (*(volatile uint32_t*)0xE0001004u)
+
+#define NSH_DWT_DEMCR_TRCENA (1u << 24)
+#define NSH_DWT_CTRL_CYCCNTENA (1u << 0)
+
+/**
+ * @brief Enable the trace unit and start the cycle counter from 0.
+ */
+static inline void nsh_dwt_cycle_counter_enable(void)
+{
+    NSH_DWT_DEMCR |= NSH_DWT_DEMCR_TRCENA;
+    NSH_DWT_CYCCNT = 0;
+    NSH_DWT_CTRL |= NSH_DWT_CTRL_CYCCNTENA;
+}
+
+/**
+ * @brief Number of core clock cycles since nsh_dwt_cycle_counter_enable(), wrapping around at UINT32_MAX.
+ */
+static inline uint32_t nsh_dwt_cycle_counter(void)
+{
+    return NSH_DWT_CYCCNT;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_CYCLE_COUNTER_DWT_H_
@@ -0,0 +1,47 @@
+#ifndef NSH_EXECUTOR_POSIX_H_
+#define NSH_EXECUTOR_POSIX_H_
+
+#include <nsh/nsh_job.h>
+
+#if NSH_FEATURE_USE_JOBS == 1
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Pool of NSH_JOB_MAX_COUNT POSIX threads running the background jobs.
+ */
+typedef struct nsh_posix_executor {
+    nsh_executor_t executor; ///< Interface to give to nsh_set_executor()
+    pthread_t workers[NSH_JOB_MAX_COUNT];
+    unsigned int worker_count;
+    pthread_mutex_t queue_mutex;
+    pthread_cond_t queue_not_empty;
+    struct {
+        void (*task)(void* arg);
+        void* arg;
+    } queue[NSH_JOB_MAX_COUNT];
+    unsigned int queue_head;
+    unsigned int queue_count;
+    bool stopping;
+    pthread_mutex_t jobs_mutex;
+} nsh_posix_executor_t;
+
+nsh_status_t nsh_posix_executor_init(nsh_posix_executor_t* pool) NSH_NON_NULL(1);
+
+/**
+ * @brief Wait for the submitted tasks to complete, then stop the workers.
+ */
+void nsh_posix_executor_destroy(nsh_posix_executor_t* pool) NSH_NON_NULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_JOBS == 1
+
+#endif // NSH_EXECUTOR_POSIX_H_
@@ -8,6 +8,7 @@
 
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,13 +16,59 @@ extern "C" {
 
 #define NSH_HISTORY_INVALID_ENTRY UINT_MAX
 
+/*
+ * Each entry is stored in the ring as a record:
+ *   [size (1 byte)][signature (4 bytes, search only)][characters (size bytes)][size (1 byte)]
+ * The leading size allows stepping to the next entry and the trailing one
+ * allows stepping to the previous entry, both in O(1).
+ */
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+#define NSH_HISTORY_ENTRY_HEADER_SIZE 5u
+#else
+#define NSH_HISTORY_ENTRY_HEADER_SIZE 1u
+#endif
+#define NSH_HISTORY_ENTRY_OVERHEAD (NSH_HISTORY_ENTRY_HEADER_SIZE + 1u)
+
 typedef struct nsh_history {
-    char entries[NSH_CMD_HISTORY_SIZE][NSH_LINE_BUFFER_SIZE];
-    unsigned int head; ///< Insertion index for new element
-    unsigned int tail; ///< Oldest element index (0 if empty)
-    unsigned int size;
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+    char* ring;
+    unsigned int ring_size;
+    unsigned int entry_max_size; ///< Longest entry, one less than the line buffer capacity
+#else
+    char ring[NSH_CMD_HISTORY_SIZE];
+#endif
+    unsigned int head;  ///< Insertion offset for new entry
+    unsigned int tail;  ///< Oldest entry offset (0 if empty)
+    unsigned int wrap;  ///< End of the entries before they wrap to offset 0 (0 if not wrapped)
+    unsigned int count; ///< Number of entries
 } nsh_history_t;
 
+/**
+ * @def NSH_HISTORY_RING_SIZE(<hist>)
+ * @def NSH_HISTORY_ENTRY_MAX_SIZE(<hist>)
+ * @brief Size of the ring and of its longest entry, constants without NSH_FEATURE_USE_RUNTIME_LIMITS.
+ *
+ * NSH_HISTORY_ENTRY_BUFFER_SIZE is the size of a buffer able to hold any entry
+ * and its null terminator.
+ */
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+#define NSH_HISTORY_RING_SIZE(hist)       ((hist)->ring_size)
+#define NSH_HISTORY_ENTRY_MAX_SIZE(hist)  ((hist)->entry_max_size)
+#define NSH_HISTORY_ENTRY_BUFFER_SIZE     256u // The entry size is stored in a single byte
+#else
+#define NSH_HISTORY_RING_SIZE(hist)       NSH_CMD_HISTORY_SIZE
+#define NSH_HISTORY_ENTRY_MAX_SIZE(hist)  (NSH_LINE_BUFFER_SIZE - 1u) // Keep one char for '\0' when read back
+#define NSH_HISTORY_ENTRY_BUFFER_SIZE     NSH_LINE_BUFFER_SIZE
+#endif
+
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+/**
+ * @brief Give the 'ring_size' bytes of 'ring' to the history, before resetting it.
+ */
+void nsh_history_set_storage(nsh_history_t* hist, char* ring, unsigned int ring_size, unsigned int entry_max_size)
+    NSH_NON_NULL(1, 2);
+#endif
+
 void nsh_history_reset(nsh_history_t* hist) NSH_NON_NULL(1);
 
 unsigned int nsh_history_entry_count(const nsh_history_t* hist) NSH_NON_NULL(1);
@@ -30,10 +77,69 @@ bool nsh_history_is_full(const nsh_history_t* hist) NSH_NON_NULL(1);
 
 bool nsh_history_is_empty(const nsh_history_t* hist) NSH_NON_NULL(1);
 
-void nsh_history_add_entry(nsh_history_t* hist, const char* entry) NSH_NON_NULL(1, 2);
+/**
+ * @brief Add a new entry into the history, unless it is identical to the most recent one.
+ * @return true if the entry was added.
+ */
+bool nsh_history_add_entry(nsh_history_t* hist, const char* entry) NSH_NON_NULL(1, 2);
 
 nsh_status_t nsh_history_get_entry(nsh_history_t* hist, unsigned int age, char* entry) NSH_NON_NULL(1, 3);
 
+/*
+ * Entries can be walked through using their offset in the ring.
+ * All these functions return NSH_HISTORY_INVALID_ENTRY when there is no such entry.
+ */
+unsigned int nsh_history_most_recent(const nsh_history_t* hist) NSH_NON_NULL(1);
+
+unsigned int nsh_history_oldest(const nsh_history_t* hist) NSH_NON_NULL(1);
+
+unsigned int nsh_history_previous(const nsh_history_t* hist, unsigned int entry) NSH_NON_NULL(1);
+
+unsigned int nsh_history_next(const nsh_history_t* hist, unsigned int entry) NSH_NON_NULL(1);
+
+/**
+ * @brief Access the entry at offset 'entry' in place, without copying it.
+ * @return A pointer to the entry characters, which are NOT null-terminated. The entry
+ * size is written in 'size'. The pointer is valid until the next added entry.
+ */
+const char* nsh_history_view_entry(const nsh_history_t* hist, unsigned int entry, unsigned int* size)
+    NSH_NON_NULL(1, 3);
+
+/**
+ * @brief Copy the entry at offset 'entry' into 'buffer' as a null-terminated string.
+ * @return The size of the entry, without the null terminator.
+ */
+unsigned int nsh_history_read_entry(const nsh_history_t* hist, unsigned int entry, char* buffer) NSH_NON_NULL(1, 3);
+
+bool nsh_history_entry_starts_with(const nsh_history_t* hist, unsigned int entry, const char* prefix,
+    unsigned int prefix_size) NSH_NON_NULL(1, 3);
+
+/**
+ * @brief Find the most recent entry starting with 'prefix', starting from the entry at offset 'entry'.
+ * @return The offset of the matching entry, or NSH_HISTORY_INVALID_ENTRY if none matches.
+ */
+unsigned int nsh_history_find_prefix(const nsh_history_t* hist, const char* prefix, unsigned int prefix_size,
+    unsigned int entry) NSH_NON_NULL(1, 2);
+
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+
+/**
+ * @brief Compute the character presence bitmap of a string.
+ *
+ * Each character sets the bit (c % 32), so a string can only contain a pattern
+ * if its signature includes all the bits of the pattern signature.
+ */
+uint32_t nsh_history_signature(const char* str, unsigned int size) NSH_NON_NULL(1);
+
+/**
+ * @brief Find the most recent entry containing 'pattern', starting from the entry at offset 'entry'.
+ * @return The offset of the matching entry, or NSH_HISTORY_INVALID_ENTRY if none matches.
+ */
+unsigned int nsh_history_search(const nsh_history_t* hist, const char* pattern, unsigned int pattern_size,
+    unsigned int entry) NSH_NON_NULL(1, 2);
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
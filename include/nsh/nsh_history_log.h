@@ -0,0 +1,93 @@
+#ifndef NSH_HISTORY_LOG_H_
+#define NSH_HISTORY_LOG_H_
+
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+#include <nsh/nsh_history.h>
+
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The history log is a sequence of records appended to a storage:
+ *   [magic (1 byte)][size (1 byte)][CRC-16 of size and characters (2 bytes)][characters (size bytes)]
+ * It is replayed into the history in a single pass at startup. When the storage
+ * is full, it is rotated and the whole history is written again from scratch.
+ */
+#define NSH_HISTORY_LOG_RECORD_MAGIC       0xA5u
+#define NSH_HISTORY_LOG_RECORD_HEADER_SIZE 4u
+
+/**
+ * @brief Interface of a storage holding the history log.
+ */
+typedef struct nsh_history_storage {
+    /**
+     * Read up to 'size' bytes at 'offset' from the beginning of the log.
+     * Return the number of bytes read, less than 'size' at the end of the log.
+     */
+    unsigned int (*read)(void* ctx, unsigned int offset, void* data, unsigned int size);
+    /**
+     * Append 'size' bytes at the end of the log.
+     * Return NSH_STATUS_BUFFER_OVERFLOW if there is not enough room left.
+     */
+    nsh_status_t (*append)(void* ctx, const void* data, unsigned int size);
+    /**
+     * Discard the log content and start an empty one.
+     */
+    nsh_status_t (*rotate)(void* ctx);
+    void* ctx;
+} nsh_history_storage_t;
+
+typedef struct nsh_history_log {
+    const nsh_history_storage_t* storage; ///< Null if the history is not persisted
+    unsigned int pending;                 ///< Number of most recent entries not written yet
+} nsh_history_log_t;
+
+void nsh_history_log_init(nsh_history_log_t* log, const nsh_history_storage_t* storage) NSH_NON_NULL(1);
+
+/**
+ * @brief Replay the log into the history, then clean it up if a corrupted record was found.
+ */
+nsh_status_t nsh_history_log_load(nsh_history_log_t* log, nsh_history_t* hist) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Add an entry into the history and mark it as pending until the next flush.
+ */
+void nsh_history_log_add_entry(nsh_history_log_t* log, nsh_history_t* hist, const char* entry) NSH_NON_NULL(1, 2, 3);
+
+bool nsh_history_log_is_batch_complete(const nsh_history_log_t* log) NSH_NON_NULL(1);
+
+/**
+ * @brief Append the pending entries to the log, rotating it if the storage is full.
+ */
+nsh_status_t nsh_history_log_flush(nsh_history_log_t* log, const nsh_history_t* hist) NSH_NON_NULL(1, 2);
+
+uint16_t nsh_history_log_crc16(uint16_t crc, const void* data, unsigned int size) NSH_NON_NULL(2);
+
+/**
+ * @brief History storage backed by a file, usable wherever stdio files are.
+ */
+typedef struct nsh_history_file {
+    FILE* file;
+    const char* path;
+} nsh_history_file_t;
+
+nsh_status_t nsh_history_file_storage_init(nsh_history_storage_t* storage, nsh_history_file_t* file, const char* path)
+    NSH_NON_NULL(1, 2, 3);
+
+void nsh_history_file_storage_close(nsh_history_file_t* file) NSH_NON_NULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+
+#endif // NSH_HISTORY_LOG_H_
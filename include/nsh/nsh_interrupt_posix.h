@@ -0,0 +1,39 @@
+#ifndef NSH_INTERRUPT_POSIX_H_
+#define NSH_INTERRUPT_POSIX_H_
+
+#include <nsh/nsh.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Monotonic clock in milliseconds, to give to nsh_set_clock().
+ */
+unsigned int nsh_posix_clock_ms(void);
+
+#if NSH_FEATURE_USE_CMD_STATS == 1 || NSH_FEATURE_USE_TRACE == 1
+/**
+ * @brief Monotonic clock in microseconds, to give to nsh_set_cycle_counter() or nsh_trace_start().
+ */
+uint32_t nsh_posix_clock_us(void);
+#endif
+
+/**
+ * @brief Interrupt the command running in the foreground of 'nsh' on SIGINT (Ctrl-C in a terminal).
+ *
+ * Signal handlers being process-wide, only one shell can be interrupted at a time.
+ * Return NSH_STATUS_FAILURE if the signal handler cannot be installed.
+ */
+nsh_status_t nsh_posix_interrupt_install(nsh_t* nsh) NSH_NON_NULL(1);
+
+/**
+ * @brief Restore the SIGINT handler replaced by nsh_posix_interrupt_install().
+ */
+void nsh_posix_interrupt_uninstall(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_INTERRUPT_POSIX_H_
@@ -0,0 +1,101 @@
+#ifndef NSH_IO_DMA_H_
+#define NSH_IO_DMA_H_
+
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+#include <nsh/nsh_io_plugin.h>
+#include <nsh/nsh_rx_ring.h>
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Operations of a UART whose transfers are done by DMA, implemented by the platform.
+ */
+typedef struct nsh_io_dma_driver {
+    /**
+     * Start transmitting 'size' bytes from 'data', and return immediately.
+     * The platform shall call nsh_io_dma_tx_complete() once the transfer is done
+     * (from the DMA transfer complete interrupt for instance).
+     */
+    void (*start_tx)(void* ctx, const char* data, unsigned int size);
+    /**
+     * Wait for the next interrupt while the transport cannot progress (WFI for instance).
+     * May be null to busy-wait.
+     */
+    void (*idle)(void* ctx);
+    void* ctx;
+} nsh_io_dma_driver_t;
+
+/**
+ * @brief Context of the DMA I/O backend.
+ *
+ * The output is copied into one of two transmit buffers while the DMA sends the
+ * other one, so that writing only blocks when both buffers are full. The input
+ * is pushed into a receive ring by the platform interrupts.
+ *
+ * The transfers are only started by the shell, never from the interrupts, so
+ * that the buffer being filled is not shared with them. Output written while a
+ * transfer is in progress thus waits for the next write, for the shell to wait
+ * for input, or for nsh_io_dma_flush().
+ */
+typedef struct nsh_io_dma {
+    const nsh_io_dma_driver_t* driver;
+    char tx_buffers[2][NSH_IO_DMA_TX_BUFFER_SIZE];
+    unsigned int tx_fill_index; ///< Index of the buffer being filled, the other one may be transmitted
+    unsigned int tx_fill_size;
+    bool tx_busy;               ///< A transfer is in progress, cleared by the transfer complete interrupt
+    unsigned int tx_count;      ///< Number of transfers started
+    nsh_rx_ring_t rx;
+    unsigned int rx_position;     ///< Position of the next byte to read in the circular receive DMA buffer
+    void (*interrupt)(void* ctx); ///< Called from the receive interrupt on each Ctrl-C, may be null
+    void* interrupt_ctx;
+} nsh_io_dma_t;
+
+/**
+ * @brief Backend transmitting and receiving by DMA, its context being a nsh_io_dma_t.
+ */
+extern const nsh_io_backend_t nsh_io_dma_backend;
+
+void nsh_io_dma_init(nsh_io_dma_t* dma, const nsh_io_dma_driver_t* driver) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Signal the end of the transfer started by the driver. May be called from an interrupt handler.
+ *
+ * Only marks the DMA as available, the pending output being sent by the shell
+ * on its next write, read or flush.
+ */
+void nsh_io_dma_tx_complete(nsh_io_dma_t* dma) NSH_NON_NULL(1);
+
+/**
+ * @brief Push the bytes received by a circular DMA since the last call into the receive ring.
+ *
+ * To be called from the UART idle line interrupt and the DMA half and full
+ * transfer interrupts, 'write_position' being the position of the next byte the
+ * DMA will write into 'buffer'.
+ */
+void nsh_io_dma_rx_update(nsh_io_dma_t* dma, const char* buffer, unsigned int buffer_size,
+    unsigned int write_position) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Call 'interrupt(ctx)' from nsh_io_dma_rx_update() each time a Ctrl-C is received.
+ *
+ * Lets a running command be cancelled from the receive interrupt, for instance
+ * by giving a function calling nsh_interrupt() on the shell. The Ctrl-C byte is
+ * still pushed into the receive ring.
+ */
+void nsh_io_dma_set_interrupt_handler(nsh_io_dma_t* dma, void (*interrupt)(void* ctx), void* ctx) NSH_NON_NULL(1);
+
+/**
+ * @brief Wait until all the written bytes are transmitted.
+ */
+void nsh_io_dma_flush(nsh_io_dma_t* dma) NSH_NON_NULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_IO_DMA_H_
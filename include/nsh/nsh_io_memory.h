@@ -0,0 +1,41 @@
+#ifndef NSH_IO_MEMORY_H_
+#define NSH_IO_MEMORY_H_
+
+#include <nsh/nsh_io_plugin.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Context of the in-memory I/O backend.
+ *
+ * The input is read from a fixed buffer, and the input is exhausted at its end.
+ * The output is stored into a fixed buffer, the bytes that do not fit being
+ * dropped but still counted.
+ */
+typedef struct nsh_io_memory {
+    const char* input;
+    unsigned int input_size;
+    unsigned int input_offset;
+    char* output;
+    unsigned int output_capacity;
+    unsigned int output_size; ///< Number of bytes written, may exceed output_capacity
+} nsh_io_memory_t;
+
+/**
+ * @brief Backend reading from and writing to memory, its context being a nsh_io_memory_t.
+ */
+extern const nsh_io_backend_t nsh_io_memory_backend;
+
+/**
+ * @brief Initialize the memory I/O context. 'output' may be null if 'output_capacity' is 0.
+ */
+void nsh_io_memory_init(nsh_io_memory_t* mem, const char* input, unsigned int input_size, char* output,
+    unsigned int output_capacity) NSH_NON_NULL(1, 2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_IO_MEMORY_H_
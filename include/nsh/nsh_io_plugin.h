@@ -1,30 +1,120 @@
 #ifndef NSH_IO_PLUGIN_H_
 #define NSH_IO_PLUGIN_H_
 
+#include <nsh/nsh_common_defs.h>
 #include <nsh/nsh_config.h>
+#include <nsh/nsh_trace.h>
+
+#include <limits.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-char nsh_io_get_char(void);
+/**
+ * @brief Character returned by nsh_io_get_char() once the input is exhausted (Ctrl-D).
+ */
+#define NSH_IO_EOT '\x04'
+
+/**
+ * @brief Character interrupting the command running in the foreground (Ctrl-C).
+ */
+#define NSH_IO_ETX '\x03'
+
+/**
+ * @brief Timeout given to nsh_io_wait() to wait until an input character is available.
+ */
+#define NSH_IO_WAIT_FOREVER UINT_MAX
+
+/**
+ * @brief Operations provided by an I/O backend (a terminal, a UART, a memory buffer...).
+ *
+ * Each operation receives the context given to nsh_io_init(), so that a backend
+ * can serve several shell instances.
+ */
+typedef struct nsh_io_backend {
+    /**
+     * Wait for the next input character and return it, or return a negative
+     * value if the input is exhausted.
+     */
+    int (*read)(void* ctx);
+    /**
+     * Write 'size' bytes of output.
+     */
+    void (*write)(void* ctx, const char* data, unsigned int size);
+    /**
+     * Wait at most 'timeout_ms' milliseconds for an input character, and return
+     * true if read() can be called without blocking.
+     * May be null if the backend can only wait in read().
+     */
+    bool (*wait)(void* ctx, unsigned int timeout_ms);
+} nsh_io_backend_t;
+
+/**
+ * @brief I/O context of a shell instance.
+ */
+typedef struct nsh_io {
+    const nsh_io_backend_t* backend;
+    void* ctx;
+    const char* prompt;
+    char output[NSH_IO_OUTPUT_BUFFER_SIZE + 1]; ///< One more char for the null terminator written by vsnprintf
+    unsigned int output_size;
+#if NSH_FEATURE_USE_TRACE == 1
+    nsh_trace_t* trace; ///< Trace recording the phases of this I/O, null if not traced
+#endif
+} nsh_io_t;
+
+/**
+ * @brief Backend reading from stdin and writing to stdout.
+ */
+extern const nsh_io_backend_t nsh_io_stdio_backend;
+
+void nsh_io_init(nsh_io_t* io, const nsh_io_backend_t* backend, void* ctx) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Write the buffered output to the backend.
+ */
+void nsh_io_flush(nsh_io_t* io) NSH_NON_NULL(1);
+
+/**
+ * @brief Wait at most 'timeout_ms' milliseconds for an input character, flushing the pending output first.
+ * @return True if nsh_io_get_char() will not block, always true if the backend cannot wait with a timeout.
+ */
+bool nsh_io_wait(nsh_io_t* io, unsigned int timeout_ms) NSH_NON_NULL(1);
+
+/**
+ * @brief Wait for the next input character, flushing the pending output first.
+ * @return The character read, or NSH_IO_EOT once the input is exhausted.
+ */
+char nsh_io_get_char(nsh_io_t* io) NSH_NON_NULL(1);
+
+void nsh_io_put_char(nsh_io_t* io, char c) NSH_NON_NULL(1);
 
-void nsh_io_put_char(char c);
+void nsh_io_put_newline(nsh_io_t* io) NSH_NON_NULL(1);
 
-void nsh_io_put_newline(void);
+void nsh_io_put_string(nsh_io_t* io, const char* str) NSH_NON_NULL(1, 2);
 
-void nsh_io_put_string(const char* str);
+void nsh_io_put_buffer(nsh_io_t* io, const char* str, unsigned int size) NSH_NON_NULL(1);
 
-void nsh_io_put_buffer(const char* str, unsigned int size);
+/**
+ * @brief Print an unsigned integer in decimal, without requiring NSH_FEATURE_USE_PRINTF.
+ */
+void nsh_io_put_unsigned(nsh_io_t* io, unsigned int value) NSH_NON_NULL(1);
 
-void nsh_io_print_prompt(void);
+void nsh_io_print_prompt(nsh_io_t* io) NSH_NON_NULL(1);
 
-void nsh_io_erase_last_char(void);
+void nsh_io_erase_last_char(nsh_io_t* io) NSH_NON_NULL(1);
 
-void nsh_io_erase_line(void);
+void nsh_io_erase_line(nsh_io_t* io) NSH_NON_NULL(1);
 
 #if NSH_FEATURE_USE_PRINTF == 1
-int nsh_io_printf(const char* NSH_RESTRICT format, ...);
+/**
+ * @brief Print formatted output. Output longer than the output buffer is streamed one conversion at a time, so only
+ * a single non-string conversion longer than NSH_IO_OUTPUT_BUFFER_SIZE is truncated.
+ * @return The number of characters written, or a negative value on an encoding error.
+ */
+int nsh_io_printf(nsh_io_t* io, const char* NSH_RESTRICT format, ...) NSH_NON_NULL(1, 2);
 #endif
 
 #ifdef __cplusplus
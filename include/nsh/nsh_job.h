@@ -0,0 +1,153 @@
+#ifndef NSH_JOB_H_
+#define NSH_JOB_H_
+
+#include <nsh/nsh_cmd.h>
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+#include <nsh/nsh_io_plugin.h>
+
+#if NSH_FEATURE_USE_JOBS == 1
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Interface of an executor running the background jobs (a thread pool, RTOS tasks...).
+ */
+typedef struct nsh_executor {
+    /**
+     * Run 'task(arg)' asynchronously.
+     * Return NSH_STATUS_FAILURE if the task cannot be started.
+     */
+    nsh_status_t (*submit)(void* ctx, void (*task)(void* arg), void* arg);
+    /**
+     * Lock and unlock the mutex protecting the jobs state and output.
+     */
+    void (*lock)(void* ctx);
+    void (*unlock)(void* ctx);
+    /**
+     * Let the jobs progress while the shell waits for one of them.
+     */
+    void (*yield)(void* ctx);
+    /**
+     * Run the jobs ready to progress on the shell thread, while the shell waits
+     * for input. Return the delay in milliseconds before the next call is needed,
+     * or NSH_IO_WAIT_FOREVER if there is nothing to wait for.
+     * May be null if the jobs progress on their own (on threads for instance).
+     */
+    unsigned int (*poll)(void* ctx);
+    void* ctx;
+} nsh_executor_t;
+
+typedef enum nsh_job_state {
+    NSH_JOB_STATE_FREE,    ///< The job slot is available
+    NSH_JOB_STATE_RUNNING, ///< The handler is running
+    NSH_JOB_STATE_DONE,    ///< The handler returned, but its completion is not reported yet
+} nsh_job_state_t;
+
+typedef struct nsh_job {
+    nsh_job_state_t state;
+    nsh_status_t status; ///< Status returned by the handler
+    const nsh_executor_t* executor;
+    nsh_cmd_handler_t* handler;
+    nsh_cmd_ctx_t ctx;
+    nsh_cancel_token_t cancel;
+    nsh_io_t io; ///< Job I/O, writing to 'output' and with no input
+    unsigned int argc;
+    char args[NSH_CMD_ARGS_MAX_COUNT][NSH_MAX_STRING_SIZE];
+    char* argv[NSH_CMD_ARGS_MAX_COUNT];
+    char output[NSH_JOB_OUTPUT_BUFFER_SIZE]; ///< Output not displayed yet
+    unsigned int output_size;
+    bool output_truncated; ///< Output was dropped because 'output' was full
+} nsh_job_t;
+
+/*
+ * Jobs are identified by their index in the table plus one.
+ */
+typedef struct nsh_job_table {
+    const nsh_executor_t* executor; ///< Null if background jobs are not supported
+    nsh_job_t jobs[NSH_JOB_MAX_COUNT];
+} nsh_job_table_t;
+
+void nsh_job_table_init(nsh_job_table_t* table, const nsh_executor_t* executor) NSH_NON_NULL(1);
+
+/**
+ * @brief Start running a command in the background.
+ *
+ * The arguments are copied, so they do not need to outlive the call.
+ * A handler returning NSH_STATUS_PENDING keeps the job running until it calls nsh_job_complete().
+ * @return NSH_STATUS_UNSUPPORTED if there is no executor, NSH_STATUS_MAX_ARGS_NB_REACH
+ * if 'argc' is above NSH_CMD_ARGS_MAX_COUNT, NSH_STATUS_FAILURE if all the job
+ * slots are used or the executor failed.
+ */
+nsh_status_t nsh_job_start(nsh_job_table_t* table, struct nsh_s* nsh, nsh_cmd_handler_t* handler,
+    unsigned int argc, char** argv, unsigned int* id) NSH_NON_NULL(1, 2, 3, 5, 6);
+
+/**
+ * @brief Complete the job whose handler returned NSH_STATUS_PENDING.
+ *
+ * 'ctx' is the context given to the handler, and 'status' replaces the status it returned.
+ */
+void nsh_job_complete(nsh_cmd_ctx_t* ctx, nsh_status_t status) NSH_NON_NULL(1);
+
+/**
+ * @brief Let the executor run the jobs ready to progress.
+ * @return The delay in milliseconds before the next call is needed, or NSH_IO_WAIT_FOREVER.
+ */
+unsigned int nsh_job_poll(nsh_job_table_t* table) NSH_NON_NULL(1);
+
+/**
+ * @brief Return the job identified by 'id', or null if there is no such running or done job.
+ */
+nsh_job_t* nsh_job_find(nsh_job_table_t* table, unsigned int id) NSH_NON_NULL(1);
+
+/**
+ * @brief Return the most recently started job still running or done, or null if there is none.
+ */
+nsh_job_t* nsh_job_find_last(nsh_job_table_t* table) NSH_NON_NULL(1);
+
+unsigned int nsh_job_id(const nsh_job_table_t* table, const nsh_job_t* job) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Request the job to stop through its cancel token.
+ */
+void nsh_job_cancel(nsh_job_table_t* table, nsh_job_t* job) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Return true if some job output or completion was not displayed yet.
+ */
+bool nsh_job_has_news(nsh_job_table_t* table) NSH_NON_NULL(1);
+
+/**
+ * @brief Display the pending output of all the jobs, and report and release the completed ones.
+ */
+void nsh_job_display_news(nsh_job_table_t* table, nsh_io_t* io) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Display the output of the job on ctx->io until it completes, then report and release it.
+ *
+ * If the waiting command is cancelled first, the job keeps running in the background.
+ * @return The status returned by the job handler, or NSH_STATUS_CANCELLED.
+ */
+nsh_status_t nsh_job_wait(nsh_job_table_t* table, nsh_job_t* job, const nsh_cmd_ctx_t* ctx) NSH_NON_NULL(1, 2, 3);
+
+/**
+ * @brief Cancel all the jobs, then wait for them to complete.
+ */
+void nsh_job_terminate_all(nsh_job_table_t* table, nsh_io_t* io) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief List the jobs with their state.
+ */
+void nsh_job_list(nsh_job_table_t* table, nsh_io_t* io) NSH_NON_NULL(1, 2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_JOBS == 1
+
+#endif // NSH_JOB_H_
@@ -11,10 +11,32 @@ extern "C" {
 #endif
 
 typedef struct nsh_line_buffer {
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+    char* buffer;
+    unsigned int capacity;
+#else
     char buffer[NSH_LINE_BUFFER_SIZE];
+#endif
     unsigned int size;
 } nsh_line_buffer_t;
 
+/**
+ * @def NSH_LINE_BUFFER_CAPACITY(<linebuf>)
+ * @brief Number of characters the line buffer can hold, a constant without NSH_FEATURE_USE_RUNTIME_LIMITS.
+ */
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+#define NSH_LINE_BUFFER_CAPACITY(linebuf) ((linebuf)->capacity)
+#else
+#define NSH_LINE_BUFFER_CAPACITY(linebuf) NSH_LINE_BUFFER_SIZE
+#endif
+
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+/**
+ * @brief Give the 'capacity' characters of 'storage' to the line buffer, before resetting it.
+ */
+void nsh_line_buffer_set_storage(nsh_line_buffer_t* linebuf, char* storage, unsigned int capacity) NSH_NON_NULL(1, 2);
+#endif
+
 void nsh_line_buffer_reset(nsh_line_buffer_t* linebuf) NSH_NON_NULL(1);
 
 nsh_status_t nsh_line_buffer_append_char(nsh_line_buffer_t* linebuf, char c) NSH_NON_NULL(1);
@@ -0,0 +1,65 @@
+#ifndef NSH_LOG_H_
+#define NSH_LOG_H_
+
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct nsh_log_slot {
+    /*
+     * Equals the enqueue position for which the slot is free, or this position
+     * plus one once the message is written.
+     */
+    unsigned int sequence;
+    unsigned int size;
+    char message[NSH_LOG_MESSAGE_SIZE];
+} nsh_log_slot_t;
+
+/**
+ * @brief Lock-free multi-producer/single-consumer queue of log messages.
+ *
+ * Producers (threads, interrupt handlers) reserve a slot by incrementing the
+ * enqueue position, then publish it once their message is copied, so they
+ * never wait for each other nor for the consumer. The consumer (the shell)
+ * stops at the first slot not published yet. Messages which do not fit are
+ * dropped and counted.
+ */
+typedef struct nsh_log_queue {
+    nsh_log_slot_t slots[NSH_LOG_QUEUE_SIZE];
+    unsigned int enqueue_position; ///< Changed by the producers
+    unsigned int dequeue_position; ///< Changed by the consumer only
+    unsigned int dropped_count;    ///< Changed by the producers
+} nsh_log_queue_t;
+
+void nsh_log_queue_init(nsh_log_queue_t* queue) NSH_NON_NULL(1);
+
+/**
+ * @brief Enqueue a copy of the 'size' bytes of 'message', truncated to NSH_LOG_MESSAGE_SIZE.
+ * @return false if the queue is full, the message being dropped.
+ */
+bool nsh_log_queue_push(nsh_log_queue_t* queue, const char* message, unsigned int size) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Dequeue the oldest message into 'message', which holds NSH_LOG_MESSAGE_SIZE bytes.
+ * @return false if there is no message ready.
+ */
+bool nsh_log_queue_pop(nsh_log_queue_t* queue, char* message, unsigned int* size) NSH_NON_NULL(1, 2, 3);
+
+bool nsh_log_queue_is_empty(const nsh_log_queue_t* queue) NSH_NON_NULL(1);
+
+unsigned int nsh_log_queue_dropped_count(const nsh_log_queue_t* queue) NSH_NON_NULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_ASYNC_LOG == 1
+
+#endif // NSH_LOG_H_
@@ -0,0 +1,57 @@
+#ifndef NSH_MEM_H_
+#define NSH_MEM_H_
+
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Byte painted into the unused memory, the same one as the stack fill byte of FreeRTOS.
+ *
+ * A used byte holding this very value is not counted, which can only lower a
+ * peak by a few bytes.
+ */
+#define NSH_MEM_PAINT_BYTE 0xA5u
+
+/**
+ * @brief Part of the stack below the current frame which is not painted, used by the painting itself.
+ */
+#define NSH_MEM_STACK_PAINT_MARGIN 256u
+
+/**
+ * @brief Fill 'size' bytes of 'buffer' with NSH_MEM_PAINT_BYTE.
+ */
+void nsh_mem_paint(void* buffer, size_t size) NSH_NON_NULL(1);
+
+/**
+ * @brief Number of bytes of 'buffer' used at least once since it was painted, filled from its start.
+ */
+size_t nsh_mem_high_water_mark(const void* buffer, size_t size) NSH_NON_NULL(1);
+
+/**
+ * @brief Paint the free part of a stack growing downward, from its lowest address 'stack_limit' to the current frame.
+ *
+ * Must be called from the thread running on this stack.
+ * Return NSH_STATUS_WRONG_ARG if the current frame is not in the stack.
+ */
+nsh_status_t nsh_mem_paint_stack(void* stack_limit, size_t size) NSH_NON_NULL(1);
+
+/**
+ * @brief Number of bytes of a stack growing downward used at least once since it was painted.
+ */
+size_t nsh_mem_stack_high_water_mark(const void* stack_limit, size_t size) NSH_NON_NULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+
+#endif // NSH_MEM_H_
@@ -0,0 +1,125 @@
+#ifndef NSH_PIPE_H_
+#define NSH_PIPE_H_
+
+#include <nsh/nsh_cmd.h>
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+#include <nsh/nsh_io_plugin.h>
+
+#if NSH_FEATURE_USE_PIPES == 1
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Token separating the command from its filters, and the filters from each other.
+ */
+#define NSH_PIPE_OPERATOR "|"
+
+typedef struct nsh_pipe_stage nsh_pipe_stage_t;
+
+/**
+ * @brief Filter run on the output of the previous stage of a pipeline.
+ */
+typedef struct nsh_pipe_filter {
+    const char* name;
+    /**
+     * Check the arguments and initialize the state of the stage.
+     * Print the usage to the output of the stage and return NSH_STATUS_WRONG_ARG if the arguments are invalid.
+     */
+    nsh_status_t (*start)(nsh_pipe_stage_t* stage, unsigned int argc, char** argv);
+    /**
+     * Filter 'size' bytes of input, writing the result to the output of the stage.
+     */
+    void (*write)(nsh_pipe_stage_t* stage, const char* data, unsigned int size);
+    /**
+     * Write the pending output once the input is complete. May be null.
+     */
+    void (*finish)(nsh_pipe_stage_t* stage);
+} nsh_pipe_filter_t;
+
+struct nsh_pipe_stage {
+    const nsh_pipe_filter_t* filter;
+    struct nsh_pipeline* pipeline;
+    nsh_io_t input;   ///< Written by the previous stage, its output buffer being handed over to the filter on flush
+    nsh_io_t* output; ///< Input of the next stage, or the output of the shell for the last stage
+    union {
+        struct {
+            const char* pattern;
+            unsigned int pattern_size;
+            bool invert; ///< Keep the lines not matching
+            char line[NSH_PIPE_LINE_SIZE];
+            unsigned int line_size;
+        } grep;
+        struct {
+            unsigned int remaining_lines;
+        } head;
+        struct {
+            unsigned int lines;
+            unsigned int words;
+            unsigned int bytes;
+            bool in_word;
+        } wc;
+        struct {
+            unsigned int offset; ///< Offset of the first byte of 'row' in the input
+            unsigned char row[16];
+            unsigned int row_size;
+        } hex;
+    } state;
+};
+
+typedef struct nsh_pipeline {
+    nsh_pipe_stage_t stages[NSH_PIPE_MAX_FILTERS];
+    unsigned int count; ///< Number of filters, 0 if the command line has no pipe
+    nsh_io_t* output;   ///< Output of the last filter
+    nsh_cancel_token_t* cancel; ///< Cancel token of the command, cancelled once the filters need no more input
+    bool closed; ///< A filter needs no more input, the command can stop early
+} nsh_pipeline_t;
+
+/**
+ * @brief Return the filter named 'name', or null if there is none.
+ */
+const nsh_pipe_filter_t* nsh_pipe_find_filter(const char* name) NSH_NON_NULL(1);
+
+/**
+ * @brief Split the command line at the pipe operators, and start its filters.
+ *
+ * 'argc' is updated to the number of arguments of the command, the filters being
+ * started with the following arguments. Without any pipe operator, there is no filter.
+ * The last filter writes to 'output', and the command writes to nsh_pipeline_input().
+ * Print the error to 'output' and return NSH_STATUS_WRONG_ARG if a filter is
+ * missing, unknown or given invalid arguments, or if there are too many filters.
+ */
+nsh_status_t nsh_pipeline_open(nsh_pipeline_t* pipeline, nsh_io_t* output, nsh_cancel_token_t* cancel,
+    unsigned int* argc, char** argv) NSH_NON_NULL(1, 2, 3, 4, 5);
+
+/**
+ * @brief Return the output of the command, feeding the first filter, or the output of the pipeline if there is none.
+ */
+nsh_io_t* nsh_pipeline_input(nsh_pipeline_t* pipeline) NSH_NON_NULL(1);
+
+/**
+ * @brief Replace the output of the last filter, or of the command if there is no filter.
+ */
+void nsh_pipeline_set_output(nsh_pipeline_t* pipeline, nsh_io_t* output) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Flush the output of the command through the filters, letting each one write its pending output.
+ */
+void nsh_pipeline_close(nsh_pipeline_t* pipeline) NSH_NON_NULL(1);
+
+/**
+ * @brief Tell the pipeline that the filter needs no more input, cancelling the command.
+ */
+void nsh_pipe_stage_stop(nsh_pipe_stage_t* stage) NSH_NON_NULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_PIPES == 1
+
+#endif // NSH_PIPE_H_
@@ -0,0 +1,91 @@
+#ifndef NSH_REDIRECT_H_
+#define NSH_REDIRECT_H_
+
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+#include <nsh/nsh_io_plugin.h>
+
+#if NSH_FEATURE_USE_REDIRECTION == 1
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Token redirecting the output of a command into a file, truncating it.
+ */
+#define NSH_REDIRECT_OPERATOR ">"
+
+/**
+ * @brief Token redirecting the output of a command to the end of a file.
+ */
+#define NSH_REDIRECT_APPEND_OPERATOR ">>"
+
+/**
+ * @brief Interface of the files the output of a command can be redirected to.
+ */
+typedef struct nsh_redirect_backend {
+    /**
+     * Open the file named 'path' for writing, truncated or appended to.
+     * Return the file, or null if it cannot be opened.
+     */
+    void* (*open)(const char* path, bool append);
+    /**
+     * Write 'size' bytes to the file, possibly buffering them until it is closed.
+     */
+    void (*write)(void* file, const char* data, unsigned int size);
+    /**
+     * Write the buffered bytes and close the file.
+     * Return NSH_STATUS_FAILURE if some bytes could not be written.
+     */
+    nsh_status_t (*close)(void* file);
+} nsh_redirect_backend_t;
+
+/**
+ * @brief Backend writing to stdio files, buffered by the C library.
+ */
+extern const nsh_redirect_backend_t nsh_redirect_stdio_backend;
+
+typedef struct nsh_redirect {
+    const nsh_redirect_backend_t* backend;
+    void* file; ///< Null if the output is not redirected
+    nsh_io_t io; ///< Output of the command, writing to 'file'
+} nsh_redirect_t;
+
+void nsh_redirect_init(nsh_redirect_t* redirect, const nsh_redirect_backend_t* backend) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Remove the trailing redirection operator and file name from the command line.
+ *
+ * 'path' is set to the file name, or to null if the output is not redirected.
+ * Being an argument of the command line, the file name is at most
+ * NSH_MAX_STRING_SIZE - 1 characters long.
+ * Return NSH_STATUS_WRONG_ARG if a redirection operator is not followed by a
+ * single file name at the end of the command line.
+ */
+nsh_status_t nsh_redirect_parse(unsigned int* argc, char** argv, const char** path, bool* append)
+    NSH_NON_NULL(1, 2, 3, 4);
+
+/**
+ * @brief Open the file the output is redirected to, written through nsh_redirect_t::io.
+ *
+ * The output is written as it would be displayed, its lines ending with "\r\n".
+ * @return NSH_STATUS_FAILURE if the file cannot be opened.
+ */
+nsh_status_t nsh_redirect_open(nsh_redirect_t* redirect, const char* path, bool append) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Flush the output into the file, then close it.
+ * @return NSH_STATUS_FAILURE if some output could not be written.
+ */
+nsh_status_t nsh_redirect_close(nsh_redirect_t* redirect) NSH_NON_NULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_REDIRECTION == 1
+
+#endif // NSH_REDIRECT_H_
@@ -0,0 +1,140 @@
+#ifndef NSH_RX_RING_H_
+#define NSH_RX_RING_H_
+
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring of input bytes.
+ *
+ * The producer (a UART receive interrupt, a DMA completion callback, a reader
+ * thread...) pushes the received bytes, and the consumer (the shell, through the
+ * read operation of its I/O backend) drains them in bulk. The bytes which do
+ * not fit are dropped and counted.
+ *
+ * The functions are defined inline so that they can be called from an interrupt
+ * handler without linking the Nsh library.
+ */
+typedef struct nsh_rx_ring {
+    char buffer[NSH_RX_RING_SIZE];
+    unsigned int head;            ///< Free-running write index, changed by the producer only
+    unsigned int tail;            ///< Free-running read index, changed by the consumer only
+    unsigned int overrun_count;   ///< Bytes dropped, changed by the producer only
+    unsigned int high_water_mark; ///< Maximum number of bytes stored at once, changed by the producer only
+} nsh_rx_ring_t;
+
+static inline void nsh_rx_ring_init(nsh_rx_ring_t* ring) NSH_NON_NULL(1);
+
+/**
+ * @brief Push the bytes received by the producer.
+ * @return The number of bytes pushed, the others being dropped because the ring is full.
+ */
+static inline unsigned int nsh_rx_ring_push(nsh_rx_ring_t* ring, const char* data, unsigned int size)
+    NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Count bytes lost by the producer before reaching the ring (a hardware overrun for instance).
+ */
+static inline void nsh_rx_ring_add_overruns(nsh_rx_ring_t* ring, unsigned int count) NSH_NON_NULL(1);
+
+/**
+ * @brief Pop at most 'size' bytes from the consumer side.
+ * @return The number of bytes popped, 0 if the ring is empty.
+ */
+static inline unsigned int nsh_rx_ring_pop(nsh_rx_ring_t* ring, char* data, unsigned int size) NSH_NON_NULL(1, 2);
+
+static inline unsigned int nsh_rx_ring_count(const nsh_rx_ring_t* ring) NSH_NON_NULL(1);
+
+static inline unsigned int nsh_rx_ring_overrun_count(const nsh_rx_ring_t* ring) NSH_NON_NULL(1);
+
+static inline unsigned int nsh_rx_ring_high_water_mark(const nsh_rx_ring_t* ring) NSH_NON_NULL(1);
+
+/*
+ * Each index is written by one side only, and published with a release store
+ * once the bytes it covers are written or read.
+ */
+
+static inline void nsh_rx_ring_init(nsh_rx_ring_t* ring)
+{
+    ring->head = 0;
+    ring->tail = 0;
+    ring->overrun_count = 0;
+    ring->high_water_mark = 0;
+}
+
+static inline unsigned int nsh_rx_ring_push(nsh_rx_ring_t* ring, const char* data, unsigned int size)
+{
+    unsigned int head = ring->head;
+    unsigned int count = head - NSH_ATOMIC_LOAD(&ring->tail);
+    unsigned int free_size = NSH_RX_RING_SIZE - count;
+    unsigned int push_size = (size < free_size) ? size : free_size;
+
+    // Copy in two parts if the bytes wrap around the end of the buffer
+    unsigned int offset = head & (NSH_RX_RING_SIZE - 1u);
+    unsigned int first_size = NSH_RX_RING_SIZE - offset;
+    if (first_size > push_size) {
+        first_size = push_size;
+    }
+    memcpy(&ring->buffer[offset], data, first_size);
+    memcpy(ring->buffer, &data[first_size], push_size - first_size);
+    NSH_ATOMIC_STORE(&ring->head, head + push_size);
+
+    if (push_size < size) {
+        NSH_ATOMIC_STORE(&ring->overrun_count, ring->overrun_count + (size - push_size));
+    }
+    if (count + push_size > ring->high_water_mark) {
+        NSH_ATOMIC_STORE(&ring->high_water_mark, count + push_size);
+    }
+    return push_size;
+}
+
+static inline void nsh_rx_ring_add_overruns(nsh_rx_ring_t* ring, unsigned int count)
+{
+    NSH_ATOMIC_STORE(&ring->overrun_count, ring->overrun_count + count);
+}
+
+static inline unsigned int nsh_rx_ring_pop(nsh_rx_ring_t* ring, char* data, unsigned int size)
+{
+    unsigned int tail = ring->tail;
+    unsigned int count = NSH_ATOMIC_LOAD(&ring->head) - tail;
+    unsigned int pop_size = (size < count) ? size : count;
+
+    unsigned int offset = tail & (NSH_RX_RING_SIZE - 1u);
+    unsigned int first_size = NSH_RX_RING_SIZE - offset;
+    if (first_size > pop_size) {
+        first_size = pop_size;
+    }
+    memcpy(data, &ring->buffer[offset], first_size);
+    memcpy(&data[first_size], ring->buffer, pop_size - first_size);
+    NSH_ATOMIC_STORE(&ring->tail, tail + pop_size);
+
+    return pop_size;
+}
+
+static inline unsigned int nsh_rx_ring_count(const nsh_rx_ring_t* ring)
+{
+    return NSH_ATOMIC_LOAD(&ring->head) - NSH_ATOMIC_LOAD(&ring->tail);
+}
+
+static inline unsigned int nsh_rx_ring_overrun_count(const nsh_rx_ring_t* ring)
+{
+    return NSH_ATOMIC_LOAD(&ring->overrun_count);
+}
+
+static inline unsigned int nsh_rx_ring_high_water_mark(const nsh_rx_ring_t* ring)
+{
+    return NSH_ATOMIC_LOAD(&ring->high_water_mark);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_RX_RING_H_
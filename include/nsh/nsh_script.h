@@ -0,0 +1,146 @@
+#ifndef NSH_SCRIPT_H_
+#define NSH_SCRIPT_H_
+
+#include <nsh/nsh_cmd.h>
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+
+#if NSH_FEATURE_USE_SCRIPTS == 1
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Scripts are sequences of statements separated by newlines or ';':
+ *
+ *   <command> <args...>                  call a command, an argument "$name" being replaced by its value
+ *   let <name> <expr>                    set a variable
+ *   if <expr> ... [else ...] end
+ *   while <expr> ... end
+ *   for <name> in <from>..<to> ... end   loop over an inclusive range, the bounds being evaluated once
+ *
+ * An expression is an operand, or two operands with one of the operators
+ * + - * / % == != < <= > >=, the comparisons having the aliases -eq -ne -lt
+ * -le -gt -ge since the shell takes '>' for a redirection. An operand is an
+ * integer, "$name", or "$?", the status of the last command. A condition is
+ * true if its value is not 0.
+ *
+ * A script is compiled once into bytecode holding the resolved command handlers
+ * and the arguments already split, then run without looking up or splitting
+ * anything. Nothing is allocated, all the storage is held by nsh_script_t, so a
+ * script is limited to NSH_SCRIPT_MAX_INSTRUCTIONS - 1 instructions,
+ * NSH_SCRIPT_MAX_ARGS command arguments, NSH_SCRIPT_MAX_VARIABLES variables and
+ * NSH_SCRIPT_MAX_DEPTH nested blocks.
+ */
+
+typedef enum nsh_script_opcode {
+    NSH_SCRIPT_OP_END,         ///< Stop the script
+    NSH_SCRIPT_OP_CALL,        ///< Call a command handler
+    NSH_SCRIPT_OP_SET,         ///< Set a variable to the value of an expression
+    NSH_SCRIPT_OP_JUMP,        ///< Continue at the target instruction
+    NSH_SCRIPT_OP_JUMP_UNLESS, ///< Continue at the target instruction if the expression value is 0
+    NSH_SCRIPT_OP_NEXT,        ///< Increment the variable and continue at the target instruction, unless past the bound
+} nsh_script_opcode_t;
+
+typedef enum nsh_script_operand_kind {
+    NSH_SCRIPT_OPERAND_INTEGER,
+    NSH_SCRIPT_OPERAND_VARIABLE,
+} nsh_script_operand_kind_t;
+
+typedef enum nsh_script_operator {
+    NSH_SCRIPT_OPERATOR_NONE, ///< The expression is a single operand
+    NSH_SCRIPT_OPERATOR_ADD,
+    NSH_SCRIPT_OPERATOR_SUB,
+    NSH_SCRIPT_OPERATOR_MUL,
+    NSH_SCRIPT_OPERATOR_DIV,
+    NSH_SCRIPT_OPERATOR_MOD,
+    NSH_SCRIPT_OPERATOR_EQ,
+    NSH_SCRIPT_OPERATOR_NE,
+    NSH_SCRIPT_OPERATOR_LT,
+    NSH_SCRIPT_OPERATOR_LE,
+    NSH_SCRIPT_OPERATOR_GT,
+    NSH_SCRIPT_OPERATOR_GE,
+} nsh_script_operator_t;
+
+typedef struct nsh_script_operand {
+    uint8_t kind;
+    int32_t value; ///< Integer, or index of the variable
+} nsh_script_operand_t;
+
+typedef struct nsh_script_instruction {
+    uint8_t opcode;
+    uint8_t op;              ///< Operator of the expression
+    uint8_t variable;        ///< Variable set by NSH_SCRIPT_OP_SET or NSH_SCRIPT_OP_NEXT
+    uint8_t argc;            ///< Number of arguments of NSH_SCRIPT_OP_CALL
+    bool has_variable_args;  ///< Some arguments of NSH_SCRIPT_OP_CALL are replaced by variable values
+    uint16_t target;         ///< Instruction jumped to, or first argument of NSH_SCRIPT_OP_CALL
+    union {
+        nsh_cmd_handler_t* handler;
+        uint8_t bound; ///< Variable holding the bound of NSH_SCRIPT_OP_NEXT
+        struct {
+            nsh_script_operand_t lhs;
+            nsh_script_operand_t rhs;
+        } expr;
+    } u;
+} nsh_script_instruction_t;
+
+/**
+ * @brief Variable of an argument which is not replaced by a variable value.
+ */
+#define NSH_SCRIPT_NO_VARIABLE UINT8_MAX
+
+/**
+ * @brief Variable holding the status of the last command, "$?".
+ */
+#define NSH_SCRIPT_STATUS_VARIABLE NSH_SCRIPT_MAX_VARIABLES
+
+typedef struct nsh_script {
+    nsh_script_instruction_t code[NSH_SCRIPT_MAX_INSTRUCTIONS];
+    unsigned int code_size;
+    uint16_t args[NSH_SCRIPT_MAX_ARGS]; ///< Arguments of the calls, as offsets into 'pool'
+    uint8_t arg_variables[NSH_SCRIPT_MAX_ARGS]; ///< Variable replacing each argument
+    unsigned int arg_count;
+    char pool[NSH_SCRIPT_STRING_POOL_SIZE];
+    unsigned int pool_size;
+    char variable_names[NSH_SCRIPT_MAX_VARIABLES][NSH_MAX_STRING_SIZE]; ///< Empty for the hidden variables
+    int32_t variables[NSH_SCRIPT_MAX_VARIABLES + 1]; ///< Followed by NSH_SCRIPT_STATUS_VARIABLE
+    unsigned int variable_count;
+    unsigned int error_statement; ///< Statement where the compilation failed, from 1
+    const char* error;            ///< Reason why the compilation or the run failed, null if none
+} nsh_script_t;
+
+/**
+ * @brief Compile 'source' into 'script', resolving its commands in the command table of 'nsh'.
+ *
+ * Unknown commands are resolved to the command-not-found handler of 'nsh' if
+ * there is one. On failure, 'script' holds the statement and the reason, and
+ * running it does nothing.
+ * @return NSH_STATUS_WRONG_ARG on a syntax error, NSH_STATUS_CMD_NOT_FOUND if a
+ * command is unknown, NSH_STATUS_BUFFER_OVERFLOW if the script does not fit.
+ */
+nsh_status_t nsh_script_compile(nsh_script_t* script, const struct nsh_s* nsh, const char* source)
+    NSH_NON_NULL(1, 2, 3);
+
+/**
+ * @brief Run a compiled script, its commands getting 'ctx'.
+ *
+ * The variables start at 0. The commands are called directly, without
+ * pipes, redirections nor jobs. The handlers must not modify the strings of
+ * their arguments, which are reused by each call.
+ * @return The status of the last command, NSH_STATUS_CANCELLED if the script
+ * was cancelled through 'ctx', NSH_STATUS_QUIT as soon as a command returns it,
+ * or NSH_STATUS_WRONG_ARG on a division by zero, 'error' holding the reason.
+ */
+nsh_status_t nsh_script_run(nsh_script_t* script, nsh_cmd_ctx_t* ctx) NSH_NON_NULL(1, 2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_SCRIPTS == 1
+
+#endif // NSH_SCRIPT_H_
@@ -0,0 +1,30 @@
+#ifndef NSH_SPAWN_POSIX_H_
+#define NSH_SPAWN_POSIX_H_
+
+#include <nsh/nsh.h>
+
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run argv[0] as a program searched in the PATH, to give to nsh_set_command_not_found_handler().
+ *
+ * The program is launched with posix_spawnp(), its standard input reading /dev/null.
+ * Its standard output and error are written to the output of the shell, '\n' becoming "\r\n".
+ * If the command is cancelled, its output stops being read and the program is terminated with SIGTERM,
+ * then killed with SIGKILL if it is still running 200 ms later.
+ * Return NSH_STATUS_CMD_NOT_FOUND if the program does not exist, NSH_STATUS_CANCELLED if the command is
+ * cancelled, NSH_STATUS_FAILURE if the program cannot be launched or does not exit with 0.
+ */
+nsh_status_t nsh_posix_spawn_command(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv) NSH_NON_NULL(1, 3);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+
+#endif // NSH_SPAWN_POSIX_H_
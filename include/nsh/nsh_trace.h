@@ -0,0 +1,122 @@
+#ifndef NSH_TRACE_H_
+#define NSH_TRACE_H_
+
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_config.h>
+
+#if NSH_FEATURE_USE_TRACE == 1
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Phases of the processing of a command line.
+ */
+typedef enum nsh_trace_phase {
+    NSH_TRACE_PHASE_READ,    ///< Waiting for an input byte from the I/O backend
+    NSH_TRACE_PHASE_ECHO,    ///< Echoing a typed character into the line
+    NSH_TRACE_PHASE_SPLIT,   ///< Splitting the line into arguments
+    NSH_TRACE_PHASE_LOOKUP,  ///< Finding the command to execute
+    NSH_TRACE_PHASE_HANDLER, ///< Running the handler of the command
+    NSH_TRACE_PHASE_FLUSH,   ///< Writing the buffered output to the I/O backend
+    NSH_TRACE_PHASE_COUNT,
+} nsh_trace_phase_t;
+
+/**
+ * @brief Clock timestamping the trace records, wrapping around at UINT32_MAX.
+ */
+typedef uint32_t nsh_trace_clock_t(void);
+
+/**
+ * @brief Time spent in a phase, in ticks of the trace clock.
+ */
+typedef struct nsh_trace_record {
+    const void* instance; ///< I/O of the shell, job or pipe stage which made the record
+    uint32_t start;
+    uint32_t duration;
+    uint8_t phase;
+} nsh_trace_record_t;
+
+/**
+ * @brief Ring of the last trace records of a shell, given to it with nsh_set_trace().
+ */
+typedef struct nsh_trace {
+    nsh_trace_record_t ring[NSH_TRACE_RING_SIZE];
+    unsigned int head; ///< Free-running index of the next record
+    nsh_trace_clock_t* clock; ///< Null while the trace is stopped
+    uint32_t frequency_hz;
+} nsh_trace_t;
+
+/**
+ * @brief Clear the trace and start recording, timestamped by 'clock' ticking at 'frequency_hz'.
+ *
+ * A frequency of 0 means that 'clock' ticks every microsecond.
+ */
+void nsh_trace_start(nsh_trace_t* trace, nsh_trace_clock_t* clock, uint32_t frequency_hz) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Stop recording, keeping the records.
+ */
+void nsh_trace_stop(nsh_trace_t* trace) NSH_NON_NULL(1);
+
+/**
+ * @brief Current time of the trace clock, or 0 if 'trace' is null or stopped.
+ */
+uint32_t nsh_trace_now(const nsh_trace_t* trace);
+
+/**
+ * @brief Record the time spent by 'instance' in 'phase' since 'start', if 'trace' is not null and started.
+ *
+ * Can be called from several threads, a record being reserved atomically.
+ */
+void nsh_trace_push(nsh_trace_t* trace, const void* instance, nsh_trace_phase_t phase, uint32_t start);
+
+/**
+ * @brief Number of records kept, at most NSH_TRACE_RING_SIZE.
+ */
+unsigned int nsh_trace_count(const nsh_trace_t* trace) NSH_NON_NULL(1);
+
+/**
+ * @brief Number of records overwritten since the trace was started.
+ */
+unsigned int nsh_trace_overwritten_count(const nsh_trace_t* trace) NSH_NON_NULL(1);
+
+/**
+ * @brief The record at 'index', the oldest record being at index 0.
+ */
+const nsh_trace_record_t* nsh_trace_get(const nsh_trace_t* trace, unsigned int index) NSH_NON_NULL(1);
+
+/**
+ * @brief Frequency of the trace clock, in Hz.
+ */
+uint32_t nsh_trace_frequency(const nsh_trace_t* trace) NSH_NON_NULL(1);
+
+const char* nsh_trace_phase_name(nsh_trace_phase_t phase);
+
+/**
+ * @def NSH_TRACE_BEGIN(<io>, <phase>)
+ * @def NSH_TRACE_END(<io>, <phase>)
+ * @brief Trace the time spent between the two points, in the same block, as the phase NSH_TRACE_PHASE_<phase>.
+ *
+ * The record goes to the trace of 'io', an nsh_io_t, and names it. Both compile
+ * to nothing if NSH_FEATURE_USE_TRACE is disabled.
+ */
+#define NSH_TRACE_BEGIN(io, phase) const uint32_t nsh_trace_start_##phase = nsh_trace_now((io)->trace)
+#define NSH_TRACE_END(io, phase)                                                                                       \
+    nsh_trace_push((io)->trace, (io), NSH_TRACE_PHASE_##phase, nsh_trace_start_##phase)
+
+#ifdef __cplusplus
+}
+#endif
+
+#else
+
+#define NSH_TRACE_BEGIN(io, phase) ((void)0)
+#define NSH_TRACE_END(io, phase)   ((void)0)
+
+#endif // NSH_FEATURE_USE_TRACE == 1
+
+#endif // NSH_TRACE_H_
@@ -0,0 +1,38 @@
+#ifndef NSH_TRACE_CHROME_H_
+#define NSH_TRACE_CHROME_H_
+
+#include <nsh/nsh_common_defs.h>
+#include <nsh/nsh_trace.h>
+
+#if NSH_FEATURE_USE_TRACE == 1
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Write the trace records in the Chrome trace event format, to open with Perfetto or chrome://tracing.
+ *
+ * Each record is written as a complete event, the timestamps being relative to
+ * the earliest start of a record. The events are attributed to the current process, each
+ * instance being one of its threads, identified by the position of its oldest
+ * record plus one. Stop the trace first, the records being overwritten while
+ * it is recording.
+ * Return NSH_STATUS_FAILURE if 'file' cannot be written.
+ */
+nsh_status_t nsh_trace_export_chrome(const nsh_trace_t* trace, FILE* file) NSH_NON_NULL(1, 2);
+
+/**
+ * @brief Same as nsh_trace_export_chrome(), into the file at 'path'.
+ */
+nsh_status_t nsh_trace_export_chrome_to_path(const nsh_trace_t* trace, const char* path) NSH_NON_NULL(1, 2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_TRACE == 1
+
+#endif // NSH_TRACE_CHROME_H_
@@ -112,3 +112,4 @@ stm32_target_flash_file(${PROJECT_SOURCE_DIR}/bin/Nucleo_blink_led.NUCLEO_F411RE
 
 add_subdirectory(${CMAKE_CURRENT_LIST_DIR}/gtest-main)
 add_subdirectory(${CMAKE_CURRENT_LIST_DIR}/tools-main)
+add_subdirectory(${CMAKE_CURRENT_LIST_DIR}/flash-history-storage)
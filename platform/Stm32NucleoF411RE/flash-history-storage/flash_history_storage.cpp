@@ -0,0 +1,150 @@
+#include "flash_history_storage.h"
+
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+
+#include "stm32f4xx_hal.h"
+
+#include <cstring>
+
+namespace {
+
+struct FlashSector {
+    uint32_t number;
+    uint32_t address;
+};
+
+constexpr FlashSector flash_sectors[] = {
+    { FLASH_SECTOR_6, 0x08040000u },
+    { FLASH_SECTOR_7, 0x08060000u },
+};
+constexpr uint32_t flash_sector_size = 128u * 1024u;
+constexpr uint32_t flash_sector_header_size = sizeof(uint32_t);
+constexpr uint32_t flash_log_capacity = flash_sector_size - flash_sector_header_size;
+constexpr uint32_t flash_erased_word = 0xFFFFFFFFu;
+constexpr uint8_t flash_erased_byte = 0xFFu;
+
+const uint8_t* log_begin(const nsh_stm32_flash_log_t* flash_log)
+{
+    return reinterpret_cast<const uint8_t*>(flash_sectors[flash_log->active].address + flash_sector_header_size);
+}
+
+uint32_t sector_sequence(unsigned int sector)
+{
+    uint32_t sequence;
+    std::memcpy(&sequence, reinterpret_cast<const void*>(flash_sectors[sector].address), sizeof(sequence));
+    return sequence;
+}
+
+// Walk the records from the beginning of the log, as commands may contain erased bytes
+uint32_t log_end(const uint8_t* begin)
+{
+    uint32_t offset = 0;
+    while (offset + NSH_HISTORY_LOG_RECORD_HEADER_SIZE <= flash_log_capacity && begin[offset] != flash_erased_byte) {
+        uint32_t next = offset + NSH_HISTORY_LOG_RECORD_HEADER_SIZE + begin[offset + 1];
+        if (begin[offset] != NSH_HISTORY_LOG_RECORD_MAGIC || next > flash_log_capacity) {
+            // Corrupted record, rewritten by the next load: append after its last programmed byte
+            uint32_t end = flash_log_capacity;
+            while (end > offset && begin[end - 1] == flash_erased_byte) {
+                end--;
+            }
+            return end;
+        }
+        offset = next;
+    }
+    return offset;
+}
+
+unsigned int flash_read(void* ctx, unsigned int offset, void* data, unsigned int size)
+{
+    auto* flash_log = static_cast<nsh_stm32_flash_log_t*>(ctx);
+    if (offset >= flash_log_capacity) {
+        return 0;
+    }
+    if (size > flash_log_capacity - offset) {
+        size = flash_log_capacity - offset;
+    }
+    // The Flash is memory-mapped
+    std::memcpy(data, log_begin(flash_log) + offset, size);
+    return size;
+}
+
+nsh_status_t flash_append(void* ctx, const void* data, unsigned int size)
+{
+    auto* flash_log = static_cast<nsh_stm32_flash_log_t*>(ctx);
+    if (flash_log->write_offset + size > flash_log_capacity) {
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+
+    uint32_t address = flash_sectors[flash_log->active].address + flash_sector_header_size + flash_log->write_offset;
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    HAL_StatusTypeDef status = HAL_FLASH_Unlock();
+    for (unsigned int i = 0; i < size && status == HAL_OK; i++) {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, address + i, bytes[i]);
+    }
+    HAL_FLASH_Lock();
+
+    // Even on failure, the bytes may have been partially written
+    flash_log->write_offset += size;
+    return (status == HAL_OK) ? NSH_STATUS_OK : NSH_STATUS_FAILURE;
+}
+
+nsh_status_t flash_rotate(void* ctx)
+{
+    auto* flash_log = static_cast<nsh_stm32_flash_log_t*>(ctx);
+    unsigned int next = (flash_log->active + 1u) % 2u;
+
+    FLASH_EraseInitTypeDef erase_init {};
+    erase_init.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase_init.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    erase_init.Sector = flash_sectors[next].number;
+    erase_init.NbSectors = 1;
+    uint32_t sector_error = 0;
+
+    HAL_StatusTypeDef status = HAL_FLASH_Unlock();
+    if (status == HAL_OK) {
+        status = HAL_FLASHEx_Erase(&erase_init, &sector_error);
+    }
+    if (status == HAL_OK) {
+        // Writing the sequence number last makes the new sector valid only once erased
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, flash_sectors[next].address, flash_log->sequence + 1u);
+    }
+    HAL_FLASH_Lock();
+
+    if (status != HAL_OK) {
+        return NSH_STATUS_FAILURE;
+    }
+
+    flash_log->active = next;
+    flash_log->sequence++;
+    flash_log->write_offset = 0;
+    return NSH_STATUS_OK;
+}
+
+} // namespace
+
+extern "C" nsh_status_t nsh_stm32_flash_history_storage_init(nsh_history_storage_t* storage,
+    nsh_stm32_flash_log_t* flash_log)
+{
+    storage->read = flash_read;
+    storage->append = flash_append;
+    storage->rotate = flash_rotate;
+    storage->ctx = flash_log;
+
+    // The active sector is the valid one with the highest sequence number
+    uint32_t sequences[] = { sector_sequence(0), sector_sequence(1) };
+    bool valid[] = { sequences[0] != flash_erased_word, sequences[1] != flash_erased_word };
+    if (!valid[0] && !valid[1]) {
+        // First use, start a log in sector 0
+        flash_log->active = 1;
+        flash_log->sequence = 0;
+        return flash_rotate(flash_log);
+    }
+    flash_log->active = (valid[1] && (!valid[0] || sequences[1] > sequences[0])) ? 1u : 0u;
+    flash_log->sequence = sequences[flash_log->active];
+
+    flash_log->write_offset = log_end(log_begin(flash_log));
+
+    return NSH_STATUS_OK;
+}
+
+#endif // NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
@@ -0,0 +1,36 @@
+#ifndef NSH_STM32_FLASH_HISTORY_STORAGE_H_
+#define NSH_STM32_FLASH_HISTORY_STORAGE_H_
+
+#include <nsh/nsh_history_log.h>
+
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * History storage using the two last 128KB sectors of the STM32F411RE Flash
+ * (sectors 6 and 7, 0x08040000-0x0807FFFF), which must be kept out of the
+ * program by the linker script.
+ * The log is appended to the active sector. When it is full, the other sector
+ * is erased and becomes the active one, so both sectors wear evenly.
+ * Each sector starts with a 32-bit sequence number identifying the most recent one.
+ */
+typedef struct nsh_stm32_flash_log {
+    unsigned int active;   ///< Index of the sector holding the log
+    uint32_t sequence;     ///< Sequence number of the active sector
+    uint32_t write_offset; ///< Offset of the end of the log in the active sector
+} nsh_stm32_flash_log_t;
+
+nsh_status_t nsh_stm32_flash_history_storage_init(nsh_history_storage_t* storage, nsh_stm32_flash_log_t* flash_log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+
+#endif // NSH_STM32_FLASH_HISTORY_STORAGE_H_
@@ -1,5 +1,8 @@
 #include "stm32f4xx_hal.h"
 
+#include <nsh/nsh_cycle_counter_dwt.h>
+#include <nsh/nsh_io_dma.h>
+
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
@@ -10,7 +13,41 @@ namespace nsh::tools {
 extern int main(int argc, char* argv[]);
 }
 
+/*
+ * The default baud rate of the ST-Link virtual COM port. The DMA transfers
+ * sustain full-rate input and output up to 921600 bauds.
+ */
+#ifndef NSH_STM32_UART_BAUD_RATE
+#define NSH_STM32_UART_BAUD_RATE 115200
+#endif
+
 static UART_HandleTypeDef UartHandle;
+static DMA_HandleTypeDef UartTxDmaHandle;
+static DMA_HandleTypeDef UartRxDmaHandle;
+
+/*
+ * Output double-buffered and sent by DMA, and input received by a circular DMA
+ * into a ring read by the shell. The CPU is only interrupted once per transfer,
+ * or once per idle line on reception, instead of once per byte.
+ */
+static nsh_io_dma_t UartDma;
+static char UartRxDmaBuffer[64];
+
+static void uart_dma_start_tx(void* ctx, const char* data, unsigned int size)
+{
+    HAL_UART_Transmit_DMA(&UartHandle, (uint8_t*)data, (uint16_t)size);
+}
+
+static void uart_dma_idle(void* ctx)
+{
+    __WFI(); // Sleep until the next DMA or UART interrupt (or SysTick)
+}
+
+static const nsh_io_dma_driver_t UartDmaDriver = {
+    .start_tx = uart_dma_start_tx,
+    .idle = uart_dma_idle,
+    .ctx = NULL,
+};
 
 static void BSP_LED2_Init();
 static void BSP_LED2_DeInit();
@@ -24,10 +61,11 @@ int main(void)
 {
     HAL_Init();
     SystemClock_Config();
+    nsh_dwt_cycle_counter_enable(); // Available to the tools measuring the commands latency
     BSP_LED2_Init();
 
     UartHandle.Instance = USART2;
-    UartHandle.Init.BaudRate = 115200;
+    UartHandle.Init.BaudRate = NSH_STM32_UART_BAUD_RATE;
     UartHandle.Init.WordLength = UART_WORDLENGTH_8B;
     UartHandle.Init.StopBits = UART_STOPBITS_1;
     UartHandle.Init.Parity = UART_PARITY_NONE;
@@ -39,7 +77,14 @@ int main(void)
         Error_Handler();
     }
 
+    // Receive continuously, the bytes being pushed into the ring on each idle line
+    nsh_io_dma_init(&UartDma, &UartDmaDriver);
+    if (HAL_UARTEx_ReceiveToIdle_DMA(&UartHandle, (uint8_t*)UartRxDmaBuffer, sizeof(UartRxDmaBuffer)) != HAL_OK) {
+        Error_Handler();
+    }
+
     auto error = nsh::tools::main(0, NULL);
+    nsh_io_dma_flush(&UartDma);
 
     if (error) {
         Error_Handler();
@@ -178,7 +223,8 @@ extern "C" {
  */
 int __io_putchar(int ch)
 {
-    HAL_UART_Transmit(&UartHandle, (uint8_t*)&ch, 1, 0xFFFF);
+    char c = (char)ch;
+    nsh_io_dma_backend.write(&UartDma, &c, 1);
     return ch;
 }
 
@@ -189,12 +235,50 @@ int __io_putchar(int ch)
  */
 int __io_getchar(void)
 {
-    HAL_StatusTypeDef status = HAL_BUSY;
-    uint8_t ch;
-    while (status != HAL_OK) {
-        status = HAL_UART_Receive(&UartHandle, &ch, 1, 10);
-    }
-    return ch;
+    return nsh_io_dma_backend.read(&UartDma);
+}
+
+/**
+ * @brief  Start sending the next buffered output, if any.
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart)
+{
+    nsh_io_dma_tx_complete(&UartDma);
+}
+
+/**
+ * @brief  Push the bytes received since the last event (idle line, half or full
+ *         transfer) into the receive ring.
+ */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t Size)
+{
+    nsh_io_dma_rx_update(&UartDma, UartRxDmaBuffer, sizeof(UartRxDmaBuffer), Size);
+}
+
+/**
+ * @brief  Count the bytes lost by the UART itself (overrun error), and restart
+ *         the reception stopped by the HAL.
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
+{
+    nsh_rx_ring_add_overruns(&UartDma.rx, 1);
+    UartDma.rx_position = 0;
+    HAL_UARTEx_ReceiveToIdle_DMA(&UartHandle, (uint8_t*)UartRxDmaBuffer, sizeof(UartRxDmaBuffer));
+}
+
+void DMA1_Stream5_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&UartRxDmaHandle);
+}
+
+void DMA1_Stream6_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&UartTxDmaHandle);
+}
+
+void USART2_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(&UartHandle);
 }
 
 /**
@@ -216,6 +300,9 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
     /* Enable USARTx clock */
     __HAL_RCC_USART2_CLK_ENABLE();
 
+    /* Enable DMA clock */
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
     /*##-2- Configure peripheral GPIO ##########################################*/
     /* UART TX GPIO pin configuration  */
     GPIO_InitStruct.Pin = GPIO_PIN_2;
@@ -231,6 +318,42 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
     GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
 
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    /*##-3- Configure the DMA ##################################################*/
+    /* USART2 TX is DMA1 stream 6 channel 4, sent once per buffer */
+    UartTxDmaHandle.Instance = DMA1_Stream6;
+    UartTxDmaHandle.Init.Channel = DMA_CHANNEL_4;
+    UartTxDmaHandle.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    UartTxDmaHandle.Init.PeriphInc = DMA_PINC_DISABLE;
+    UartTxDmaHandle.Init.MemInc = DMA_MINC_ENABLE;
+    UartTxDmaHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    UartTxDmaHandle.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    UartTxDmaHandle.Init.Mode = DMA_NORMAL;
+    UartTxDmaHandle.Init.Priority = DMA_PRIORITY_LOW;
+    UartTxDmaHandle.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&UartTxDmaHandle) != HAL_OK) {
+        Error_Handler();
+    }
+    __HAL_LINKDMA(huart, hdmatx, UartTxDmaHandle);
+
+    /* USART2 RX is DMA1 stream 5 channel 4, received continuously */
+    UartRxDmaHandle.Instance = DMA1_Stream5;
+    UartRxDmaHandle.Init = UartTxDmaHandle.Init;
+    UartRxDmaHandle.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    UartRxDmaHandle.Init.Mode = DMA_CIRCULAR;
+    UartRxDmaHandle.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&UartRxDmaHandle) != HAL_OK) {
+        Error_Handler();
+    }
+    __HAL_LINKDMA(huart, hdmarx, UartRxDmaHandle);
+
+    /*##-4- Configure the NVIC #################################################*/
+    HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 1, 1);
+    HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+    HAL_NVIC_SetPriority(USART2_IRQn, 1, 2);
+    HAL_NVIC_EnableIRQ(USART2_IRQn);
 }
 
 /**
@@ -252,6 +375,13 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
     HAL_GPIO_DeInit(GPIOA, GPIO_PIN_2);
     /* Configure UART Rx as alternate function  */
     HAL_GPIO_DeInit(GPIOA, GPIO_PIN_3);
+
+    /*##-3- Disable the DMA and NVIC ############################################*/
+    HAL_DMA_DeInit(huart->hdmatx);
+    HAL_DMA_DeInit(huart->hdmarx);
+    HAL_NVIC_DisableIRQ(DMA1_Stream5_IRQn);
+    HAL_NVIC_DisableIRQ(DMA1_Stream6_IRQn);
+    HAL_NVIC_DisableIRQ(USART2_IRQn);
 }
 
 /**
@@ -412,11 +542,8 @@ void _exit(int status)
 
 int _write(int file, char* ptr, int len)
 {
-    int DataIdx;
-
-    for (DataIdx = 0; DataIdx < len; DataIdx++) {
-        __io_putchar(*ptr++);
-    }
+    // Only blocks when both transmit buffers are full
+    nsh_io_dma_backend.write(&UartDma, ptr, (unsigned int)len);
     return len;
 }
 
@@ -443,13 +570,13 @@ int _lseek(int file, int ptr, int dir)
 
 int _read(int file, char* ptr, int len)
 {
-    int DataIdx;
-
-    for (DataIdx = 0; DataIdx < len; DataIdx++) {
-        *ptr++ = __io_getchar();
+    if (len <= 0) {
+        return 0;
     }
 
-    return len;
+    // Wait for the first byte, then drain all the bytes already received
+    *ptr = (char)__io_getchar();
+    return 1 + (int)nsh_rx_ring_pop(&UartDma.rx, ptr + 1, (unsigned int)len - 1u);
 }
 
 int _open(char* path, int flags, ...)
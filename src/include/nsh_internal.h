@@ -0,0 +1,36 @@
+#ifndef NSH_INTERNAL_H_
+#define NSH_INTERNAL_H_
+
+/*
+ * Functions private to the Nsh library, exposed to its benchmarks and tests.
+ */
+
+#include <nsh/nsh.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Split 'str' into at most 'max_token_count' tokens separated by 'sep', copied into 'output'.
+ *
+ * Return NSH_STATUS_BUFFER_OVERFLOW if a token is too long, and
+ * NSH_STATUS_MAX_ARGS_NB_REACH if there are too many tokens.
+ */
+nsh_status_t nsh_split_command_line(const char* str, char sep, char output[][NSH_MAX_STRING_SIZE],
+    unsigned int* token_count, unsigned int max_token_count)
+    NSH_NON_NULL(1, 3, 4);
+
+#if NSH_FEATURE_USE_AUTOCOMPLETION == 1
+/**
+ * @brief Display the commands starting with the line being typed, then redraw the line.
+ */
+nsh_status_t nsh_autocomplete(nsh_t* nsh)
+    NSH_NON_NULL(1);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_INTERNAL_H_
@@ -2,26 +2,92 @@
 #include <nsh/nsh_cmd_builtins.h>
 #include <nsh/nsh_common_defs.h>
 #include <nsh/nsh_io_plugin.h>
+#include <nsh/nsh_mem.h>
+#include <nsh/nsh_pipe.h>
+#include <nsh/nsh_redirect.h>
+#include <nsh/nsh_trace.h>
+
+#include "nsh_internal.h"
 
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+typedef struct nsh_builtin {
+    const char* name;
+    nsh_cmd_handler_t* handler;
+} nsh_builtin_t;
+
+// Commands registered by every shell instance
+static const nsh_builtin_t nsh_builtins[] = {
+    { "help", cmd_builtin_help },
+    { "exit", cmd_builtin_exit },
+    { "version", cmd_builtin_version },
+#if NSH_FEATURE_USE_JOBS == 1
+    { "jobs", cmd_builtin_jobs },
+    { "fg", cmd_builtin_fg },
+    { "kill", cmd_builtin_kill },
+#endif
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    { "stats", cmd_builtin_stats },
+#endif
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+    { "mem", cmd_builtin_mem },
+#endif
+#if NSH_FEATURE_USE_SCRIPTS == 1
+    { "script", cmd_builtin_script },
+#endif
+};
+
+#define NSH_BUILTIN_COUNT (sizeof(nsh_builtins) / sizeof(nsh_builtins[0]))
+
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+#define NSH_ARGS_MAX_COUNT(nsh) ((nsh)->args_max_count)
+#else
+#define NSH_ARGS_MAX_COUNT(nsh) NSH_CMD_ARGS_MAX_COUNT
+#endif
+
 static nsh_status_t nsh_copy_token(const char* str, char output[][NSH_MAX_STRING_SIZE], unsigned int* token_count,
-    unsigned int token_size)
+    unsigned int max_token_count, unsigned int token_size)
     NSH_NON_NULL(1, 2, 3);
 
-static nsh_status_t nsh_split_command_line(const char* str, char sep, char output[][NSH_MAX_STRING_SIZE],
-    unsigned int* token_count)
-    NSH_NON_NULL(1, 3, 4);
+static nsh_status_t nsh_setup(nsh_t* nsh)
+    NSH_NON_NULL(1);
+
+static nsh_status_t nsh_execute(nsh_t* nsh, nsh_io_t* io, unsigned int argc, char** argv)
+    NSH_NON_NULL(1, 2);
 
-static nsh_status_t nsh_execute(const nsh_t* nsh, unsigned int argc, char** argv)
+static nsh_status_t nsh_execute_in_foreground(nsh_t* nsh, unsigned int argc, char** argv)
     NSH_NON_NULL(1);
 
-#if NSH_FEATURE_USE_AUTOCOMPLETION == 1
+#if NSH_FEATURE_USE_JOBS == 1
+
+static bool nsh_strip_background_operator(unsigned int* argc, char** argv)
+    NSH_NON_NULL(1, 2);
+
+static nsh_status_t nsh_execute_in_background(nsh_t* nsh, unsigned int argc, char** argv)
+    NSH_NON_NULL(1, 3);
+
+#endif
 
-static nsh_status_t nsh_autocomplete(const nsh_t* nsh)
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+
+static void nsh_display_log_messages(nsh_t* nsh)
+    NSH_NON_NULL(1);
+
+#endif
+
+#if NSH_FEATURE_USE_JOBS == 1 || NSH_FEATURE_USE_ASYNC_LOG == 1
+
+static bool nsh_has_news(nsh_t* nsh)
+    NSH_NON_NULL(1);
+
+static void nsh_display_news(nsh_t* nsh)
+    NSH_NON_NULL(1);
+
+static void nsh_wait_input(nsh_t* nsh)
     NSH_NON_NULL(1);
 
 #endif
@@ -31,6 +97,12 @@ static nsh_status_t nsh_autocomplete(const nsh_t* nsh)
 static void nsh_display_history_entry(nsh_t* nsh)
     NSH_NON_NULL(1);
 
+static void nsh_take_history_entry(nsh_t* nsh)
+    NSH_NON_NULL(1);
+
+static void nsh_find_history_candidates(nsh_t* nsh)
+    NSH_NON_NULL(1);
+
 static nsh_status_t nsh_display_previous_entry(nsh_t* nsh)
     NSH_NON_NULL(1);
 
@@ -39,6 +111,17 @@ static nsh_status_t nsh_display_next_entry(nsh_t* nsh)
 
 #endif
 
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+
+static void nsh_display_search_state(nsh_t* nsh, const char* pattern, unsigned int pattern_size,
+    unsigned int match)
+    NSH_NON_NULL(1, 2);
+
+static bool nsh_reverse_search(nsh_t* nsh)
+    NSH_NON_NULL(1);
+
+#endif
+
 static nsh_status_t nsh_handle_escape_sequence(nsh_t* nsh)
     NSH_NON_NULL(1);
 
@@ -52,7 +135,7 @@ static nsh_status_t nsh_read_line(nsh_t* nsh)
     NSH_NON_NULL(1);
 
 static nsh_status_t nsh_copy_token(const char* str, char output[][NSH_MAX_STRING_SIZE], unsigned int* token_count,
-    unsigned int token_size)
+    unsigned int max_token_count, unsigned int token_size)
 {
     if (token_size > NSH_MAX_STRING_SIZE - 1) // Keep one char for '\0'
     {
@@ -62,15 +145,15 @@ static nsh_status_t nsh_copy_token(const char* str, char output[][NSH_MAX_STRING
     memcpy(output[*token_count], str, token_size);
     output[*token_count][token_size] = '\0';
     (*token_count)++;
-    if (*token_count >= NSH_CMD_ARGS_MAX_COUNT) {
+    if (*token_count >= max_token_count) {
         // nsh_io_put_string("WARNING: too many arguments\r\n");
         return NSH_STATUS_MAX_ARGS_NB_REACH;
     }
     return NSH_STATUS_OK;
 }
 
-static nsh_status_t nsh_split_command_line(const char* str, char sep, char output[][NSH_MAX_STRING_SIZE],
-    unsigned int* token_count)
+nsh_status_t nsh_split_command_line(const char* str, char sep, char output[][NSH_MAX_STRING_SIZE],
+    unsigned int* token_count, unsigned int max_token_count)
 {
     unsigned int beg = 0;
     unsigned int end = 0;
@@ -81,7 +164,7 @@ static nsh_status_t nsh_split_command_line(const char* str, char sep, char outpu
     for (unsigned int i = 0; i < input_size; i++) {
         if (str[i] == sep) {
             end = i;
-            nsh_status_t ret = nsh_copy_token(&str[beg], output, token_count, end - beg);
+            nsh_status_t ret = nsh_copy_token(&str[beg], output, token_count, max_token_count, end - beg);
             if (ret != NSH_STATUS_OK) { // If an error is detected during copy, abort split and return the error code
                 return ret;
             }
@@ -91,10 +174,10 @@ static nsh_status_t nsh_split_command_line(const char* str, char sep, char outpu
     }
 
     // Parse the last token and return the status of the copy
-    return nsh_copy_token(&str[beg], output, token_count, input_size - beg);
+    return nsh_copy_token(&str[beg], output, token_count, max_token_count, input_size - beg);
 }
 
-static nsh_status_t nsh_execute(const nsh_t* nsh, unsigned int argc, char** argv)
+static nsh_status_t nsh_execute(nsh_t* nsh, nsh_io_t* io, unsigned int argc, char** argv)
 {
     if (argv[0] == NULL || argv[0][0] == '\0') {
         // An empty command was entered.
@@ -102,57 +185,330 @@ static nsh_status_t nsh_execute(const nsh_t* nsh, unsigned int argc, char** argv
     }
 
     // Find matching command
+    NSH_TRACE_BEGIN(&nsh->io, LOOKUP);
     const nsh_cmd_t* matching_cmd = nsh_cmd_array_find(&nsh->cmds, argv[0]);
-
-    if (!matching_cmd) {
+    NSH_TRACE_END(&nsh->io, LOOKUP);
+
+    nsh_cmd_handler_t* handler;
+    if (matching_cmd) {
+        handler = matching_cmd->handler;
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+    } else if (nsh->command_not_found_handler) {
+        // Let the handler run the command, an external program for instance
+        handler = nsh->command_not_found_handler;
+#endif
+    } else {
         // If there is no match, return an error
         return NSH_STATUS_CMD_NOT_FOUND;
     }
-    if (!matching_cmd->handler) {
+    if (!handler) {
         // If handler is null, return an error
         return NSH_STATUS_EMPTY_CMD;
     }
 
-    // Execute matching command
-    nsh_status_t status = matching_cmd->handler(argc, argv);
+    // Execute matching command, until it completes or is cancelled
+    nsh_cancel_token_init(&nsh->cancel, nsh->clock, nsh->command_timeout_ms);
+    nsh_cmd_ctx_t ctx = { .nsh = nsh, .io = io, .cancel = &nsh->cancel };
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    uint32_t start = (nsh->cycle_counter != NULL) ? nsh->cycle_counter() : 0;
+#endif
+    NSH_TRACE_BEGIN(&nsh->io, HANDLER);
+    nsh_status_t status = handler(&ctx, argc, argv);
+    NSH_TRACE_END(&nsh->io, HANDLER);
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    uint32_t cycles = (nsh->cycle_counter != NULL) ? nsh->cycle_counter() - start : 0;
+    if (matching_cmd) {
+        nsh_cmd_t* cmd = &nsh->cmds.array[matching_cmd - nsh->cmds.array];
+        nsh_cmd_stats_record(&cmd->stats, cycles, status != NSH_STATUS_OK && status != NSH_STATUS_QUIT);
+    }
+#endif
+    return status;
+}
+
+/*
+ * Execute the command line in the foreground, piping the output of the command
+ * into the filters following it, if any, and redirecting the output into a file
+ * if the command line ends with a redirection.
+ */
+static nsh_status_t nsh_execute_in_foreground(nsh_t* nsh, unsigned int argc, char** argv)
+{
+    nsh_io_t* output = &nsh->io;
+#if NSH_FEATURE_USE_REDIRECTION == 1
+    const char* path;
+    bool append;
+    if (nsh_redirect_parse(&argc, argv, &path, &append) != NSH_STATUS_OK) {
+        nsh_io_put_string(&nsh->io, "ERROR: a redirection must end the command line with a file name\r\n");
+        return NSH_STATUS_WRONG_ARG;
+    }
+#endif
+#if NSH_FEATURE_USE_PIPES == 1
+    // The errors of the filters are displayed, not redirected
+    if (nsh_pipeline_open(&nsh->pipeline, output, &nsh->cancel, &argc, argv) != NSH_STATUS_OK) {
+        return NSH_STATUS_WRONG_ARG;
+    }
+#endif
+#if NSH_FEATURE_USE_REDIRECTION == 1
+    if (path != NULL) {
+        if (nsh_redirect_open(&nsh->redirect, path, append) != NSH_STATUS_OK) {
+            nsh_io_put_string(&nsh->io, "ERROR: cannot open '");
+            nsh_io_put_string(&nsh->io, path);
+            nsh_io_put_string(&nsh->io, "'\r\n");
+#if NSH_FEATURE_USE_PIPES == 1
+            nsh_pipeline_close(&nsh->pipeline);
+#endif
+            return NSH_STATUS_FAILURE;
+        }
+#if NSH_FEATURE_USE_TRACE == 1
+        nsh->redirect.io.trace = nsh->io.trace;
+#endif
+        output = &nsh->redirect.io;
+#if NSH_FEATURE_USE_PIPES == 1
+        nsh_pipeline_set_output(&nsh->pipeline, output);
+#endif
+    }
+#endif
+#if NSH_FEATURE_USE_PIPES == 1
+    output = nsh_pipeline_input(&nsh->pipeline);
+#endif
+
+    nsh_status_t status = nsh_execute(nsh, output, argc, argv);
+
+#if NSH_FEATURE_USE_PIPES == 1
+    // Let the filters process the rest of the output before the next prompt, even if no command ran
+    nsh_pipeline_close(&nsh->pipeline);
+    if (status == NSH_STATUS_CANCELLED && nsh->pipeline.closed) {
+        // The command was stopped since the filters needed no more input
+        status = NSH_STATUS_OK;
+    }
+#endif
 #if NSH_FEATURE_USE_RETURN_CODE_PRINTING == 1
-    nsh_io_printf("command '%s' return %d\r\n", argv[0], status);
+    if (status != NSH_STATUS_EMPTY_CMD && status != NSH_STATUS_CMD_NOT_FOUND) {
+        nsh_io_printf(&nsh->io, "command '%s' return %d\r\n", argv[0], status);
+    }
+#endif
+#if NSH_FEATURE_USE_REDIRECTION == 1
+    // The buffered output is written into the file once the command completes
+    if (path != NULL && nsh_redirect_close(&nsh->redirect) != NSH_STATUS_OK) {
+        nsh_io_put_string(&nsh->io, "ERROR: cannot write '");
+        nsh_io_put_string(&nsh->io, path);
+        nsh_io_put_string(&nsh->io, "'\r\n");
+        if (status == NSH_STATUS_OK) {
+            status = NSH_STATUS_FAILURE;
+        }
+    }
 #endif
     return status;
 }
 
-#if NSH_FEATURE_USE_AUTOCOMPLETION == 1
+#if NSH_FEATURE_USE_JOBS == 1
+
+/*
+ * Remove the trailing '&' of the command line, either as a separate argument or
+ * at the end of the last one. Return true if it was found.
+ */
+static bool nsh_strip_background_operator(unsigned int* argc, char** argv)
+{
+    if (*argc == 0) {
+        return false;
+    }
+    char* last_arg = argv[*argc - 1];
+    size_t last_arg_size = strlen(last_arg);
+    if (last_arg_size == 0 || last_arg[last_arg_size - 1] != '&') {
+        return false;
+    }
+    if (last_arg_size == 1) {
+        (*argc)--;
+    } else {
+        last_arg[last_arg_size - 1] = '\0';
+    }
+    return true;
+}
+
+static nsh_status_t nsh_execute_in_background(nsh_t* nsh, unsigned int argc, char** argv)
+{
+    if (argc == 0 || argv[0][0] == '\0') {
+        return NSH_STATUS_EMPTY_CMD;
+    }
+
+#if NSH_FEATURE_USE_PIPES == 1
+    for (unsigned int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], NSH_PIPE_OPERATOR) == 0) {
+            nsh_io_put_string(&nsh->io, "ERROR: pipelines cannot run in the background\r\n");
+            return NSH_STATUS_UNSUPPORTED;
+        }
+    }
+#endif
+#if NSH_FEATURE_USE_REDIRECTION == 1
+    for (unsigned int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], NSH_REDIRECT_OPERATOR) == 0 || strcmp(argv[i], NSH_REDIRECT_APPEND_OPERATOR) == 0) {
+            nsh_io_put_string(&nsh->io, "ERROR: redirections cannot run in the background\r\n");
+            return NSH_STATUS_UNSUPPORTED;
+        }
+    }
+#endif
+
+    const nsh_cmd_t* matching_cmd = nsh_cmd_array_find(&nsh->cmds, argv[0]);
+    if (!matching_cmd) {
+        return NSH_STATUS_CMD_NOT_FOUND;
+    }
+    if (!matching_cmd->handler) {
+        return NSH_STATUS_EMPTY_CMD;
+    }
+
+    unsigned int id;
+    nsh_status_t status = nsh_job_start(&nsh->jobs, nsh, matching_cmd->handler, argc, argv, &id);
+    if (status == NSH_STATUS_OK) {
+        nsh_io_put_char(&nsh->io, '[');
+        nsh_io_put_unsigned(&nsh->io, id);
+        nsh_io_put_string(&nsh->io, "]\r\n");
+    } else if (status == NSH_STATUS_UNSUPPORTED) {
+        nsh_io_put_string(&nsh->io, "ERROR: no executor for background jobs\r\n");
+    } else if (status == NSH_STATUS_MAX_ARGS_NB_REACH) {
+        nsh_io_put_string(&nsh->io, "ERROR: too many arguments for a background job\r\n");
+    } else {
+        nsh_io_put_string(&nsh->io, "ERROR: cannot start more background jobs\r\n");
+    }
+    return status;
+}
+
+#endif
+
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
 
-static nsh_status_t nsh_autocomplete(const nsh_t* nsh)
+/*
+ * Display the queued log messages, one per line, and how many were dropped since the last call.
+ */
+static void nsh_display_log_messages(nsh_t* nsh)
 {
-    nsh_cmd_array_t match;
-    nsh_cmd_array_init(&match);
+    char message[NSH_LOG_MESSAGE_SIZE];
+    unsigned int size;
+    while (nsh_log_queue_pop(&nsh->log, message, &size)) {
+        nsh_io_put_buffer(&nsh->io, message, size);
+        nsh_io_put_newline(&nsh->io);
+    }
+
+    unsigned int dropped_count = nsh_log_queue_dropped_count(&nsh->log);
+    if (dropped_count != nsh->log_dropped_reported) {
+        nsh_io_put_string(&nsh->io, "WARNING: ");
+        nsh_io_put_unsigned(&nsh->io, dropped_count - nsh->log_dropped_reported);
+        nsh_io_put_string(&nsh->io, " log messages dropped\r\n");
+        nsh->log_dropped_reported = dropped_count;
+    }
+}
+
+#endif
+
+#if NSH_FEATURE_USE_JOBS == 1 || NSH_FEATURE_USE_ASYNC_LOG == 1
+
+static bool nsh_has_news(nsh_t* nsh)
+{
+#if NSH_FEATURE_USE_JOBS == 1
+    if (nsh_job_has_news(&nsh->jobs)) {
+        return true;
+    }
+#endif
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+    if (!nsh_log_queue_is_empty(&nsh->log)
+        || nsh_log_queue_dropped_count(&nsh->log) != nsh->log_dropped_reported) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+/*
+ * Display the output of the background jobs and the log messages above the line
+ * being edited, all at once so that the line is redrawn only once.
+ */
+static void nsh_display_news(nsh_t* nsh)
+{
+    if (!nsh_has_news(nsh)) {
+        return;
+    }
+
+    nsh_io_erase_line(&nsh->io);
+#if NSH_FEATURE_USE_JOBS == 1
+    nsh_job_display_news(&nsh->jobs, &nsh->io);
+#endif
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+    nsh_display_log_messages(nsh);
+#endif
 
-    // Find all commands name matching the actual buffer
-    for (unsigned int i = 0; i < nsh->cmds.count; i++) {
-        if (memcmp(nsh->line.buffer, nsh->cmds.array[i].name, nsh->line.size) == 0) {
-            nsh_cmd_copy(&match.array[match.count++], &nsh->cmds.array[i]);
+    nsh_io_print_prompt(&nsh->io);
+#if NSH_FEATURE_USE_HISTORY == 1
+    if (nsh->history_entry_shown) {
+        unsigned int size;
+        const char* entry = nsh_history_view_entry(&nsh->history, nsh->current_history_entry, &size);
+        nsh_io_put_buffer(&nsh->io, entry, size);
+        return;
+    }
+#endif
+    nsh_io_put_buffer(&nsh->io, nsh->line.buffer, nsh->line.size);
+}
+
+/*
+ * Let the jobs progress and display their output and the log messages until an
+ * input character is available.
+ */
+static void nsh_wait_input(nsh_t* nsh)
+{
+    while (true) {
+        unsigned int timeout_ms = NSH_IO_WAIT_FOREVER;
+#if NSH_FEATURE_USE_JOBS == 1
+        timeout_ms = nsh_job_poll(&nsh->jobs);
+#endif
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+        // The producers cannot wake the shell up, so check the queue periodically
+        if (timeout_ms > NSH_LOG_POLL_PERIOD_MS) {
+            timeout_ms = NSH_LOG_POLL_PERIOD_MS;
+        }
+#endif
+        nsh_display_news(nsh);
+        if (nsh_io_wait(&nsh->io, timeout_ms)) {
+            return;
         }
     }
+}
 
-    if (match.count > 0) {
-        // Sort the matching commands in lexicographical order
-        nsh_cmd_array_lexicographic_sort(&match);
+#endif
+
+#if NSH_FEATURE_USE_AUTOCOMPLETION == 1
 
-        // Display the commands name
-        nsh_io_put_newline();
-        for (unsigned int i = 0; i < match.count; i++) {
-            nsh_io_put_string(match.array[i].name);
-            nsh_io_put_char(' ');
+nsh_status_t nsh_autocomplete(nsh_t* nsh)
+{
+    /*
+     * Display the commands name matching the actual buffer in lexicographical
+     * order, selecting the next one at each step rather than sorting a copy of
+     * the command table on the stack.
+     */
+    const nsh_cmd_t* previous = NULL;
+    while (true) {
+        const nsh_cmd_t* next = NULL;
+        for (unsigned int i = 0; i < nsh->cmds.count; i++) {
+            const nsh_cmd_t* cmd = &nsh->cmds.array[i];
+            if (memcmp(nsh->line.buffer, cmd->name, nsh->line.size) == 0
+                && (previous == NULL || strcmp(cmd->name, previous->name) > 0)
+                && (next == NULL || strcmp(cmd->name, next->name) < 0)) {
+                next = cmd;
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+        if (previous == NULL) {
+            nsh_io_put_newline(&nsh->io);
         }
+        nsh_io_put_string(&nsh->io, next->name);
+        nsh_io_put_char(&nsh->io, ' ');
+        previous = next;
     }
 
     // Print the prompt again
-    nsh_io_put_newline();
-    nsh_io_print_prompt();
+    nsh_io_put_newline(&nsh->io);
+    nsh_io_print_prompt(&nsh->io);
 
     // Reprint the current buffer
-    nsh_io_put_buffer(nsh->line.buffer, nsh->line.size);
+    nsh_io_put_buffer(&nsh->io, nsh->line.buffer, nsh->line.size);
 
     return NSH_STATUS_OK;
 }
@@ -163,27 +519,75 @@ static nsh_status_t nsh_autocomplete(const nsh_t* nsh)
 
 static void nsh_display_history_entry(nsh_t* nsh)
 {
+    nsh_io_erase_line(&nsh->io);
+    nsh_io_print_prompt(&nsh->io);
     if (nsh->current_history_entry == NSH_HISTORY_INVALID_ENTRY) {
-        nsh_io_erase_line();
-        nsh_io_print_prompt();
-        nsh_line_buffer_reset(&nsh->line);
+        // Back to the line being edited before navigating through the history
+        nsh_io_put_buffer(&nsh->io, nsh->line.buffer, nsh->line.size);
+        nsh->history_entry_shown = false;
     } else {
-        nsh_status_t status = nsh_history_get_entry(&nsh->history, nsh->current_history_entry, nsh->line.buffer);
-        if (status == NSH_STATUS_OK) {
-            nsh_io_erase_line();
-            nsh_io_print_prompt();
-            nsh_io_put_string(nsh->line.buffer);
-            nsh->line.size = (unsigned int)strlen(nsh->line.buffer);
+        // Display the entry straight from the history, it is copied only if edited
+        unsigned int size;
+        const char* entry = nsh_history_view_entry(&nsh->history, nsh->current_history_entry, &size);
+        nsh_io_put_buffer(&nsh->io, entry, size);
+        nsh->history_entry_shown = true;
+    }
+}
+
+/*
+ * Leave the history navigation before the line is edited, copying the displayed
+ * entry into the line buffer if needed.
+ */
+static void nsh_take_history_entry(nsh_t* nsh)
+{
+    if (nsh->history_entry_shown) {
+        nsh->line.size = nsh_history_read_entry(&nsh->history, nsh->current_history_entry, nsh->line.buffer);
+        nsh->history_entry_shown = false;
+    }
+    nsh->current_history_entry = NSH_HISTORY_INVALID_ENTRY;
+}
+
+static void nsh_find_history_candidates(nsh_t* nsh)
+{
+    nsh->history_candidate_count = 0;
+    nsh->history_candidate_index = 0;
+
+    unsigned int entry = nsh_history_most_recent(&nsh->history);
+    while (nsh->history_candidate_count < NSH_HISTORY_CANDIDATE_CACHE_SIZE) {
+        entry = nsh_history_find_prefix(&nsh->history, nsh->line.buffer, nsh->line.size, entry);
+        if (entry == NSH_HISTORY_INVALID_ENTRY) {
+            break;
         }
+        nsh->history_candidates[nsh->history_candidate_count++] = entry;
+        entry = nsh_history_previous(&nsh->history, entry);
     }
 }
 
+/*
+ * Only the entries starting with the typed line are recalled, the line buffer
+ * keeping this prefix during the whole navigation. An empty line recalls all
+ * the entries.
+ */
 static nsh_status_t nsh_display_previous_entry(nsh_t* nsh)
 {
-    nsh->current_history_entry++;
-    unsigned int entry_count = nsh_history_entry_count(&nsh->history);
-    if (nsh->current_history_entry >= entry_count) {
-        nsh->current_history_entry = entry_count - 1;
+    if (nsh->current_history_entry == NSH_HISTORY_INVALID_ENTRY) {
+        nsh_find_history_candidates(nsh);
+        if (nsh->history_candidate_count == 0) {
+            return NSH_STATUS_OK; // Nothing to recall, keep the line as is
+        }
+        nsh->current_history_entry = nsh->history_candidates[0];
+    } else if (nsh->history_candidate_index + 1 < nsh->history_candidate_count) {
+        nsh->history_candidate_index++;
+        nsh->current_history_entry = nsh->history_candidates[nsh->history_candidate_index];
+    } else {
+        // Past the cached candidates, scan the history from the current entry
+        unsigned int previous_entry = nsh_history_find_prefix(&nsh->history, nsh->line.buffer, nsh->line.size,
+            nsh_history_previous(&nsh->history, nsh->current_history_entry));
+        if (previous_entry == NSH_HISTORY_INVALID_ENTRY) {
+            return NSH_STATUS_OK; // Stay on the oldest entry
+        }
+        nsh->history_candidate_index = nsh->history_candidate_count;
+        nsh->current_history_entry = previous_entry;
     }
 
     nsh_display_history_entry(nsh);
@@ -193,8 +597,28 @@ static nsh_status_t nsh_display_previous_entry(nsh_t* nsh)
 
 static nsh_status_t nsh_display_next_entry(nsh_t* nsh)
 {
-    if (nsh->current_history_entry < NSH_CMD_HISTORY_SIZE) {
-        nsh->current_history_entry--;
+    if (nsh->current_history_entry == NSH_HISTORY_INVALID_ENTRY) {
+        return NSH_STATUS_OK;
+    }
+
+    if (nsh->history_candidate_index >= nsh->history_candidate_count) {
+        // Past the cached candidates, scan toward the most recent entries
+        unsigned int next_entry = nsh_history_next(&nsh->history, nsh->current_history_entry);
+        while (next_entry != NSH_HISTORY_INVALID_ENTRY
+            && !nsh_history_entry_starts_with(&nsh->history, next_entry, nsh->line.buffer, nsh->line.size)) {
+            next_entry = nsh_history_next(&nsh->history, next_entry);
+        }
+        if (nsh->history_candidate_count > 0
+            && next_entry == nsh->history_candidates[nsh->history_candidate_count - 1]) {
+            nsh->history_candidate_index--;
+        }
+        nsh->current_history_entry = next_entry;
+    } else if (nsh->history_candidate_index == 0) {
+        // Back to the typed line
+        nsh->current_history_entry = NSH_HISTORY_INVALID_ENTRY;
+    } else {
+        nsh->history_candidate_index--;
+        nsh->current_history_entry = nsh->history_candidates[nsh->history_candidate_index];
     }
 
     nsh_display_history_entry(nsh);
@@ -204,6 +628,100 @@ static nsh_status_t nsh_display_next_entry(nsh_t* nsh)
 
 #endif
 
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+
+static void nsh_display_search_state(nsh_t* nsh, const char* pattern, unsigned int pattern_size,
+    unsigned int match)
+{
+    nsh_io_erase_line(&nsh->io);
+    nsh_io_put_string(&nsh->io,
+        match == NSH_HISTORY_INVALID_ENTRY ? "(failing reverse-i-search)`" : "(reverse-i-search)`");
+    nsh_io_put_buffer(&nsh->io, pattern, pattern_size);
+    nsh_io_put_string(&nsh->io, "': ");
+    if (match != NSH_HISTORY_INVALID_ENTRY) {
+        unsigned int size;
+        const char* entry = nsh_history_view_entry(&nsh->history, match, &size);
+        nsh_io_put_buffer(&nsh->io, entry, size);
+    }
+}
+
+/*
+ * Incremental reverse search, started by Ctrl-R.
+ * Each typed character narrows the search, starting from the current match since
+ * the more recent entries, which did not match the shorter pattern, cannot match
+ * the longer one.
+ * Ctrl-R again jumps to the next older match, Ctrl-G aborts the search, Enter
+ * executes the matching entry and any escape sequence keeps it for edition.
+ * Return true if the matching entry shall be executed.
+ */
+static bool nsh_reverse_search(nsh_t* nsh)
+{
+    char pattern[NSH_HISTORY_ENTRY_BUFFER_SIZE];
+    unsigned int pattern_size = 0;
+    unsigned int match = nsh_history_most_recent(&nsh->history);
+
+    nsh_display_search_state(nsh, pattern, pattern_size, match);
+
+    while (true) {
+        unsigned int start = match;
+        char c = nsh_io_get_char(&nsh->io);
+        switch (c) {
+        case '\x12': // Ctrl-R
+            if (match == NSH_HISTORY_INVALID_ENTRY) {
+                continue;
+            }
+            start = nsh_history_previous(&nsh->history, match);
+            break;
+        case '\b':
+            if (pattern_size == 0) {
+                continue;
+            }
+            pattern_size--;
+            start = nsh_history_most_recent(&nsh->history); // A shorter pattern may match more recent entries
+            break;
+        case '\x07': // Ctrl-G
+        case NSH_IO_EOT:
+            nsh_line_buffer_reset(&nsh->line);
+            nsh->current_history_entry = NSH_HISTORY_INVALID_ENTRY;
+            nsh_display_history_entry(nsh);
+            return false;
+        case '\r':
+        case '\n':
+        case '\x1b':
+            nsh_line_buffer_reset(&nsh->line);
+            nsh->current_history_entry = match;
+            nsh->history_candidate_count = 0; // Navigate from the match through all the entries
+            nsh->history_candidate_index = 0;
+            nsh_display_history_entry(nsh);
+            if (c == '\x1b') {
+                nsh_handle_escape_sequence(nsh);
+                return false;
+            }
+            return true;
+        default:
+            if (!isprint((unsigned char)c) || pattern_size >= NSH_LINE_BUFFER_CAPACITY(&nsh->line) - 1) {
+                continue;
+            }
+            pattern[pattern_size++] = c;
+            if (match == NSH_HISTORY_INVALID_ENTRY) {
+                // Nothing matched a shorter pattern, nothing will match this one
+                nsh_display_search_state(nsh, pattern, pattern_size, match);
+                continue;
+            }
+            break;
+        }
+
+        unsigned int found = nsh_history_search(&nsh->history, pattern, pattern_size, start);
+        if (found != NSH_HISTORY_INVALID_ENTRY || c != '\x12') {
+            // Keep the current match on screen when there is no older one
+            match = found;
+        }
+        nsh_display_search_state(nsh, pattern, pattern_size, match);
+    }
+}
+
+#endif
+
 static nsh_status_t nsh_handle_escape_sequence(nsh_t* nsh)
 {
 #if NSH_FEATURE_USE_HISTORY == 0
@@ -212,10 +730,10 @@ static nsh_status_t nsh_handle_escape_sequence(nsh_t* nsh)
     // Only VT100 escape sequences with the form "\e[<code>" are supported
 
     // We assume '\e' has been handled already, so we just ignore '['
-    nsh_io_get_char();
+    nsh_io_get_char(&nsh->io);
 
     // Handle escaped code
-    char c = nsh_io_get_char();
+    char c = nsh_io_get_char(&nsh->io);
     switch (c) {
 #if NSH_FEATURE_USE_HISTORY == 1
     case 'A': // Arrow up
@@ -238,18 +756,22 @@ static void nsh_validate_entry(nsh_t* nsh)
 #if NSH_FEATURE_USE_HISTORY == 1
     // if the entry is not empty, add it into history
     if (!nsh_line_buffer_is_empty(&nsh->line)) {
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+        nsh_history_log_add_entry(&nsh->history_log, &nsh->history, nsh->line.buffer);
+#else
         nsh_history_add_entry(&nsh->history, nsh->line.buffer);
+#endif
     }
 #endif
 
     // print newline
-    nsh_io_put_newline();
+    nsh_io_put_newline(&nsh->io);
 }
 
 static void nsh_erase_last_char(nsh_t* nsh)
 {
     if (!nsh_line_buffer_is_empty(&nsh->line)) {
-        nsh_io_erase_last_char();
+        nsh_io_erase_last_char(&nsh->io);
         nsh_line_buffer_erase_last_char(&nsh->line);
     }
 }
@@ -258,36 +780,70 @@ static nsh_status_t nsh_read_line(nsh_t* nsh)
 {
 #if NSH_FEATURE_USE_HISTORY == 1
     nsh->current_history_entry = NSH_HISTORY_INVALID_ENTRY;
+    nsh->history_entry_shown = false;
 #endif
 
     nsh_line_buffer_reset(&nsh->line);
 
     while (true) {
-        char c = nsh_io_get_char();
+#if NSH_FEATURE_USE_JOBS == 1 || NSH_FEATURE_USE_ASYNC_LOG == 1
+        nsh_wait_input(nsh);
+#endif
+        char c = nsh_io_get_char(&nsh->io);
         switch (c) {
+        case NSH_IO_EOT:
+            nsh_io_put_newline(&nsh->io);
+            return NSH_STATUS_QUIT;
+        case NSH_IO_ETX: // Ctrl-C, discard the line
+            nsh_io_put_string(&nsh->io, "^C\r\n");
+            return NSH_STATUS_CANCELLED;
         case '\r':
         case '\n':
+#if NSH_FEATURE_USE_HISTORY == 1
+            nsh_take_history_entry(nsh);
+#endif
             nsh_validate_entry(nsh);
             return NSH_STATUS_OK;
 #if NSH_FEATURE_USE_AUTOCOMPLETION == 1
         case '\t':
+#if NSH_FEATURE_USE_HISTORY == 1
+            nsh_take_history_entry(nsh);
+#endif
             nsh_autocomplete(nsh);
             continue;
 #endif
         case '\b':
+#if NSH_FEATURE_USE_HISTORY == 1
+            nsh_take_history_entry(nsh);
+#endif
             nsh_erase_last_char(nsh);
             continue;
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+        case '\x12': // Ctrl-R
+            if (nsh_reverse_search(nsh)) {
+                nsh_take_history_entry(nsh);
+                nsh_validate_entry(nsh);
+                return NSH_STATUS_OK;
+            }
+            continue;
+#endif
         case '\x1b':
             nsh_handle_escape_sequence(nsh);
             continue;
-        default:
-            nsh_io_put_char(c);
+        default: {
+#if NSH_FEATURE_USE_HISTORY == 1
+            nsh_take_history_entry(nsh);
+#endif
+            NSH_TRACE_BEGIN(&nsh->io, ECHO);
+            nsh_io_put_char(&nsh->io, c);
             nsh_line_buffer_append_char(&nsh->line, c);
+            NSH_TRACE_END(&nsh->io, ECHO);
+        }
         }
 
         if (nsh_line_buffer_is_full(&nsh->line)) {
-            nsh_io_put_newline();
-            nsh_io_put_string("WARNING: line buffer reach its maximum capacity\r\n");
+            nsh_io_put_newline(&nsh->io);
+            nsh_io_put_string(&nsh->io, "WARNING: line buffer reach its maximum capacity\r\n");
             return NSH_STATUS_BUFFER_OVERFLOW;
         }
     }
@@ -295,35 +851,255 @@ static nsh_status_t nsh_read_line(nsh_t* nsh)
     return NSH_STATUS_OK;
 }
 
-nsh_t nsh_init(nsh_status_t* status)
+// Initialize the state of a zeroed shell whose tables are already in place
+static nsh_status_t nsh_setup(nsh_t* nsh)
 {
-    nsh_t nsh = { 0 };
+    nsh_cmd_array_init(&nsh->cmds);
 
-    nsh_cmd_array_init(&nsh.cmds);
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+    // Paint the buffers before their first use, the bytes left unpainted giving their peak usage
+    nsh_mem_paint(nsh->line.buffer, NSH_LINE_BUFFER_CAPACITY(&nsh->line));
+    nsh_mem_paint(nsh->io.output, sizeof(nsh->io.output));
+#if NSH_FEATURE_USE_HISTORY == 1
+    nsh_mem_paint(nsh->history.ring, NSH_HISTORY_RING_SIZE(&nsh->history));
+#endif
+    nsh->stack_limit = NULL;
+    nsh->stack_size = 0;
+#endif
 
-    nsh_line_buffer_reset(&nsh.line);
+    nsh_line_buffer_reset(&nsh->line);
+
+    nsh_io_init(&nsh->io, &nsh_io_stdio_backend, NULL);
+
+    nsh_cancel_token_init(&nsh->cancel, NULL, 0);
+    nsh->clock = NULL;
+    nsh->command_timeout_ms = NSH_DEFAULT_COMMAND_TIMEOUT_MS;
+
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    nsh->cycle_counter = NULL;
+    nsh->cycle_counter_frequency_hz = 0;
+#endif
+
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+    nsh->command_not_found_handler = NULL;
+#endif
+
+#if NSH_FEATURE_USE_REDIRECTION == 1
+    nsh_redirect_init(&nsh->redirect, &nsh_redirect_stdio_backend);
+#endif
+
+#if NSH_FEATURE_USE_SCRIPTS == 1
+    nsh->script.code_size = 0;
+#endif
 
 #if NSH_FEATURE_USE_HISTORY == 1
-    nsh_history_reset(&nsh.history);
-    nsh.current_history_entry = NSH_HISTORY_INVALID_ENTRY;
+    nsh_history_reset(&nsh->history);
+    nsh->current_history_entry = NSH_HISTORY_INVALID_ENTRY;
+    nsh->history_entry_shown = false;
+    nsh->history_candidate_count = 0;
+    nsh->history_candidate_index = 0;
+#endif
+
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+    nsh_history_log_init(&nsh->history_log, NULL);
+#endif
+
+#if NSH_FEATURE_USE_JOBS == 1
+    nsh_job_table_init(&nsh->jobs, NULL);
+#endif
+
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+    nsh_log_queue_init(&nsh->log);
+    nsh->log_dropped_reported = 0;
 #endif
 
-    nsh_register_command(&nsh, "help", cmd_builtin_help);
-    nsh_register_command(&nsh, "exit", cmd_builtin_exit);
-    nsh_register_command(&nsh, "version", cmd_builtin_version);
+    for (unsigned int i = 0; i < NSH_BUILTIN_COUNT; i++) {
+        nsh_status_t status = nsh_register_command(nsh, nsh_builtins[i].name, nsh_builtins[i].handler);
+        if (status != NSH_STATUS_OK) {
+            return status;
+        }
+    }
+
+    return NSH_STATUS_OK;
+}
 
-    *status = NSH_STATUS_OK;
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+
+size_t nsh_arena_size(const nsh_limits_t* limits)
+{
+    return NSH_ARENA_SIZE((size_t)limits->line_buffer_size, (size_t)limits->cmd_max_count,
+        (size_t)limits->cmd_args_max_count, (size_t)limits->cmd_history_size);
+}
+
+nsh_status_t nsh_init_with_arena(nsh_t* nsh, void* arena, size_t arena_size, const nsh_limits_t* limits)
+{
+    if (limits->line_buffer_size == 0 || limits->cmd_max_count < NSH_BUILTIN_COUNT || limits->cmd_args_max_count == 0
+        || (uintptr_t)arena % sizeof(char*) != 0) {
+        return NSH_STATUS_WRONG_ARG;
+    }
+#if NSH_FEATURE_USE_HISTORY == 1
+    // Same constraints as NSH_LINE_BUFFER_SIZE and NSH_CMD_HISTORY_SIZE in the fixed-size build
+    if (limits->line_buffer_size > NSH_HISTORY_ENTRY_BUFFER_SIZE
+        || limits->cmd_history_size < limits->line_buffer_size - 1 + NSH_HISTORY_ENTRY_OVERHEAD) {
+        return NSH_STATUS_WRONG_ARG;
+    }
+#endif
+    if (arena_size < nsh_arena_size(limits)) {
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+
+    memset(nsh, 0, sizeof(*nsh));
+
+    // Pointer-aligned tables first, then the character ones
+    char* next = arena;
+    nsh_cmd_array_set_storage(&nsh->cmds, (nsh_cmd_t*)(void*)next, limits->cmd_max_count);
+    next += limits->cmd_max_count * sizeof(nsh_cmd_t);
+    nsh->argv = (char**)(void*)next;
+    next += limits->cmd_args_max_count * sizeof(char*);
+    nsh->args = (char(*)[NSH_MAX_STRING_SIZE])next;
+    nsh->args_max_count = limits->cmd_args_max_count;
+    next += limits->cmd_args_max_count * NSH_MAX_STRING_SIZE;
+    nsh_line_buffer_set_storage(&nsh->line, next, limits->line_buffer_size);
+#if NSH_FEATURE_USE_HISTORY == 1
+    next += limits->line_buffer_size;
+    nsh_history_set_storage(&nsh->history, next, limits->cmd_history_size, limits->line_buffer_size - 1);
+#endif
+
+    return nsh_setup(nsh);
+}
+
+#else
+
+nsh_t nsh_init(nsh_status_t* status)
+{
+    nsh_t nsh = { 0 };
+
+    *status = nsh_setup(&nsh);
 
     return nsh;
 }
 
+nsh_status_t nsh_init_inplace(nsh_t* nsh)
+{
+    memset(nsh, 0, sizeof(*nsh));
+
+    return nsh_setup(nsh);
+}
+
+#endif // NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+
 nsh_status_t nsh_register_command(nsh_t* nsh, const char* name, nsh_cmd_handler_t* handler)
 {
     return nsh_cmd_array_register(&nsh->cmds, name, handler);
 }
 
+void nsh_set_io(nsh_t* nsh, const nsh_io_backend_t* backend, void* ctx)
+{
+    nsh_io_flush(&nsh->io);
+#if NSH_FEATURE_USE_TRACE == 1
+    nsh_trace_t* trace = nsh->io.trace;
+    nsh_io_init(&nsh->io, backend, ctx);
+    nsh->io.trace = trace;
+#else
+    nsh_io_init(&nsh->io, backend, ctx);
+#endif
+}
+
+void nsh_set_prompt(nsh_t* nsh, const char* prompt)
+{
+    nsh->io.prompt = prompt;
+}
+
+void nsh_set_clock(nsh_t* nsh, nsh_clock_t* clock)
+{
+    nsh->clock = clock;
+}
+
+void nsh_set_command_timeout(nsh_t* nsh, unsigned int timeout_ms)
+{
+    nsh->command_timeout_ms = timeout_ms;
+}
+
+void nsh_interrupt(nsh_t* nsh)
+{
+    nsh_cancel_token_cancel(&nsh->cancel);
+}
+
+#if NSH_FEATURE_USE_CMD_STATS == 1
+void nsh_set_cycle_counter(nsh_t* nsh, nsh_cycle_counter_t* counter, uint32_t frequency_hz)
+{
+    nsh->cycle_counter = counter;
+    nsh->cycle_counter_frequency_hz = frequency_hz;
+}
+#endif
+
+#if NSH_FEATURE_USE_TRACE == 1
+void nsh_set_trace(nsh_t* nsh, nsh_trace_t* trace)
+{
+    nsh->io.trace = trace;
+}
+#endif
+
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+void nsh_set_command_not_found_handler(nsh_t* nsh, nsh_cmd_handler_t* handler)
+{
+    nsh->command_not_found_handler = handler;
+}
+#endif
+
+#if NSH_FEATURE_USE_REDIRECTION == 1
+void nsh_set_redirect_backend(nsh_t* nsh, const nsh_redirect_backend_t* backend)
+{
+    nsh_redirect_init(&nsh->redirect, backend);
+}
+#endif
+
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+nsh_status_t nsh_set_stack(nsh_t* nsh, void* stack_limit, size_t stack_size)
+{
+    nsh_status_t status = nsh_mem_paint_stack(stack_limit, stack_size);
+    if (status == NSH_STATUS_OK) {
+        nsh->stack_limit = stack_limit;
+        nsh->stack_size = stack_size;
+    }
+    return status;
+}
+#endif
+
+#if NSH_FEATURE_USE_JOBS == 1
+void nsh_set_executor(nsh_t* nsh, const nsh_executor_t* executor)
+{
+    nsh_job_table_init(&nsh->jobs, executor);
+}
+#endif
+
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+nsh_status_t nsh_set_history_storage(nsh_t* nsh, const nsh_history_storage_t* storage)
+{
+    nsh_history_log_init(&nsh->history_log, storage);
+    return nsh_history_log_load(&nsh->history_log, &nsh->history);
+}
+#endif
+
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+nsh_status_t nsh_log_async(nsh_t* nsh, const char* message)
+{
+    unsigned int size = (unsigned int)strlen(message);
+    // Each message is displayed on its own line
+    while (size > 0 && (message[size - 1] == '\n' || message[size - 1] == '\r')) {
+        size--;
+    }
+    return nsh_log_queue_push(&nsh->log, message, size) ? NSH_STATUS_OK : NSH_STATUS_BUFFER_OVERFLOW;
+}
+#endif
+
 void nsh_run(nsh_t* nsh)
 {
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+    // Storage for command line after spliting, carved out of the arena
+    char(*args)[NSH_MAX_STRING_SIZE] = nsh->args;
+    char** argv = nsh->argv;
+#else
     // Local storage for command line after spliting
     char args[NSH_CMD_ARGS_MAX_COUNT][NSH_MAX_STRING_SIZE];
 
@@ -336,18 +1112,26 @@ void nsh_run(nsh_t* nsh)
      * step: char[][] -> char*[] -> char**
      */
     char* argv[NSH_CMD_ARGS_MAX_COUNT] = { NULL };
+#endif
 
     while (true) {
         unsigned int argc = 0;
 
-        nsh_io_print_prompt();
+        nsh_io_print_prompt(&nsh->io);
 
         // Read a command line and store it into 'nsh->line.buffer'
         nsh_status_t status = nsh_read_line(nsh);
+        if (status == NSH_STATUS_QUIT) {
+            break;
+        }
 
         if (status == NSH_STATUS_OK) {
             // Split the command line into argument tokens
-            if (nsh_split_command_line(nsh->line.buffer, ' ', args, &argc) != NSH_STATUS_OK) {
+            NSH_TRACE_BEGIN(&nsh->io, SPLIT);
+            nsh_status_t split_status = nsh_split_command_line(nsh->line.buffer, ' ', args, &argc,
+                NSH_ARGS_MAX_COUNT(nsh));
+            NSH_TRACE_END(&nsh->io, SPLIT);
+            if (split_status != NSH_STATUS_OK) {
                 // Ignore this command since there was an error
                 // TODO just print a warning to the user
                 continue;
@@ -359,14 +1143,42 @@ void nsh_run(nsh_t* nsh)
             }
 
             // Execute the command with 'argc' number of argument stored in 'argv'
-            nsh_status_t cmd_status = nsh_execute(nsh, argc, argv);
+#if NSH_FEATURE_USE_JOBS == 1
+            nsh_status_t cmd_status = nsh_strip_background_operator(&argc, argv)
+                ? nsh_execute_in_background(nsh, argc, argv)
+                : nsh_execute_in_foreground(nsh, argc, argv);
+#else
+            nsh_status_t cmd_status = nsh_execute_in_foreground(nsh, argc, argv);
+#endif
             if (cmd_status == NSH_STATUS_CMD_NOT_FOUND) {
-                nsh_io_put_string("ERROR: command '");
-                nsh_io_put_string(argv[0]);
-                nsh_io_put_string("' not found\r\n");
+                nsh_io_put_string(&nsh->io, "ERROR: command '");
+                nsh_io_put_string(&nsh->io, argv[0]);
+                nsh_io_put_string(&nsh->io, "' not found\r\n");
+            } else if (cmd_status == NSH_STATUS_CANCELLED) {
+                nsh_io_put_string(&nsh->io, "ERROR: command '");
+                nsh_io_put_string(&nsh->io, argv[0]);
+                nsh_io_put_string(&nsh->io, nsh->cancel.timed_out ? "' timed out\r\n" : "' cancelled\r\n");
             } else if (cmd_status == NSH_STATUS_QUIT) {
                 break;
             }
+
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+            // Save the history once the command is done, never while a line is typed
+            if (nsh_history_log_is_batch_complete(&nsh->history_log)) {
+                nsh_history_log_flush(&nsh->history_log, &nsh->history);
+            }
+#endif
         }
     }
+
+#if NSH_FEATURE_USE_JOBS == 1
+    nsh_job_terminate_all(&nsh->jobs, &nsh->io);
+#endif
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+    nsh_display_log_messages(nsh);
+#endif
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+    nsh_history_log_flush(&nsh->history_log, &nsh->history);
+#endif
+    nsh_io_flush(&nsh->io);
 }
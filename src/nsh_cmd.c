@@ -17,6 +17,9 @@ nsh_status_t nsh_cmd_init(nsh_cmd_t* cmd, const char* name, nsh_cmd_handler_t* h
 
     strncpy(cmd->name, name, NSH_MAX_STRING_SIZE);
     cmd->handler = handler;
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    nsh_cmd_stats_reset(&cmd->stats);
+#endif
     return NSH_STATUS_OK;
 }
 
@@ -24,6 +27,9 @@ void nsh_cmd_copy(nsh_cmd_t* dst, const nsh_cmd_t* src)
 {
     dst->handler = src->handler;
     strncpy(dst->name, src->name, sizeof(dst->name));
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    dst->stats = src->stats;
+#endif
 }
 
 void nsh_cmd_swap(nsh_cmd_t* cmd1, nsh_cmd_t* cmd2)
@@ -33,3 +39,61 @@ void nsh_cmd_swap(nsh_cmd_t* cmd1, nsh_cmd_t* cmd2)
     nsh_cmd_copy(cmd1, cmd2);
     nsh_cmd_copy(cmd2, &temp);
 }
+
+#if NSH_FEATURE_USE_CMD_STATS == 1
+void nsh_cmd_stats_reset(nsh_cmd_stats_t* stats)
+{
+    stats->call_count = 0;
+    stats->error_count = 0;
+    stats->min_cycles = UINT32_MAX;
+    stats->max_cycles = 0;
+    stats->total_cycles = 0;
+}
+
+void nsh_cmd_stats_record(nsh_cmd_stats_t* stats, uint32_t cycles, bool error)
+{
+    stats->call_count++;
+    if (error) {
+        stats->error_count++;
+    }
+    if (cycles < stats->min_cycles) {
+        stats->min_cycles = cycles;
+    }
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+    stats->total_cycles += cycles;
+}
+#endif
+
+void nsh_cancel_token_init(nsh_cancel_token_t* token, nsh_clock_t* clock, unsigned int timeout_ms)
+{
+    token->timed_out = false;
+    token->clock = (timeout_ms != 0) ? clock : NULL;
+    token->deadline_ms = (token->clock != NULL) ? token->clock() + timeout_ms : 0;
+    NSH_ATOMIC_STORE(&token->cancelled, false);
+}
+
+void nsh_cancel_token_cancel(nsh_cancel_token_t* token)
+{
+    NSH_ATOMIC_STORE(&token->cancelled, true);
+}
+
+bool nsh_cancel_token_is_cancelled(nsh_cancel_token_t* token)
+{
+    if (NSH_ATOMIC_LOAD(&token->cancelled)) {
+        return true;
+    }
+    // The difference is signed so that the comparison survives the clock wrap-around
+    if (token->clock != NULL && (int)(token->clock() - token->deadline_ms) >= 0) {
+        token->timed_out = true;
+        NSH_ATOMIC_STORE(&token->cancelled, true);
+        return true;
+    }
+    return false;
+}
+
+bool nsh_cmd_is_cancelled(const nsh_cmd_ctx_t* ctx)
+{
+    return ctx->cancel != NULL && nsh_cancel_token_is_cancelled(ctx->cancel);
+}
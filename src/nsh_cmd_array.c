@@ -2,9 +2,18 @@
 
 #include <string.h>
 
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+void nsh_cmd_array_set_storage(nsh_cmd_array_t* cmds, nsh_cmd_t* storage, unsigned int capacity)
+{
+    cmds->array = storage;
+    cmds->capacity = capacity;
+}
+#endif
+
 nsh_status_t nsh_cmd_array_init(nsh_cmd_array_t* cmds)
 {
-    memset(cmds, 0, sizeof(nsh_cmd_array_t));
+    memset(cmds->array, 0, NSH_CMD_ARRAY_CAPACITY(cmds) * sizeof(nsh_cmd_t));
+    cmds->count = 0;
     return NSH_STATUS_OK;
 }
 
@@ -37,7 +46,7 @@ const nsh_cmd_t* nsh_cmd_array_find(const nsh_cmd_array_t* cmds, const char* nam
 
 nsh_status_t nsh_cmd_array_register(nsh_cmd_array_t* cmds, const char* name, nsh_cmd_handler_t* handler)
 {
-    if (cmds->count >= NSH_CMD_MAX_COUNT) {
+    if (cmds->count >= NSH_CMD_ARRAY_CAPACITY(cmds)) {
         // If we have reached the max cmd count, ignore all registration request
         return NSH_STATUS_MAX_CMD_NB_REACH;
     }
@@ -2,30 +2,283 @@
 
 #include <nsh/nsh_io_plugin.h>
 
-nsh_status_t cmd_builtin_help(unsigned int argc, char** argv)
+#if NSH_FEATURE_USE_JOBS == 1 || NSH_FEATURE_USE_CMD_STATS == 1 || NSH_FEATURE_USE_HIGH_WATER_MARKS == 1            \
+    || NSH_FEATURE_USE_SCRIPTS == 1
+#include <nsh/nsh.h>
+#endif
+
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+#include <nsh/nsh_mem.h>
+#endif
+
+#if NSH_FEATURE_USE_JOBS == 1
+#include <stdlib.h>
+#endif
+
+#if NSH_FEATURE_USE_CMD_STATS == 1 || NSH_FEATURE_USE_HIGH_WATER_MARKS == 1 || NSH_FEATURE_USE_SCRIPTS == 1
+#include <string.h>
+#endif
+
+nsh_status_t cmd_builtin_help(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
 {
     NSH_UNUSED(argc);
     NSH_UNUSED(argv);
-    nsh_io_put_string("This is an helpful help message !");
+    nsh_io_put_string(ctx->io, "This is an helpful help message !");
     return NSH_STATUS_OK;
 }
 
-nsh_status_t cmd_builtin_exit(unsigned int argc, char** argv)
+nsh_status_t cmd_builtin_exit(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
 {
     NSH_UNUSED(argc);
     NSH_UNUSED(argv);
-    nsh_io_put_string("exit");
+    nsh_io_put_string(ctx->io, "exit");
     return NSH_STATUS_QUIT;
 }
 
-nsh_status_t cmd_builtin_version(unsigned int argc, char** argv)
+nsh_status_t cmd_builtin_version(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
 {
     NSH_UNUSED(argc);
     NSH_UNUSED(argv);
 #if NSH_FEATURE_USE_PRINTF == 1
-    nsh_io_printf("Nsh version %u.%u.%u", NSH_VERSION_MAJOR, NSH_VERSION_MINOR, NSH_VERSION_PATCH);
+    nsh_io_printf(ctx->io, "Nsh version %u.%u.%u", NSH_VERSION_MAJOR, NSH_VERSION_MINOR, NSH_VERSION_PATCH);
 #else
-    nsh_io_put_string("Nsh version " NSH_VERSION_STRING);
+    nsh_io_put_string(ctx->io, "Nsh version " NSH_VERSION_STRING);
+#endif
+    return NSH_STATUS_OK;
+}
+
+#if NSH_FEATURE_USE_JOBS == 1
+
+/*
+ * Find the job designated by the argument "<id>" or "%<id>".
+ */
+static nsh_job_t* cmd_builtin_find_job(nsh_cmd_ctx_t* ctx, const char* arg)
+{
+    if (arg[0] == '%') {
+        arg++;
+    }
+    nsh_job_t* job = nsh_job_find(&ctx->nsh->jobs, (unsigned int)strtoul(arg, NULL, 10));
+    if (job == NULL) {
+        nsh_io_put_string(ctx->io, "no such job");
+    }
+    return job;
+}
+
+nsh_status_t cmd_builtin_jobs(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    NSH_UNUSED(argc);
+    NSH_UNUSED(argv);
+    nsh_job_list(&ctx->nsh->jobs, ctx->io);
+    return NSH_STATUS_OK;
+}
+
+nsh_status_t cmd_builtin_fg(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    nsh_job_t* job;
+    if (argc > 1) {
+        job = cmd_builtin_find_job(ctx, argv[1]);
+    } else {
+        job = nsh_job_find_last(&ctx->nsh->jobs);
+        if (job == NULL) {
+            nsh_io_put_string(ctx->io, "no current job");
+        }
+    }
+    if (job == NULL) {
+        return NSH_STATUS_WRONG_ARG;
+    }
+    return nsh_job_wait(&ctx->nsh->jobs, job, ctx);
+}
+
+nsh_status_t cmd_builtin_kill(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    if (argc < 2) {
+        nsh_io_put_string(ctx->io, "usage: kill <id>");
+        return NSH_STATUS_WRONG_ARG;
+    }
+    nsh_job_t* job = cmd_builtin_find_job(ctx, argv[1]);
+    if (job == NULL) {
+        return NSH_STATUS_WRONG_ARG;
+    }
+    nsh_job_cancel(&ctx->nsh->jobs, job);
+    return NSH_STATUS_OK;
+}
+
+#endif
+
+#if NSH_FEATURE_USE_CMD_STATS == 1 || NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+
+/*
+ * Print 'value' right-aligned in a column of 'width' characters.
+ */
+static void cmd_builtin_put_column(nsh_io_t* io, unsigned int value, unsigned int width)
+{
+    unsigned int digits = 1;
+    for (unsigned int rest = value / 10; rest != 0; rest /= 10) {
+        digits++;
+    }
+    for (; digits < width; digits++) {
+        nsh_io_put_char(io, ' ');
+    }
+    nsh_io_put_char(io, ' ');
+    nsh_io_put_unsigned(io, value);
+}
+
 #endif
+
+#if NSH_FEATURE_USE_CMD_STATS == 1
+
+/*
+ * Order of the commands in the table: the most time-consuming first, then by name.
+ */
+static bool cmd_builtin_stats_before(const nsh_cmd_t* cmd1, const nsh_cmd_t* cmd2)
+{
+    if (cmd1->stats.total_cycles != cmd2->stats.total_cycles) {
+        return cmd1->stats.total_cycles > cmd2->stats.total_cycles;
+    }
+    return strcmp(cmd1->name, cmd2->name) < 0;
+}
+
+static unsigned int cmd_builtin_stats_latency(const nsh_t* nsh, uint64_t cycles)
+{
+    if (nsh->cycle_counter_frequency_hz != 0) {
+        cycles = cycles * 1000000u / nsh->cycle_counter_frequency_hz;
+    }
+    return (cycles > UINT32_MAX) ? UINT32_MAX : (unsigned int)cycles;
+}
+
+nsh_status_t cmd_builtin_stats(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    nsh_t* nsh = ctx->nsh;
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            nsh_io_put_string(ctx->io, "usage: stats [reset]");
+            return NSH_STATUS_WRONG_ARG;
+        }
+        for (unsigned int i = 0; i < nsh->cmds.count; i++) {
+            nsh_cmd_stats_reset(&nsh->cmds.array[i].stats);
+        }
+        return NSH_STATUS_OK;
+    }
+
+    nsh_io_put_string(ctx->io, "command         calls errors");
+    nsh_io_put_string(ctx->io, (nsh->cycle_counter_frequency_hz != 0)
+            ? "   min(us)   max(us)  mean(us)"
+            : "  min(cyc)  max(cyc) mean(cyc)");
+
+    // Select the next command in order at each step, rather than sorting a copy of the table
+    const nsh_cmd_t* previous = NULL;
+    while (true) {
+        const nsh_cmd_t* next = NULL;
+        for (unsigned int i = 0; i < nsh->cmds.count; i++) {
+            const nsh_cmd_t* cmd = &nsh->cmds.array[i];
+            if (cmd->stats.call_count != 0 && (previous == NULL || cmd_builtin_stats_before(previous, cmd))
+                && (next == NULL || cmd_builtin_stats_before(cmd, next))) {
+                next = cmd;
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+        const nsh_cmd_stats_t* stats = &next->stats;
+        nsh_io_put_newline(ctx->io);
+        nsh_io_put_string(ctx->io, next->name);
+        for (unsigned int i = (unsigned int)strlen(next->name); i < NSH_MAX_STRING_SIZE - 1; i++) {
+            nsh_io_put_char(ctx->io, ' ');
+        }
+        cmd_builtin_put_column(ctx->io, stats->call_count, 5);
+        cmd_builtin_put_column(ctx->io, stats->error_count, 6);
+        cmd_builtin_put_column(ctx->io, cmd_builtin_stats_latency(nsh, stats->min_cycles), 9);
+        cmd_builtin_put_column(ctx->io, cmd_builtin_stats_latency(nsh, stats->max_cycles), 9);
+        cmd_builtin_put_column(ctx->io, cmd_builtin_stats_latency(nsh, stats->total_cycles / stats->call_count), 9);
+        previous = next;
+    }
     return NSH_STATUS_OK;
 }
+
+#endif
+
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+
+/*
+ * Print a row of the memory table, the size and the peak usage being in bytes.
+ */
+static void cmd_builtin_mem_put_row(nsh_io_t* io, const char* name, size_t size, size_t peak)
+{
+    nsh_io_put_newline(io);
+    nsh_io_put_string(io, name);
+    for (size_t i = strlen(name); i < 8; i++) {
+        nsh_io_put_char(io, ' ');
+    }
+    cmd_builtin_put_column(io, (unsigned int)size, 7);
+    cmd_builtin_put_column(io, (unsigned int)peak, 7);
+    cmd_builtin_put_column(io, (unsigned int)(size - peak), 8);
+}
+
+nsh_status_t cmd_builtin_mem(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    NSH_UNUSED(argc);
+    NSH_UNUSED(argv);
+    nsh_t* nsh = ctx->nsh;
+
+    nsh_io_put_string(ctx->io, "buffer      size    peak headroom");
+    cmd_builtin_mem_put_row(ctx->io, "line", NSH_LINE_BUFFER_CAPACITY(&nsh->line),
+        nsh_mem_high_water_mark(nsh->line.buffer, NSH_LINE_BUFFER_CAPACITY(&nsh->line)));
+    // The output buffer is being written by this very command
+    cmd_builtin_mem_put_row(ctx->io, "output", sizeof(nsh->io.output),
+        nsh_mem_high_water_mark(nsh->io.output, sizeof(nsh->io.output)));
+#if NSH_FEATURE_USE_HISTORY == 1
+    cmd_builtin_mem_put_row(ctx->io, "history", NSH_HISTORY_RING_SIZE(&nsh->history),
+        nsh_mem_high_water_mark(nsh->history.ring, NSH_HISTORY_RING_SIZE(&nsh->history)));
+#endif
+    if (nsh->stack_limit != NULL) {
+        cmd_builtin_mem_put_row(ctx->io, "stack", nsh->stack_size,
+            nsh_mem_stack_high_water_mark(nsh->stack_limit, nsh->stack_size));
+    }
+    return NSH_STATUS_OK;
+}
+
+#endif
+
+#if NSH_FEATURE_USE_SCRIPTS == 1
+
+nsh_status_t cmd_builtin_script(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    nsh_script_t* script = &ctx->nsh->script;
+
+    if (argc > 1) {
+        // Join the arguments back into the source of the script
+        char source[NSH_LINE_BUFFER_SIZE];
+        size_t size = 0;
+        for (unsigned int i = 1; i < argc; i++) {
+            size_t arg_size = strlen(argv[i]);
+            if (size + arg_size + 1 > sizeof(source)) {
+                nsh_io_put_string(ctx->io, "ERROR: script too long");
+                return NSH_STATUS_BUFFER_OVERFLOW;
+            }
+            memcpy(&source[size], argv[i], arg_size);
+            size += arg_size;
+            source[size++] = (i + 1 < argc) ? ' ' : '\0';
+        }
+        nsh_status_t status = nsh_script_compile(script, ctx->nsh, source);
+        if (status != NSH_STATUS_OK) {
+            nsh_io_put_string(ctx->io, "ERROR: statement ");
+            nsh_io_put_unsigned(ctx->io, script->error_statement);
+            nsh_io_put_string(ctx->io, ": ");
+            nsh_io_put_string(ctx->io, script->error);
+            return NSH_STATUS_WRONG_ARG;
+        }
+    } else if (script->code_size == 0) {
+        nsh_io_put_string(ctx->io, "usage: script <statements separated by ';'>");
+        return NSH_STATUS_WRONG_ARG;
+    }
+
+    nsh_status_t status = nsh_script_run(script, ctx);
+    if (status == NSH_STATUS_WRONG_ARG && script->error != NULL) {
+        nsh_io_put_string(ctx->io, "ERROR: ");
+        nsh_io_put_string(ctx->io, script->error);
+    }
+    // The shell would report the script itself as not found
+    return (status == NSH_STATUS_CMD_NOT_FOUND) ? NSH_STATUS_FAILURE : status;
+}
+
+#endif
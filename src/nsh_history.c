@@ -7,39 +7,120 @@
 #include <nsh/nsh_history.h>
 #include <string.h>
 
+static unsigned int nsh_history_entry_size(const nsh_history_t* hist, unsigned int entry)
+{
+    return (unsigned char)hist->ring[entry];
+}
+
+static unsigned int nsh_history_record_size(const nsh_history_t* hist, unsigned int entry)
+{
+    return nsh_history_entry_size(hist, entry) + NSH_HISTORY_ENTRY_OVERHEAD;
+}
+
+static const char* nsh_history_entry_chars(const nsh_history_t* hist, unsigned int entry)
+{
+    return &hist->ring[entry + NSH_HISTORY_ENTRY_HEADER_SIZE];
+}
+
+static void nsh_history_drop_oldest(nsh_history_t* hist)
+{
+    hist->tail += nsh_history_record_size(hist, hist->tail);
+    hist->count--;
+
+    if (hist->count == 0) {
+        nsh_history_reset(hist);
+    } else if (hist->wrap != 0 && hist->tail == hist->wrap) {
+        // The oldest entry is now at the beginning of the ring
+        hist->tail = 0;
+        hist->wrap = 0;
+    }
+}
+
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+void nsh_history_set_storage(nsh_history_t* hist, char* ring, unsigned int ring_size, unsigned int entry_max_size)
+{
+    hist->ring = ring;
+    hist->ring_size = ring_size;
+    hist->entry_max_size = entry_max_size;
+}
+#endif
+
 void nsh_history_reset(nsh_history_t* hist)
 {
     hist->head = 0;
     hist->tail = 0;
-    hist->size = 0;
+    hist->wrap = 0;
+    hist->count = 0;
 }
 
 unsigned int nsh_history_entry_count(const nsh_history_t* hist)
 {
-    return hist->size;
+    return hist->count;
 }
 
 bool nsh_history_is_full(const nsh_history_t* hist)
 {
-    return (hist->size == NSH_CMD_HISTORY_SIZE);
+    unsigned int contiguous_space;
+    if (hist->wrap == 0) {
+        unsigned int space_at_end = NSH_HISTORY_RING_SIZE(hist) - hist->head;
+        contiguous_space = (space_at_end > hist->tail) ? space_at_end : hist->tail;
+    } else {
+        contiguous_space = hist->tail - hist->head;
+    }
+    // Full when an entry of maximum size would evict older ones
+    return (contiguous_space < NSH_HISTORY_ENTRY_MAX_SIZE(hist) + NSH_HISTORY_ENTRY_OVERHEAD);
 }
 
 bool nsh_history_is_empty(const nsh_history_t* hist)
 {
-    return (hist->size == 0);
+    return (hist->count == 0);
 }
 
-void nsh_history_add_entry(nsh_history_t* hist, const char* entry)
+bool nsh_history_add_entry(nsh_history_t* hist, const char* entry)
 {
-    strncpy(hist->entries[hist->head], entry, sizeof(hist->entries[hist->head]));
+    unsigned int size = (unsigned int)strlen(entry);
+    if (size > NSH_HISTORY_ENTRY_MAX_SIZE(hist)) {
+        size = NSH_HISTORY_ENTRY_MAX_SIZE(hist);
+    }
+    unsigned int record_size = size + NSH_HISTORY_ENTRY_OVERHEAD;
 
-    hist->head = (hist->head + 1) % NSH_CMD_HISTORY_SIZE;
+    // Do not memorize the same command several times in a row
+    unsigned int most_recent = nsh_history_most_recent(hist);
+    if (most_recent != NSH_HISTORY_INVALID_ENTRY && nsh_history_entry_size(hist, most_recent) == size
+        && memcmp(nsh_history_entry_chars(hist, most_recent), entry, size) == 0) {
+        return false;
+    }
 
-    if (nsh_history_is_full(hist)) {
-        hist->tail = (hist->tail + 1) % NSH_CMD_HISTORY_SIZE;
-    } else {
-        hist->size++;
+    // Find enough contiguous bytes at head, evicting the oldest entries if needed
+    while (true) {
+        if (hist->wrap == 0) {
+            if (hist->head + record_size <= NSH_HISTORY_RING_SIZE(hist)) {
+                break;
+            }
+            // Not enough room until the end of the ring, continue at its beginning
+            hist->wrap = hist->head;
+            hist->head = 0;
+        } else {
+            if (hist->head + record_size <= hist->tail) {
+                break;
+            }
+            nsh_history_drop_oldest(hist);
+        }
     }
+
+    char* record = &hist->ring[hist->head];
+    record[0] = (char)size;
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+    uint32_t signature = nsh_history_signature(entry, size);
+    memcpy(&record[1], &signature, sizeof(signature));
+#endif
+    memcpy(&record[NSH_HISTORY_ENTRY_HEADER_SIZE], entry, size);
+    record[record_size - 1] = (char)size;
+
+    hist->head += record_size;
+    hist->count++;
+
+    return true;
 }
 
 nsh_status_t nsh_history_get_entry(nsh_history_t* hist, unsigned int age, char* entry)
@@ -48,15 +129,143 @@ nsh_status_t nsh_history_get_entry(nsh_history_t* hist, unsigned int age, char*
         return NSH_STATUS_WRONG_ARG;
     }
 
-    unsigned int most_recent_entry = hist->head - 1; // head points to the element just after the most recent entry
-    unsigned int entry_index = most_recent_entry - age;
-    if (entry_index > NSH_CMD_HISTORY_SIZE) {
-        entry_index += NSH_CMD_HISTORY_SIZE;
+    unsigned int offset = nsh_history_most_recent(hist);
+    for (unsigned int i = 0; i < age; i++) {
+        offset = nsh_history_previous(hist, offset);
     }
 
-    strncpy(entry, hist->entries[entry_index], NSH_LINE_BUFFER_SIZE);
+    nsh_history_read_entry(hist, offset, entry);
 
     return NSH_STATUS_OK;
 }
 
+unsigned int nsh_history_most_recent(const nsh_history_t* hist)
+{
+    if (nsh_history_is_empty(hist)) {
+        return NSH_HISTORY_INVALID_ENTRY;
+    }
+    unsigned int end = hist->head; // head points just after the most recent entry
+    unsigned int size = (unsigned char)hist->ring[end - 1];
+    return end - size - NSH_HISTORY_ENTRY_OVERHEAD;
+}
+
+unsigned int nsh_history_oldest(const nsh_history_t* hist)
+{
+    return nsh_history_is_empty(hist) ? NSH_HISTORY_INVALID_ENTRY : hist->tail;
+}
+
+unsigned int nsh_history_previous(const nsh_history_t* hist, unsigned int entry)
+{
+    if (entry == NSH_HISTORY_INVALID_ENTRY || entry == hist->tail) {
+        return NSH_HISTORY_INVALID_ENTRY;
+    }
+    // The previous entry ends just before this one, or at the wrap offset for the first entry of the ring
+    unsigned int end = (entry == 0) ? hist->wrap : entry;
+    unsigned int size = (unsigned char)hist->ring[end - 1];
+    return end - size - NSH_HISTORY_ENTRY_OVERHEAD;
+}
+
+unsigned int nsh_history_next(const nsh_history_t* hist, unsigned int entry)
+{
+    if (entry == NSH_HISTORY_INVALID_ENTRY) {
+        return NSH_HISTORY_INVALID_ENTRY;
+    }
+    unsigned int next = entry + nsh_history_record_size(hist, entry);
+    if (hist->wrap != 0 && next == hist->wrap) {
+        next = 0;
+    }
+    return (next == hist->head) ? NSH_HISTORY_INVALID_ENTRY : next;
+}
+
+const char* nsh_history_view_entry(const nsh_history_t* hist, unsigned int entry, unsigned int* size)
+{
+    *size = nsh_history_entry_size(hist, entry);
+    return nsh_history_entry_chars(hist, entry);
+}
+
+unsigned int nsh_history_read_entry(const nsh_history_t* hist, unsigned int entry, char* buffer)
+{
+    unsigned int size = nsh_history_entry_size(hist, entry);
+    memcpy(buffer, nsh_history_entry_chars(hist, entry), size);
+    buffer[size] = '\0';
+    return size;
+}
+
+bool nsh_history_entry_starts_with(const nsh_history_t* hist, unsigned int entry, const char* prefix,
+    unsigned int prefix_size)
+{
+    return nsh_history_entry_size(hist, entry) >= prefix_size
+        && memcmp(nsh_history_entry_chars(hist, entry), prefix, prefix_size) == 0;
+}
+
+unsigned int nsh_history_find_prefix(const nsh_history_t* hist, const char* prefix, unsigned int prefix_size,
+    unsigned int entry)
+{
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+    uint32_t prefix_signature = nsh_history_signature(prefix, prefix_size);
+#endif
+
+    for (; entry != NSH_HISTORY_INVALID_ENTRY; entry = nsh_history_previous(hist, entry)) {
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+        // Skip the entries missing at least one character of the prefix without comparing them
+        uint32_t entry_signature;
+        memcpy(&entry_signature, &hist->ring[entry + 1], sizeof(entry_signature));
+        if ((entry_signature & prefix_signature) != prefix_signature) {
+            continue;
+        }
+#endif
+        if (nsh_history_entry_starts_with(hist, entry, prefix, prefix_size)) {
+            return entry;
+        }
+    }
+
+    return NSH_HISTORY_INVALID_ENTRY;
+}
+
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+
+uint32_t nsh_history_signature(const char* str, unsigned int size)
+{
+    uint32_t signature = 0;
+    for (unsigned int i = 0; i < size; i++) {
+        signature |= UINT32_C(1) << ((unsigned char)str[i] % 32u);
+    }
+    return signature;
+}
+
+static bool nsh_history_entry_contains(const nsh_history_t* hist, unsigned int entry, const char* pattern,
+    unsigned int pattern_size)
+{
+    unsigned int size = nsh_history_entry_size(hist, entry);
+    const char* chars = nsh_history_entry_chars(hist, entry);
+    for (unsigned int i = 0; i + pattern_size <= size; i++) {
+        if (memcmp(&chars[i], pattern, pattern_size) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned int nsh_history_search(const nsh_history_t* hist, const char* pattern, unsigned int pattern_size,
+    unsigned int entry)
+{
+    uint32_t pattern_signature = nsh_history_signature(pattern, pattern_size);
+
+    for (; entry != NSH_HISTORY_INVALID_ENTRY; entry = nsh_history_previous(hist, entry)) {
+        // Skip the entries missing at least one character of the pattern without scanning them
+        uint32_t entry_signature;
+        memcpy(&entry_signature, &hist->ring[entry + 1], sizeof(entry_signature));
+        if ((entry_signature & pattern_signature) != pattern_signature) {
+            continue;
+        }
+        if (nsh_history_entry_contains(hist, entry, pattern, pattern_size)) {
+            return entry;
+        }
+    }
+
+    return NSH_HISTORY_INVALID_ENTRY;
+}
+
+#endif // NSH_FEATURE_USE_HISTORY_SEARCH == 1
+
 #endif // NSH_FEATURE_USE_HISTORY == 1
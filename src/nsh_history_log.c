@@ -0,0 +1,221 @@
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+
+#include <nsh/nsh_history_log.h>
+
+#include <string.h>
+
+#define NSH_HISTORY_LOG_ERASED_BYTE 0xFFu // Value read from an erased Flash memory
+
+static nsh_status_t nsh_history_log_write_entry(const nsh_history_log_t* log, const nsh_history_t* hist,
+    unsigned int entry)
+{
+    unsigned char record[NSH_HISTORY_LOG_RECORD_HEADER_SIZE + NSH_HISTORY_ENTRY_BUFFER_SIZE];
+    unsigned int size;
+    const char* chars = nsh_history_view_entry(hist, entry, &size);
+
+    record[0] = NSH_HISTORY_LOG_RECORD_MAGIC;
+    record[1] = (unsigned char)size;
+    memcpy(&record[NSH_HISTORY_LOG_RECORD_HEADER_SIZE], chars, size);
+    uint16_t crc = nsh_history_log_crc16(0xFFFFu, &record[1], 1);
+    crc = nsh_history_log_crc16(crc, chars, size);
+    record[2] = (unsigned char)(crc >> 8u);
+    record[3] = (unsigned char)(crc & 0xFFu);
+
+    // A single append per record, so that a power loss can only corrupt the last one
+    return log->storage->append(log->storage->ctx, record, NSH_HISTORY_LOG_RECORD_HEADER_SIZE + size);
+}
+
+/*
+ * Start a new log containing the whole history.
+ * Used when the storage is full or when the log is corrupted.
+ */
+static nsh_status_t nsh_history_log_rewrite(nsh_history_log_t* log, const nsh_history_t* hist)
+{
+    nsh_status_t status = log->storage->rotate(log->storage->ctx);
+    if (status != NSH_STATUS_OK) {
+        return status;
+    }
+
+    log->pending = 0;
+
+    for (unsigned int entry = nsh_history_oldest(hist); entry != NSH_HISTORY_INVALID_ENTRY;
+         entry = nsh_history_next(hist, entry)) {
+        status = nsh_history_log_write_entry(log, hist, entry);
+        if (status != NSH_STATUS_OK) {
+            return status;
+        }
+    }
+
+    return NSH_STATUS_OK;
+}
+
+void nsh_history_log_init(nsh_history_log_t* log, const nsh_history_storage_t* storage)
+{
+    log->storage = storage;
+    log->pending = 0;
+}
+
+nsh_status_t nsh_history_log_load(nsh_history_log_t* log, nsh_history_t* hist)
+{
+    if (log->storage == NULL) {
+        return NSH_STATUS_OK;
+    }
+
+    unsigned char header[NSH_HISTORY_LOG_RECORD_HEADER_SIZE];
+    char entry[NSH_HISTORY_ENTRY_BUFFER_SIZE];
+    unsigned int offset = 0;
+    bool corrupted = false;
+
+    while (true) {
+        unsigned int read_size = log->storage->read(log->storage->ctx, offset, header, sizeof(header));
+        if (read_size == 0 || (read_size == sizeof(header) && header[0] == NSH_HISTORY_LOG_ERASED_BYTE)) {
+            break; // End of the log
+        }
+        if (read_size != sizeof(header) || header[0] != NSH_HISTORY_LOG_RECORD_MAGIC
+            || header[1] >= NSH_HISTORY_ENTRY_BUFFER_SIZE) {
+            corrupted = true;
+            break;
+        }
+
+        unsigned int size = header[1];
+        if (log->storage->read(log->storage->ctx, offset + sizeof(header), entry, size) != size) {
+            corrupted = true;
+            break;
+        }
+        uint16_t crc = nsh_history_log_crc16(0xFFFFu, &header[1], 1);
+        crc = nsh_history_log_crc16(crc, entry, size);
+        if (crc != (uint16_t)((header[2] << 8u) | header[3])) {
+            corrupted = true;
+            break;
+        }
+
+        entry[size] = '\0';
+        nsh_history_add_entry(hist, entry);
+        offset += (unsigned int)sizeof(header) + size;
+    }
+
+    log->pending = 0;
+
+    // Records appended after a corrupted one would never be replayed
+    return corrupted ? nsh_history_log_rewrite(log, hist) : NSH_STATUS_OK;
+}
+
+void nsh_history_log_add_entry(nsh_history_log_t* log, nsh_history_t* hist, const char* entry)
+{
+    if (nsh_history_add_entry(hist, entry) && log->storage != NULL) {
+        log->pending++;
+    }
+}
+
+bool nsh_history_log_is_batch_complete(const nsh_history_log_t* log)
+{
+    return (log->pending >= NSH_HISTORY_LOG_BATCH_SIZE);
+}
+
+nsh_status_t nsh_history_log_flush(nsh_history_log_t* log, const nsh_history_t* hist)
+{
+    if (log->storage == NULL || log->pending == 0) {
+        return NSH_STATUS_OK;
+    }
+
+    // Pending entries may have been evicted by more recent ones
+    if (log->pending > nsh_history_entry_count(hist)) {
+        log->pending = nsh_history_entry_count(hist);
+    }
+
+    // Write the pending entries from the oldest to the most recent one
+    unsigned int entry = nsh_history_most_recent(hist);
+    for (unsigned int i = 1; i < log->pending; i++) {
+        entry = nsh_history_previous(hist, entry);
+    }
+
+    for (; entry != NSH_HISTORY_INVALID_ENTRY; entry = nsh_history_next(hist, entry)) {
+        nsh_status_t status = nsh_history_log_write_entry(log, hist, entry);
+        if (status == NSH_STATUS_BUFFER_OVERFLOW) {
+            return nsh_history_log_rewrite(log, hist);
+        }
+        if (status != NSH_STATUS_OK) {
+            return status;
+        }
+        log->pending--;
+    }
+
+    return NSH_STATUS_OK;
+}
+
+uint16_t nsh_history_log_crc16(uint16_t crc, const void* data, unsigned int size)
+{
+    // CRC-16/CCITT-FALSE, bitwise to avoid a 512 bytes table
+    const unsigned char* bytes = data;
+    for (unsigned int i = 0; i < size; i++) {
+        crc ^= (uint16_t)(bytes[i] << 8u);
+        for (unsigned int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1u) ^ 0x1021u) : (uint16_t)(crc << 1u);
+        }
+    }
+    return crc;
+}
+
+static unsigned int nsh_history_file_read(void* ctx, unsigned int offset, void* data, unsigned int size)
+{
+    nsh_history_file_t* file = ctx;
+    if (file->file == NULL || fseek(file->file, (long)offset, SEEK_SET) != 0) {
+        return 0;
+    }
+    return (unsigned int)fread(data, 1, size, file->file);
+}
+
+static nsh_status_t nsh_history_file_append(void* ctx, const void* data, unsigned int size)
+{
+    nsh_history_file_t* file = ctx;
+    if (file->file == NULL || fseek(file->file, 0, SEEK_END) != 0 || fwrite(data, 1, size, file->file) != size
+        || fflush(file->file) != 0) {
+        return NSH_STATUS_FAILURE;
+    }
+    return NSH_STATUS_OK;
+}
+
+static nsh_status_t nsh_history_file_rotate(void* ctx)
+{
+    nsh_history_file_t* file = ctx;
+    // Open the truncated file before closing the current one, which is kept if the file cannot be truncated
+    FILE* truncated = fopen(file->path, "w+b");
+    if (truncated == NULL) {
+        return NSH_STATUS_FAILURE;
+    }
+    if (file->file != NULL) {
+        fclose(file->file);
+    }
+    file->file = truncated;
+    return NSH_STATUS_OK;
+}
+
+nsh_status_t nsh_history_file_storage_init(nsh_history_storage_t* storage, nsh_history_file_t* file, const char* path)
+{
+    file->path = path;
+    file->file = fopen(path, "a+b");
+    if (file->file == NULL) {
+        return NSH_STATUS_FAILURE;
+    }
+
+    storage->read = nsh_history_file_read;
+    storage->append = nsh_history_file_append;
+    storage->rotate = nsh_history_file_rotate;
+    storage->ctx = file;
+
+    return NSH_STATUS_OK;
+}
+
+void nsh_history_file_storage_close(nsh_history_file_t* file)
+{
+    if (file->file != NULL) {
+        fclose(file->file);
+        file->file = NULL;
+    }
+}
+
+#endif // NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
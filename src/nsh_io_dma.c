@@ -0,0 +1,128 @@
+#include <nsh/nsh_io_dma.h>
+
+#include <string.h>
+
+static void nsh_io_dma_idle(nsh_io_dma_t* dma)
+{
+    if (dma->driver->idle != NULL) {
+        dma->driver->idle(dma->driver->ctx);
+    }
+}
+
+/*
+ * Start transmitting the buffer being filled if the DMA is available, and fill the other one meanwhile.
+ */
+static void nsh_io_dma_start_tx(nsh_io_dma_t* dma)
+{
+    if (dma->tx_fill_size == 0 || NSH_ATOMIC_LOAD(&dma->tx_busy)) {
+        return;
+    }
+    // Set before starting, as the transfer may complete before start_tx() returns
+    NSH_ATOMIC_STORE(&dma->tx_busy, true);
+    dma->tx_count++;
+    const char* data = dma->tx_buffers[dma->tx_fill_index];
+    unsigned int size = dma->tx_fill_size;
+    dma->tx_fill_index ^= 1u;
+    dma->tx_fill_size = 0;
+    dma->driver->start_tx(dma->driver->ctx, data, size);
+}
+
+/*
+ * Push the received bytes into the ring, interrupting the running command on each Ctrl-C.
+ */
+static void nsh_io_dma_receive(nsh_io_dma_t* dma, const char* data, unsigned int size)
+{
+    if (dma->interrupt != NULL && memchr(data, NSH_IO_ETX, size) != NULL) {
+        dma->interrupt(dma->interrupt_ctx);
+    }
+    nsh_rx_ring_push(&dma->rx, data, size);
+}
+
+static int nsh_io_dma_read(void* ctx)
+{
+    nsh_io_dma_t* dma = (nsh_io_dma_t*)ctx;
+    char c;
+    while (nsh_rx_ring_pop(&dma->rx, &c, 1) == 0) {
+        nsh_io_dma_start_tx(dma);
+        nsh_io_dma_idle(dma);
+    }
+    return (unsigned char)c;
+}
+
+static void nsh_io_dma_write(void* ctx, const char* data, unsigned int size)
+{
+    nsh_io_dma_t* dma = (nsh_io_dma_t*)ctx;
+    while (size > 0) {
+        // Both buffers are full, wait for the transfer in progress to complete
+        while (dma->tx_fill_size == NSH_IO_DMA_TX_BUFFER_SIZE) {
+            nsh_io_dma_start_tx(dma);
+            if (dma->tx_fill_size != 0) {
+                nsh_io_dma_idle(dma);
+            }
+        }
+        unsigned int chunk_size = NSH_IO_DMA_TX_BUFFER_SIZE - dma->tx_fill_size;
+        if (chunk_size > size) {
+            chunk_size = size;
+        }
+        memcpy(&dma->tx_buffers[dma->tx_fill_index][dma->tx_fill_size], data, chunk_size);
+        dma->tx_fill_size += chunk_size;
+        data += chunk_size;
+        size -= chunk_size;
+    }
+    nsh_io_dma_start_tx(dma);
+}
+
+const nsh_io_backend_t nsh_io_dma_backend = {
+    .read = nsh_io_dma_read,
+    .write = nsh_io_dma_write,
+};
+
+void nsh_io_dma_init(nsh_io_dma_t* dma, const nsh_io_dma_driver_t* driver)
+{
+    dma->driver = driver;
+    dma->tx_fill_index = 0;
+    dma->tx_fill_size = 0;
+    dma->tx_busy = false;
+    dma->tx_count = 0;
+    nsh_rx_ring_init(&dma->rx);
+    dma->rx_position = 0;
+    dma->interrupt = NULL;
+    dma->interrupt_ctx = NULL;
+}
+
+void nsh_io_dma_set_interrupt_handler(nsh_io_dma_t* dma, void (*interrupt)(void* ctx), void* ctx)
+{
+    dma->interrupt = interrupt;
+    dma->interrupt_ctx = ctx;
+}
+
+void nsh_io_dma_tx_complete(nsh_io_dma_t* dma)
+{
+    NSH_ATOMIC_STORE(&dma->tx_busy, false);
+}
+
+void nsh_io_dma_rx_update(nsh_io_dma_t* dma, const char* buffer, unsigned int buffer_size,
+    unsigned int write_position)
+{
+    if (write_position > buffer_size) {
+        write_position = buffer_size;
+    }
+    if (write_position < dma->rx_position) {
+        // The DMA wrapped around the end of the buffer
+        nsh_io_dma_receive(dma, &buffer[dma->rx_position], buffer_size - dma->rx_position);
+        dma->rx_position = 0;
+    }
+    nsh_io_dma_receive(dma, &buffer[dma->rx_position], write_position - dma->rx_position);
+    // At the end of the buffer, the DMA continues from its beginning
+    dma->rx_position = (write_position == buffer_size) ? 0 : write_position;
+}
+
+void nsh_io_dma_flush(nsh_io_dma_t* dma)
+{
+    while (dma->tx_fill_size != 0 || NSH_ATOMIC_LOAD(&dma->tx_busy)) {
+        nsh_io_dma_start_tx(dma);
+        if (NSH_ATOMIC_LOAD(&dma->tx_busy)) {
+            nsh_io_dma_idle(dma);
+        }
+    }
+}
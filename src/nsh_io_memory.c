@@ -0,0 +1,41 @@
+#include <nsh/nsh_io_memory.h>
+
+#include <string.h>
+
+static int nsh_io_memory_read(void* ctx)
+{
+    nsh_io_memory_t* mem = (nsh_io_memory_t*)ctx;
+    if (mem->input_offset >= mem->input_size) {
+        return -1;
+    }
+    return (unsigned char)mem->input[mem->input_offset++];
+}
+
+static void nsh_io_memory_write(void* ctx, const char* data, unsigned int size)
+{
+    nsh_io_memory_t* mem = (nsh_io_memory_t*)ctx;
+    if (mem->output_size < mem->output_capacity) {
+        unsigned int copy_size = mem->output_capacity - mem->output_size;
+        if (copy_size > size) {
+            copy_size = size;
+        }
+        memcpy(&mem->output[mem->output_size], data, copy_size);
+    }
+    mem->output_size += size;
+}
+
+const nsh_io_backend_t nsh_io_memory_backend = {
+    .read = nsh_io_memory_read,
+    .write = nsh_io_memory_write,
+};
+
+void nsh_io_memory_init(nsh_io_memory_t* mem, const char* input, unsigned int input_size, char* output,
+    unsigned int output_capacity)
+{
+    mem->input = input;
+    mem->input_size = input_size;
+    mem->input_offset = 0;
+    mem->output = output;
+    mem->output_capacity = output_capacity;
+    mem->output_size = 0;
+}
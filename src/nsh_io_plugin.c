@@ -10,70 +10,354 @@
 #define NSH_IO_ERASE_LINE      NSH_IO_CSI "2K"
 #define NSH_IO_MOVE_BEGIN_LINE "\r"
 
-char nsh_io_get_char(void)
+static int nsh_io_stdio_read(void* ctx)
 {
-    int c;
-    while ((c = getchar()) == EOF)
-        ;
-    return (char)c;
+    NSH_UNUSED(ctx);
+    return getchar();
 }
 
-void nsh_io_put_char(char c)
+static void nsh_io_stdio_write(void* ctx, const char* data, unsigned int size)
 {
-    putchar(c);
+    NSH_UNUSED(ctx);
+    fwrite(data, 1, size, stdout);
+    fflush(stdout);
 }
 
-void nsh_io_put_newline(void)
+const nsh_io_backend_t nsh_io_stdio_backend = {
+    .read = nsh_io_stdio_read,
+    .write = nsh_io_stdio_write,
+};
+
+void nsh_io_init(nsh_io_t* io, const nsh_io_backend_t* backend, void* ctx)
+{
+    io->backend = backend;
+    io->ctx = ctx;
+    io->prompt = NSH_DEFAULT_PROMPT;
+    io->output_size = 0;
+#if NSH_FEATURE_USE_TRACE == 1
+    io->trace = NULL;
+#endif
+}
+
+void nsh_io_flush(nsh_io_t* io)
+{
+    if (io->output_size > 0) {
+        NSH_TRACE_BEGIN(io, FLUSH);
+        io->backend->write(io->ctx, io->output, io->output_size);
+        NSH_TRACE_END(io, FLUSH);
+        io->output_size = 0;
+    }
+}
+
+bool nsh_io_wait(nsh_io_t* io, unsigned int timeout_ms)
 {
-    nsh_io_put_char('\r');
-    nsh_io_put_char('\n');
+    nsh_io_flush(io);
+    if (io->backend->wait == NULL) {
+        return true;
+    }
+    return io->backend->wait(io->ctx, timeout_ms);
 }
 
-void nsh_io_put_string(const char* str)
+char nsh_io_get_char(nsh_io_t* io)
+{
+    nsh_io_flush(io);
+    NSH_TRACE_BEGIN(io, READ);
+    int c = io->backend->read(io->ctx);
+    NSH_TRACE_END(io, READ);
+    return (c < 0) ? NSH_IO_EOT : (char)c;
+}
+
+void nsh_io_put_char(nsh_io_t* io, char c)
+{
+    if (io->output_size == NSH_IO_OUTPUT_BUFFER_SIZE) {
+        nsh_io_flush(io);
+    }
+    io->output[io->output_size++] = c;
+}
+
+void nsh_io_put_newline(nsh_io_t* io)
+{
+    nsh_io_put_buffer(io, "\r\n", 2);
+}
+
+void nsh_io_put_string(nsh_io_t* io, const char* str)
 {
     // TODO This implementation is suboptimal as two loops are executed:
     // one by strlen, one by nsh_io_put_buffer...
     // Migrating from null-terminated strings to mcsl's string_view could
     // solve this issue.
-    nsh_io_put_buffer(str, (unsigned int)strlen(str));
+    nsh_io_put_buffer(io, str, (unsigned int)strlen(str));
 }
 
-void nsh_io_put_buffer(const char* str, unsigned int size)
+void nsh_io_put_buffer(nsh_io_t* io, const char* str, unsigned int size)
 {
-    for (unsigned int i = 0; i < size; i++) {
-        nsh_io_put_char(str[i]);
+    while (size > 0) {
+        if (io->output_size == NSH_IO_OUTPUT_BUFFER_SIZE) {
+            nsh_io_flush(io);
+        }
+        unsigned int chunk_size = NSH_IO_OUTPUT_BUFFER_SIZE - io->output_size;
+        if (chunk_size > size) {
+            chunk_size = size;
+        }
+        memcpy(&io->output[io->output_size], str, chunk_size);
+        io->output_size += chunk_size;
+        str += chunk_size;
+        size -= chunk_size;
     }
 }
 
-void nsh_io_print_prompt(void)
+void nsh_io_put_unsigned(nsh_io_t* io, unsigned int value)
 {
-    nsh_io_put_string(NSH_DEFAULT_PROMPT);
+    char digits[10]; // Enough for a 32-bit value
+    unsigned int count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10u);
+        value /= 10u;
+    } while (value != 0);
+    while (count > 0) {
+        nsh_io_put_char(io, digits[--count]);
+    }
 }
 
-void nsh_io_erase_last_char(void)
+void nsh_io_print_prompt(nsh_io_t* io)
 {
-    // go back to one character
-    putchar('\b');
-    // overwrite the char with whitespace
-    putchar(' ');
-    // go back to the now removed char position
-    putchar('\b');
+    nsh_io_put_string(io, io->prompt);
 }
 
-void nsh_io_erase_line(void)
+void nsh_io_erase_last_char(nsh_io_t* io)
 {
-    nsh_io_put_string(NSH_IO_ERASE_LINE);
-    nsh_io_put_string(NSH_IO_MOVE_BEGIN_LINE);
+    // go back to one character, overwrite the char with whitespace, then go
+    // back to the now removed char position
+    nsh_io_put_buffer(io, "\b \b", 3);
+}
+
+void nsh_io_erase_line(nsh_io_t* io)
+{
+    nsh_io_put_string(io, NSH_IO_ERASE_LINE);
+    nsh_io_put_string(io, NSH_IO_MOVE_BEGIN_LINE);
 }
 
 #if NSH_FEATURE_USE_PRINTF == 1
 #include <stdarg.h>
-int nsh_io_printf(const char* NSH_RESTRICT format, ...)
+#include <stddef.h>
+#include <stdint.h>
+
+// Format into the output buffer, flushing it first if the output does not fit, and return the appended size
+static unsigned int nsh_io_vformat(nsh_io_t* io, const char* format, va_list args)
+{
+    va_list args_copy;
+    va_copy(args_copy, args);
+    unsigned int space = NSH_IO_OUTPUT_BUFFER_SIZE - io->output_size;
+    int ret = vsnprintf(&io->output[io->output_size], space + 1, format, args_copy);
+    va_end(args_copy);
+    if (ret >= 0 && (unsigned int)ret > space && io->output_size > 0) {
+        nsh_io_flush(io);
+        space = NSH_IO_OUTPUT_BUFFER_SIZE;
+        ret = vsnprintf(io->output, space + 1, format, args);
+    }
+    if (ret <= 0) {
+        return 0;
+    }
+    unsigned int size = ((unsigned int)ret < space) ? (unsigned int)ret : space;
+    io->output_size += size;
+    return size;
+}
+
+static unsigned int nsh_io_format(nsh_io_t* io, const char* format, ...)
 {
     va_list args;
     va_start(args, format);
-    int ret = vprintf(format, args);
+    unsigned int size = nsh_io_vformat(io, format, args);
+    va_end(args);
+    return size;
+}
+
+static unsigned int nsh_io_put_padding(nsh_io_t* io, unsigned int size)
+{
+    for (unsigned int i = 0; i < size; i++) {
+        nsh_io_put_char(io, ' ');
+    }
+    return size;
+}
+
+static unsigned int nsh_io_put_formatted_string(nsh_io_t* io, const char* str, int width, int precision, bool left)
+{
+    unsigned int size = 0;
+    while ((precision < 0 || size < (unsigned int)precision) && str[size] != '\0') {
+        size++;
+    }
+    unsigned int padding = (width > 0 && (unsigned int)width > size) ? (unsigned int)width - size : 0;
+    unsigned int written = left ? 0 : nsh_io_put_padding(io, padding);
+    nsh_io_put_buffer(io, str, size);
+    written += size;
+    return written + (left ? nsh_io_put_padding(io, padding) : 0);
+}
+
+static int nsh_io_read_int(const char** format, va_list* args)
+{
+    if (**format == '*') {
+        (*format)++;
+        return va_arg(*args, int);
+    }
+    int value = 0;
+    while (**format >= '0' && **format <= '9') {
+        value = value * 10 + (*(*format)++ - '0');
+    }
+    return value;
+}
+
+// Format a single conversion specification, starting after its '%', with the width and precision passed as arguments
+static unsigned int nsh_io_stream_conversion(nsh_io_t* io, const char** format, va_list* args)
+{
+    char spec[16] = "%";
+    unsigned int spec_size = 1;
+    bool left = false;
+    while (**format != '\0' && strchr("-+ #0", **format) != NULL) {
+        left = left || (**format == '-');
+        // Repeated flags have no effect, so the ones not fitting can be dropped
+        if (spec_size < 6) {
+            spec[spec_size++] = **format;
+        }
+        (*format)++;
+    }
+    int width = nsh_io_read_int(format, args);
+    if (width < 0) {
+        left = true;
+        width = -width;
+    }
+    int precision = -1;
+    if (**format == '.') {
+        (*format)++;
+        precision = nsh_io_read_int(format, args);
+    }
+    spec[spec_size++] = '*';
+    if (precision >= 0) {
+        spec[spec_size++] = '.';
+        spec[spec_size++] = '*';
+    }
+    char length = '\0';
+    while (spec_size < 11 && **format != '\0' && strchr("hljztL", **format) != NULL) {
+        // A doubled modifier is stored as another letter: 'H' for hh and 'Q' for ll
+        length = (length == '\0') ? **format : ((length == 'h') ? 'H' : 'Q');
+        spec[spec_size++] = *(*format)++;
+    }
+    char conversion = **format;
+    if (conversion == '\0') {
+        return 0;
+    }
+    (*format)++;
+    spec[spec_size++] = conversion;
+    spec[spec_size] = '\0';
+
+#define NSH_IO_FORMAT_VALUE(type)                                                                                      \
+    ((precision >= 0) ? nsh_io_format(io, spec, width, precision, va_arg(*args, type))                                 \
+                      : nsh_io_format(io, spec, width, va_arg(*args, type)))
+
+    switch (conversion) {
+    case '%':
+        nsh_io_put_char(io, '%');
+        return 1;
+    case 's':
+        if (length == '\0') {
+            // Strings are the only conversions whose output is not bounded, so they are streamed
+            return nsh_io_put_formatted_string(io, va_arg(*args, const char*), width, precision, left);
+        }
+        return NSH_IO_FORMAT_VALUE(const void*);
+    case 'c':
+        return NSH_IO_FORMAT_VALUE(int);
+    case 'p':
+        return NSH_IO_FORMAT_VALUE(void*);
+    case 'd':
+    case 'i':
+        switch (length) {
+        case 'l':
+            return NSH_IO_FORMAT_VALUE(long);
+        case 'Q':
+            return NSH_IO_FORMAT_VALUE(long long);
+        case 'j':
+            return NSH_IO_FORMAT_VALUE(intmax_t);
+        case 'z':
+            return NSH_IO_FORMAT_VALUE(size_t);
+        case 't':
+            return NSH_IO_FORMAT_VALUE(ptrdiff_t);
+        default:
+            return NSH_IO_FORMAT_VALUE(int);
+        }
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+        switch (length) {
+        case 'l':
+            return NSH_IO_FORMAT_VALUE(unsigned long);
+        case 'Q':
+            return NSH_IO_FORMAT_VALUE(unsigned long long);
+        case 'j':
+            return NSH_IO_FORMAT_VALUE(uintmax_t);
+        case 'z':
+            return NSH_IO_FORMAT_VALUE(size_t);
+        case 't':
+            return NSH_IO_FORMAT_VALUE(ptrdiff_t);
+        default:
+            return NSH_IO_FORMAT_VALUE(unsigned int);
+        }
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        if (length == 'L') {
+            return NSH_IO_FORMAT_VALUE(long double);
+        }
+        return NSH_IO_FORMAT_VALUE(double);
+    default:
+        // %n and unknown conversions are not supported, their argument is left untouched
+        return 0;
+    }
+
+#undef NSH_IO_FORMAT_VALUE
+}
+
+int nsh_io_printf(nsh_io_t* io, const char* NSH_RESTRICT format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    // Format in place into the output buffer, flushing it first if the output does not fit
+    va_list args_copy;
+    va_copy(args_copy, args);
+    unsigned int space = NSH_IO_OUTPUT_BUFFER_SIZE - io->output_size;
+    int ret = vsnprintf(&io->output[io->output_size], space + 1, format, args_copy);
+    va_end(args_copy);
+    if (ret >= 0 && (unsigned int)ret > space && (unsigned int)ret <= NSH_IO_OUTPUT_BUFFER_SIZE) {
+        nsh_io_flush(io);
+        space = NSH_IO_OUTPUT_BUFFER_SIZE;
+        ret = vsnprintf(io->output, space + 1, format, args);
+    }
+    if (ret < 0 || (unsigned int)ret <= space) {
+        va_end(args);
+        io->output_size += (ret > 0) ? (unsigned int)ret : 0;
+        return ret;
+    }
+
+    // Longer than the output buffer: stream the output one conversion at a time
+    unsigned int written = 0;
+    const char* cursor = format;
+    while (*cursor != '\0') {
+        const char* percent = strchr(cursor, '%');
+        unsigned int literal_size = (percent != NULL) ? (unsigned int)(percent - cursor) : (unsigned int)strlen(cursor);
+        nsh_io_put_buffer(io, cursor, literal_size);
+        written += literal_size;
+        cursor += literal_size;
+        if (percent != NULL) {
+            cursor++;
+            written += nsh_io_stream_conversion(io, &cursor, &args);
+        }
+    }
     va_end(args);
-    return ret;
+    return (int)written;
 }
 #endif
@@ -0,0 +1,300 @@
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_JOBS == 1
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_job.h>
+
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * The state of a running job is changed by its worker, so it is accessed atomically.
+ */
+static nsh_job_state_t nsh_job_state(const nsh_job_t* job)
+{
+    return NSH_ATOMIC_LOAD(&job->state);
+}
+
+static int nsh_job_io_read(void* ctx)
+{
+    // Background jobs have no input
+    NSH_UNUSED(ctx);
+    return -1;
+}
+
+static void nsh_job_io_write(void* ctx, const char* data, unsigned int size)
+{
+    nsh_job_t* job = (nsh_job_t*)ctx;
+    job->executor->lock(job->executor->ctx);
+    unsigned int copy_size = NSH_JOB_OUTPUT_BUFFER_SIZE - job->output_size;
+    if (copy_size > size) {
+        copy_size = size;
+    }
+    memcpy(&job->output[job->output_size], data, copy_size);
+    job->output_size += copy_size;
+    if (copy_size < size) {
+        job->output_truncated = true;
+    }
+    job->executor->unlock(job->executor->ctx);
+}
+
+static const nsh_io_backend_t nsh_job_io_backend = {
+    .read = nsh_job_io_read,
+    .write = nsh_job_io_write,
+};
+
+static void nsh_job_finish(nsh_job_t* job, nsh_status_t status)
+{
+    nsh_io_flush(&job->io);
+
+    job->executor->lock(job->executor->ctx);
+    job->status = status;
+    NSH_ATOMIC_STORE(&job->state, NSH_JOB_STATE_DONE);
+    job->executor->unlock(job->executor->ctx);
+}
+
+static void nsh_job_run(void* arg)
+{
+    nsh_job_t* job = (nsh_job_t*)arg;
+
+    nsh_status_t status = job->handler(&job->ctx, job->argc, job->argv);
+    if (status != NSH_STATUS_PENDING) {
+        nsh_job_finish(job, status);
+    }
+}
+
+static void nsh_job_put_header(const nsh_job_table_t* table, const nsh_job_t* job, nsh_io_t* io)
+{
+    nsh_io_put_char(io, '[');
+    nsh_io_put_unsigned(io, nsh_job_id(table, job));
+    nsh_io_put_string(io, "] ");
+}
+
+/*
+ * Display the job output produced since the last call.
+ * Return true if the job is done, all its output being displayed.
+ */
+static bool nsh_job_display_output(nsh_job_table_t* table, nsh_job_t* job, nsh_io_t* io)
+{
+    // Copy the output under lock, and display it once unlocked to not block the job
+    char output[NSH_JOB_OUTPUT_BUFFER_SIZE];
+    table->executor->lock(table->executor->ctx);
+    unsigned int output_size = job->output_size;
+    bool truncated = job->output_truncated;
+    bool done = (nsh_job_state(job) == NSH_JOB_STATE_DONE);
+    memcpy(output, job->output, output_size);
+    job->output_size = 0;
+    job->output_truncated = false;
+    table->executor->unlock(table->executor->ctx);
+
+    if (output_size > 0) {
+        nsh_io_put_buffer(io, output, output_size);
+        if (output[output_size - 1] != '\n') {
+            nsh_io_put_newline(io);
+        }
+    }
+    if (truncated) {
+        nsh_job_put_header(table, job, io);
+        nsh_io_put_string(io, "output truncated\r\n");
+    }
+    return done;
+}
+
+static void nsh_job_report_done(nsh_job_table_t* table, nsh_job_t* job, nsh_io_t* io)
+{
+    nsh_job_put_header(table, job, io);
+    if (job->status == NSH_STATUS_OK) {
+        nsh_io_put_string(io, "Done ");
+    } else {
+        nsh_io_put_string(io, "Exit ");
+        nsh_io_put_unsigned(io, (unsigned int)job->status);
+        nsh_io_put_char(io, ' ');
+    }
+    nsh_io_put_string(io, job->args[0]);
+    nsh_io_put_newline(io);
+
+    // The job is done, the worker does not access it anymore
+    NSH_ATOMIC_STORE(&job->state, NSH_JOB_STATE_FREE);
+}
+
+void nsh_job_table_init(nsh_job_table_t* table, const nsh_executor_t* executor)
+{
+    table->executor = executor;
+    for (unsigned int i = 0; i < NSH_JOB_MAX_COUNT; i++) {
+        NSH_ATOMIC_STORE(&table->jobs[i].state, NSH_JOB_STATE_FREE);
+    }
+}
+
+nsh_status_t nsh_job_start(nsh_job_table_t* table, struct nsh_s* nsh, nsh_cmd_handler_t* handler,
+    unsigned int argc, char** argv, unsigned int* id)
+{
+    if (table->executor == NULL) {
+        return NSH_STATUS_UNSUPPORTED;
+    }
+    // The runtime limits may allow more arguments than a job holds
+    if (argc > NSH_CMD_ARGS_MAX_COUNT) {
+        return NSH_STATUS_MAX_ARGS_NB_REACH;
+    }
+
+    // Only the shell releases and takes slots, the workers never change a free slot
+    nsh_job_t* job = NULL;
+    for (unsigned int i = 0; i < NSH_JOB_MAX_COUNT && job == NULL; i++) {
+        if (nsh_job_state(&table->jobs[i]) == NSH_JOB_STATE_FREE) {
+            job = &table->jobs[i];
+        }
+    }
+    if (job == NULL) {
+        return NSH_STATUS_FAILURE;
+    }
+
+    NSH_ATOMIC_STORE(&job->state, NSH_JOB_STATE_RUNNING);
+    job->status = NSH_STATUS_OK;
+    job->executor = table->executor;
+    job->handler = handler;
+    nsh_cancel_token_init(&job->cancel, NULL, 0);
+    job->output_size = 0;
+    job->output_truncated = false;
+    nsh_io_init(&job->io, &nsh_job_io_backend, job);
+#if NSH_FEATURE_USE_TRACE == 1
+    job->io.trace = nsh->io.trace;
+#endif
+    job->ctx.nsh = nsh;
+    job->ctx.io = &job->io;
+    job->ctx.cancel = &job->cancel;
+
+    job->argc = argc;
+    for (unsigned int i = 0; i < job->argc; i++) {
+        strncpy(job->args[i], argv[i], NSH_MAX_STRING_SIZE - 1);
+        job->args[i][NSH_MAX_STRING_SIZE - 1] = '\0';
+        job->argv[i] = job->args[i];
+    }
+
+    *id = nsh_job_id(table, job);
+
+    if (table->executor->submit(table->executor->ctx, nsh_job_run, job) != NSH_STATUS_OK) {
+        NSH_ATOMIC_STORE(&job->state, NSH_JOB_STATE_FREE);
+        return NSH_STATUS_FAILURE;
+    }
+    return NSH_STATUS_OK;
+}
+
+void nsh_job_complete(nsh_cmd_ctx_t* ctx, nsh_status_t status)
+{
+    // The context given to a background handler is always the one of its job
+    nsh_job_t* job = (nsh_job_t*)(void*)((char*)ctx - offsetof(nsh_job_t, ctx));
+    nsh_job_finish(job, status);
+}
+
+unsigned int nsh_job_poll(nsh_job_table_t* table)
+{
+    if (table->executor == NULL || table->executor->poll == NULL) {
+        return NSH_IO_WAIT_FOREVER;
+    }
+    return table->executor->poll(table->executor->ctx);
+}
+
+nsh_job_t* nsh_job_find(nsh_job_table_t* table, unsigned int id)
+{
+    if (id == 0 || id > NSH_JOB_MAX_COUNT || nsh_job_state(&table->jobs[id - 1]) == NSH_JOB_STATE_FREE) {
+        return NULL;
+    }
+    return &table->jobs[id - 1];
+}
+
+nsh_job_t* nsh_job_find_last(nsh_job_table_t* table)
+{
+    for (unsigned int i = NSH_JOB_MAX_COUNT; i > 0; i--) {
+        if (nsh_job_state(&table->jobs[i - 1]) != NSH_JOB_STATE_FREE) {
+            return &table->jobs[i - 1];
+        }
+    }
+    return NULL;
+}
+
+unsigned int nsh_job_id(const nsh_job_table_t* table, const nsh_job_t* job)
+{
+    return (unsigned int)(job - table->jobs) + 1u;
+}
+
+void nsh_job_cancel(nsh_job_table_t* table, nsh_job_t* job)
+{
+    NSH_UNUSED(table);
+    nsh_cancel_token_cancel(&job->cancel);
+}
+
+bool nsh_job_has_news(nsh_job_table_t* table)
+{
+    if (table->executor == NULL) {
+        return false;
+    }
+
+    bool news = false;
+    table->executor->lock(table->executor->ctx);
+    for (unsigned int i = 0; i < NSH_JOB_MAX_COUNT && !news; i++) {
+        const nsh_job_t* job = &table->jobs[i];
+        news = (nsh_job_state(job) == NSH_JOB_STATE_DONE)
+            || (nsh_job_state(job) == NSH_JOB_STATE_RUNNING && (job->output_size > 0 || job->output_truncated));
+    }
+    table->executor->unlock(table->executor->ctx);
+    return news;
+}
+
+void nsh_job_display_news(nsh_job_table_t* table, nsh_io_t* io)
+{
+    for (unsigned int i = 0; i < NSH_JOB_MAX_COUNT; i++) {
+        nsh_job_t* job = &table->jobs[i];
+        if (nsh_job_state(job) != NSH_JOB_STATE_FREE && nsh_job_display_output(table, job, io)) {
+            nsh_job_report_done(table, job, io);
+        }
+    }
+}
+
+nsh_status_t nsh_job_wait(nsh_job_table_t* table, nsh_job_t* job, const nsh_cmd_ctx_t* ctx)
+{
+    while (!nsh_job_display_output(table, job, ctx->io)) {
+        if (nsh_cmd_is_cancelled(ctx)) {
+            return NSH_STATUS_CANCELLED;
+        }
+        nsh_io_flush(ctx->io);
+        table->executor->yield(table->executor->ctx);
+    }
+    nsh_status_t status = job->status;
+    nsh_job_report_done(table, job, ctx->io);
+    return status;
+}
+
+void nsh_job_terminate_all(nsh_job_table_t* table, nsh_io_t* io)
+{
+    for (unsigned int i = 0; i < NSH_JOB_MAX_COUNT; i++) {
+        nsh_job_cancel(table, &table->jobs[i]);
+    }
+    const nsh_cmd_ctx_t ctx = { .nsh = NULL, .io = io, .cancel = NULL };
+    for (unsigned int i = 0; i < NSH_JOB_MAX_COUNT; i++) {
+        if (nsh_job_state(&table->jobs[i]) != NSH_JOB_STATE_FREE) {
+            nsh_job_wait(table, &table->jobs[i], &ctx);
+        }
+    }
+}
+
+void nsh_job_list(nsh_job_table_t* table, nsh_io_t* io)
+{
+    for (unsigned int i = 0; i < NSH_JOB_MAX_COUNT; i++) {
+        nsh_job_t* job = &table->jobs[i];
+        if (nsh_job_state(job) == NSH_JOB_STATE_FREE) {
+            continue;
+        }
+        table->executor->lock(table->executor->ctx);
+        bool done = (nsh_job_state(job) == NSH_JOB_STATE_DONE);
+        table->executor->unlock(table->executor->ctx);
+
+        nsh_job_put_header(table, job, io);
+        nsh_io_put_string(io, done ? "Done    " : "Running ");
+        nsh_io_put_string(io, job->args[0]);
+        nsh_io_put_newline(io);
+    }
+}
+
+#endif // NSH_FEATURE_USE_JOBS == 1
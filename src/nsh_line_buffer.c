@@ -2,6 +2,14 @@
 
 #include <stdio.h>
 
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+void nsh_line_buffer_set_storage(nsh_line_buffer_t* linebuf, char* storage, unsigned int capacity)
+{
+    linebuf->buffer = storage;
+    linebuf->capacity = capacity;
+}
+#endif
+
 void nsh_line_buffer_reset(nsh_line_buffer_t* linebuf)
 {
     linebuf->size = 0;
@@ -21,7 +29,7 @@ nsh_status_t nsh_line_buffer_append_char(nsh_line_buffer_t* linebuf, char c)
 void nsh_line_buffer_append_null(nsh_line_buffer_t* linebuf)
 {
     if (nsh_line_buffer_is_full(linebuf)) {
-        linebuf->buffer[NSH_LINE_BUFFER_SIZE - 1] = '\0'; // overwrite last char to ensure the buffer is null terminated
+        linebuf->buffer[NSH_LINE_BUFFER_CAPACITY(linebuf) - 1] = '\0'; // overwrite last char to ensure the buffer is null terminated
     } else {
         nsh_line_buffer_append_char(linebuf, '\0');
     }
@@ -36,7 +44,7 @@ void nsh_line_buffer_erase_last_char(nsh_line_buffer_t* linebuf)
 
 bool nsh_line_buffer_is_full(nsh_line_buffer_t* linebuf)
 {
-    return (linebuf->size >= NSH_LINE_BUFFER_SIZE);
+    return (linebuf->size >= NSH_LINE_BUFFER_CAPACITY(linebuf));
 }
 
 bool nsh_line_buffer_is_empty(nsh_line_buffer_t* linebuf)
@@ -0,0 +1,77 @@
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+
+#include <nsh/nsh_log.h>
+
+#include <string.h>
+
+void nsh_log_queue_init(nsh_log_queue_t* queue)
+{
+    for (unsigned int i = 0; i < NSH_LOG_QUEUE_SIZE; i++) {
+        queue->slots[i].sequence = i;
+        queue->slots[i].size = 0;
+    }
+    queue->enqueue_position = 0;
+    queue->dequeue_position = 0;
+    queue->dropped_count = 0;
+}
+
+bool nsh_log_queue_push(nsh_log_queue_t* queue, const char* message, unsigned int size)
+{
+    unsigned int position = NSH_ATOMIC_LOAD(&queue->enqueue_position);
+    nsh_log_slot_t* slot;
+    while (true) {
+        slot = &queue->slots[position & (NSH_LOG_QUEUE_SIZE - 1u)];
+        int lag = (int)(NSH_ATOMIC_LOAD(&slot->sequence) - position);
+        if (lag == 0) {
+            // The slot is free, reserve it unless another producer did it first
+            if (NSH_ATOMIC_COMPARE_EXCHANGE(&queue->enqueue_position, &position, position + 1u)) {
+                break;
+            }
+        } else if (lag < 0) {
+            // The slot still holds the message enqueued one lap before
+            NSH_ATOMIC_FETCH_ADD(&queue->dropped_count, 1u);
+            return false;
+        } else {
+            position = NSH_ATOMIC_LOAD(&queue->enqueue_position);
+        }
+    }
+
+    slot->size = (size < NSH_LOG_MESSAGE_SIZE) ? size : NSH_LOG_MESSAGE_SIZE;
+    memcpy(slot->message, message, slot->size);
+    NSH_ATOMIC_STORE(&slot->sequence, position + 1u);
+    return true;
+}
+
+bool nsh_log_queue_pop(nsh_log_queue_t* queue, char* message, unsigned int* size)
+{
+    unsigned int position = queue->dequeue_position;
+    nsh_log_slot_t* slot = &queue->slots[position & (NSH_LOG_QUEUE_SIZE - 1u)];
+    if (NSH_ATOMIC_LOAD(&slot->sequence) != position + 1u) {
+        return false;
+    }
+
+    *size = slot->size;
+    memcpy(message, slot->message, slot->size);
+    // Free the slot for the enqueue position of the next lap
+    NSH_ATOMIC_STORE(&slot->sequence, position + NSH_LOG_QUEUE_SIZE);
+    queue->dequeue_position = position + 1u;
+    return true;
+}
+
+bool nsh_log_queue_is_empty(const nsh_log_queue_t* queue)
+{
+    unsigned int position = queue->dequeue_position;
+    const nsh_log_slot_t* slot = &queue->slots[position & (NSH_LOG_QUEUE_SIZE - 1u)];
+    return NSH_ATOMIC_LOAD(&slot->sequence) != position + 1u;
+}
+
+unsigned int nsh_log_queue_dropped_count(const nsh_log_queue_t* queue)
+{
+    return NSH_ATOMIC_LOAD(&queue->dropped_count);
+}
+
+#endif // NSH_FEATURE_USE_ASYNC_LOG == 1
@@ -0,0 +1,49 @@
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+
+#include <nsh/nsh_mem.h>
+
+#include <stdint.h>
+#include <string.h>
+
+void nsh_mem_paint(void* buffer, size_t size)
+{
+    memset(buffer, NSH_MEM_PAINT_BYTE, size);
+}
+
+size_t nsh_mem_high_water_mark(const void* buffer, size_t size)
+{
+    const unsigned char* bytes = buffer;
+    while (size > 0 && bytes[size - 1] == NSH_MEM_PAINT_BYTE) {
+        size--;
+    }
+    return size;
+}
+
+nsh_status_t nsh_mem_paint_stack(void* stack_limit, size_t size)
+{
+    // The address of a local variable approximates the stack pointer
+    volatile char frame_marker = 0;
+    uintptr_t frame = (uintptr_t)&frame_marker;
+    uintptr_t limit = (uintptr_t)stack_limit;
+    if (frame < limit + NSH_MEM_STACK_PAINT_MARGIN || frame >= limit + size) {
+        return NSH_STATUS_WRONG_ARG;
+    }
+    nsh_mem_paint(stack_limit, frame - limit - NSH_MEM_STACK_PAINT_MARGIN);
+    return NSH_STATUS_OK;
+}
+
+size_t nsh_mem_stack_high_water_mark(const void* stack_limit, size_t size)
+{
+    const unsigned char* bytes = stack_limit;
+    size_t unused = 0;
+    while (unused < size && bytes[unused] == NSH_MEM_PAINT_BYTE) {
+        unused++;
+    }
+    return size - unused;
+}
+
+#endif // NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
@@ -0,0 +1,380 @@
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_PIPES == 1
+
+#include <nsh/nsh_pipe.h>
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int nsh_pipe_io_read(void* ctx)
+{
+    // Commands piped into a filter have no input
+    NSH_UNUSED(ctx);
+    return -1;
+}
+
+/*
+ * Hand the flushed output buffer of the previous stage over to the filter, without copying it.
+ */
+static void nsh_pipe_io_write(void* ctx, const char* data, unsigned int size)
+{
+    nsh_pipe_stage_t* stage = (nsh_pipe_stage_t*)ctx;
+    stage->filter->write(stage, data, size);
+}
+
+static const nsh_io_backend_t nsh_pipe_io_backend = {
+    .read = nsh_pipe_io_read,
+    .write = nsh_pipe_io_write,
+};
+
+/*
+ * Parse a decimal unsigned integer, returning false if 'str' is not one.
+ */
+static bool nsh_pipe_parse_unsigned(const char* str, unsigned int* value)
+{
+    char* end;
+    unsigned long parsed = strtoul(str, &end, 10);
+    if (str[0] < '0' || str[0] > '9' || *end != '\0' || parsed > UINT_MAX) {
+        return false;
+    }
+    *value = (unsigned int)parsed;
+    return true;
+}
+
+static void nsh_pipe_put_hex(nsh_io_t* io, unsigned int value, unsigned int digits)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    char str[8];
+    for (unsigned int i = digits; i > 0; i--) {
+        str[i - 1] = hex_digits[value & 0xFu];
+        value >>= 4;
+    }
+    nsh_io_put_buffer(io, str, digits);
+}
+
+/*
+ * grep [-v] <pattern>: keep the lines containing the pattern, or not containing it with -v.
+ */
+static nsh_status_t nsh_pipe_grep_start(nsh_pipe_stage_t* stage, unsigned int argc, char** argv)
+{
+    bool invert = (argc == 3 && strcmp(argv[1], "-v") == 0);
+    if (argc != (invert ? 3u : 2u)) {
+        nsh_io_put_string(stage->output, "usage: grep [-v] <pattern>\r\n");
+        return NSH_STATUS_WRONG_ARG;
+    }
+    stage->state.grep.pattern = argv[argc - 1];
+    stage->state.grep.pattern_size = (unsigned int)strlen(argv[argc - 1]);
+    stage->state.grep.invert = invert;
+    stage->state.grep.line_size = 0;
+    return NSH_STATUS_OK;
+}
+
+static bool nsh_pipe_grep_match(const nsh_pipe_stage_t* stage)
+{
+    const char* line = stage->state.grep.line;
+    unsigned int line_size = stage->state.grep.line_size;
+    unsigned int pattern_size = stage->state.grep.pattern_size;
+    for (unsigned int i = 0; i + pattern_size <= line_size; i++) {
+        if (memcmp(&line[i], stage->state.grep.pattern, pattern_size) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Output the buffered line if it is kept, ending it if it was cut because the buffer is full.
+ */
+static void nsh_pipe_grep_filter_line(nsh_pipe_stage_t* stage, bool complete)
+{
+    if (nsh_pipe_grep_match(stage) != stage->state.grep.invert) {
+        nsh_io_put_buffer(stage->output, stage->state.grep.line, stage->state.grep.line_size);
+        if (!complete) {
+            nsh_io_put_newline(stage->output);
+        }
+    }
+    stage->state.grep.line_size = 0;
+}
+
+static void nsh_pipe_grep_write(nsh_pipe_stage_t* stage, const char* data, unsigned int size)
+{
+    for (unsigned int i = 0; i < size; i++) {
+        stage->state.grep.line[stage->state.grep.line_size++] = data[i];
+        if (data[i] == '\n') {
+            nsh_pipe_grep_filter_line(stage, true);
+        } else if (stage->state.grep.line_size == NSH_PIPE_LINE_SIZE) {
+            nsh_pipe_grep_filter_line(stage, false);
+        }
+    }
+}
+
+static void nsh_pipe_grep_finish(nsh_pipe_stage_t* stage)
+{
+    if (stage->state.grep.line_size > 0) {
+        nsh_pipe_grep_filter_line(stage, false);
+    }
+}
+
+/*
+ * head [-n <lines>]: keep the first lines, 10 by default, then stop the command.
+ */
+static nsh_status_t nsh_pipe_head_start(nsh_pipe_stage_t* stage, unsigned int argc, char** argv)
+{
+    stage->state.head.remaining_lines = 10;
+    if (argc == 1
+        || (argc == 3 && strcmp(argv[1], "-n") == 0
+            && nsh_pipe_parse_unsigned(argv[2], &stage->state.head.remaining_lines))) {
+        return NSH_STATUS_OK;
+    }
+    nsh_io_put_string(stage->output, "usage: head [-n <lines>]\r\n");
+    return NSH_STATUS_WRONG_ARG;
+}
+
+static void nsh_pipe_head_write(nsh_pipe_stage_t* stage, const char* data, unsigned int size)
+{
+    unsigned int kept_size = 0;
+    while (kept_size < size && stage->state.head.remaining_lines > 0) {
+        if (data[kept_size++] == '\n') {
+            stage->state.head.remaining_lines--;
+        }
+    }
+    nsh_io_put_buffer(stage->output, data, kept_size);
+    if (stage->state.head.remaining_lines == 0) {
+        nsh_pipe_stage_stop(stage);
+    }
+}
+
+/*
+ * wc: count the lines, words and bytes.
+ */
+static nsh_status_t nsh_pipe_wc_start(nsh_pipe_stage_t* stage, unsigned int argc, char** argv)
+{
+    NSH_UNUSED(argv);
+    if (argc != 1) {
+        nsh_io_put_string(stage->output, "usage: wc\r\n");
+        return NSH_STATUS_WRONG_ARG;
+    }
+    memset(&stage->state.wc, 0, sizeof(stage->state.wc));
+    return NSH_STATUS_OK;
+}
+
+static void nsh_pipe_wc_write(nsh_pipe_stage_t* stage, const char* data, unsigned int size)
+{
+    for (unsigned int i = 0; i < size; i++) {
+        char c = data[i];
+        bool is_space = (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+        if (c == '\n') {
+            stage->state.wc.lines++;
+        }
+        if (!is_space && !stage->state.wc.in_word) {
+            stage->state.wc.words++;
+        }
+        stage->state.wc.in_word = !is_space;
+    }
+    stage->state.wc.bytes += size;
+}
+
+static void nsh_pipe_wc_finish(nsh_pipe_stage_t* stage)
+{
+    nsh_io_put_unsigned(stage->output, stage->state.wc.lines);
+    nsh_io_put_char(stage->output, ' ');
+    nsh_io_put_unsigned(stage->output, stage->state.wc.words);
+    nsh_io_put_char(stage->output, ' ');
+    nsh_io_put_unsigned(stage->output, stage->state.wc.bytes);
+    nsh_io_put_newline(stage->output);
+}
+
+/*
+ * hex: dump the bytes in hexadecimal, 16 per row, preceded by their offset and followed by their printable characters.
+ */
+static nsh_status_t nsh_pipe_hex_start(nsh_pipe_stage_t* stage, unsigned int argc, char** argv)
+{
+    NSH_UNUSED(argv);
+    if (argc != 1) {
+        nsh_io_put_string(stage->output, "usage: hex\r\n");
+        return NSH_STATUS_WRONG_ARG;
+    }
+    stage->state.hex.offset = 0;
+    stage->state.hex.row_size = 0;
+    return NSH_STATUS_OK;
+}
+
+static void nsh_pipe_hex_put_row(nsh_pipe_stage_t* stage)
+{
+    nsh_io_t* io = stage->output;
+    const unsigned int row_capacity = (unsigned int)sizeof(stage->state.hex.row);
+    nsh_pipe_put_hex(io, stage->state.hex.offset, 8);
+    nsh_io_put_char(io, ' ');
+    for (unsigned int i = 0; i < row_capacity; i++) {
+        nsh_io_put_char(io, ' ');
+        if (i < stage->state.hex.row_size) {
+            nsh_pipe_put_hex(io, stage->state.hex.row[i], 2);
+        } else {
+            nsh_io_put_buffer(io, "  ", 2);
+        }
+    }
+    nsh_io_put_buffer(io, "  |", 3);
+    for (unsigned int i = 0; i < stage->state.hex.row_size; i++) {
+        unsigned char c = stage->state.hex.row[i];
+        nsh_io_put_char(io, (c >= ' ' && c <= '~') ? (char)c : '.');
+    }
+    nsh_io_put_char(io, '|');
+    nsh_io_put_newline(io);
+    stage->state.hex.offset += stage->state.hex.row_size;
+    stage->state.hex.row_size = 0;
+}
+
+static void nsh_pipe_hex_write(nsh_pipe_stage_t* stage, const char* data, unsigned int size)
+{
+    for (unsigned int i = 0; i < size; i++) {
+        stage->state.hex.row[stage->state.hex.row_size++] = (unsigned char)data[i];
+        if (stage->state.hex.row_size == sizeof(stage->state.hex.row)) {
+            nsh_pipe_hex_put_row(stage);
+        }
+    }
+}
+
+static void nsh_pipe_hex_finish(nsh_pipe_stage_t* stage)
+{
+    if (stage->state.hex.row_size > 0) {
+        nsh_pipe_hex_put_row(stage);
+    }
+}
+
+static const nsh_pipe_filter_t nsh_pipe_filters[] = {
+    { "grep", nsh_pipe_grep_start, nsh_pipe_grep_write, nsh_pipe_grep_finish },
+    { "head", nsh_pipe_head_start, nsh_pipe_head_write, NULL },
+    { "hex", nsh_pipe_hex_start, nsh_pipe_hex_write, nsh_pipe_hex_finish },
+    { "wc", nsh_pipe_wc_start, nsh_pipe_wc_write, nsh_pipe_wc_finish },
+};
+
+const nsh_pipe_filter_t* nsh_pipe_find_filter(const char* name)
+{
+    for (unsigned int i = 0; i < sizeof(nsh_pipe_filters) / sizeof(nsh_pipe_filters[0]); i++) {
+        if (strcmp(nsh_pipe_filters[i].name, name) == 0) {
+            return &nsh_pipe_filters[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Return the index of the next pipe operator in 'argv' from 'first', or 'argc' if there is none.
+ */
+static unsigned int nsh_pipe_find_operator(unsigned int argc, char** argv, unsigned int first)
+{
+    unsigned int i = first;
+    while (i < argc && strcmp(argv[i], NSH_PIPE_OPERATOR) != 0) {
+        i++;
+    }
+    return i;
+}
+
+nsh_status_t nsh_pipeline_open(nsh_pipeline_t* pipeline, nsh_io_t* output, nsh_cancel_token_t* cancel,
+    unsigned int* argc, char** argv)
+{
+    pipeline->count = 0;
+    pipeline->output = output;
+    pipeline->cancel = cancel;
+    pipeline->closed = false;
+
+    unsigned int end = nsh_pipe_find_operator(*argc, argv, 0);
+    if (end == *argc) {
+        return NSH_STATUS_OK;
+    }
+    unsigned int command_argc = end;
+
+    // Find the filters, each one following a pipe operator
+    while (end < *argc) {
+        unsigned int begin = end + 1;
+        end = nsh_pipe_find_operator(*argc, argv, begin);
+        if (command_argc == 0 || begin == end) {
+            nsh_io_put_string(output, "ERROR: missing command around '" NSH_PIPE_OPERATOR "'\r\n");
+            pipeline->count = 0;
+            return NSH_STATUS_WRONG_ARG;
+        }
+        if (pipeline->count == NSH_PIPE_MAX_FILTERS) {
+            nsh_io_put_string(output, "ERROR: too many filters\r\n");
+            pipeline->count = 0;
+            return NSH_STATUS_WRONG_ARG;
+        }
+        const nsh_pipe_filter_t* filter = nsh_pipe_find_filter(argv[begin]);
+        if (filter == NULL) {
+            nsh_io_put_string(output, "ERROR: filter '");
+            nsh_io_put_string(output, argv[begin]);
+            nsh_io_put_string(output, "' not found\r\n");
+            pipeline->count = 0;
+            return NSH_STATUS_WRONG_ARG;
+        }
+        nsh_pipe_stage_t* stage = &pipeline->stages[pipeline->count++];
+        stage->filter = filter;
+        stage->pipeline = pipeline;
+        nsh_io_init(&stage->input, &nsh_pipe_io_backend, stage);
+#if NSH_FEATURE_USE_TRACE == 1
+        stage->input.trace = output->trace;
+#endif
+    }
+
+    // Start the filters with their arguments, their usage being written to the output of the pipeline
+    end = command_argc;
+    for (unsigned int i = 0; i < pipeline->count; i++) {
+        nsh_pipe_stage_t* stage = &pipeline->stages[i];
+        stage->output = output;
+
+        unsigned int begin = end + 1;
+        end = nsh_pipe_find_operator(*argc, argv, begin);
+        nsh_status_t status = stage->filter->start(stage, end - begin, &argv[begin]);
+        if (status != NSH_STATUS_OK) {
+            pipeline->count = 0;
+            return status;
+        }
+    }
+
+    // Chain the filters, each one writing to the input of the next one
+    for (unsigned int i = 0; i + 1 < pipeline->count; i++) {
+        pipeline->stages[i].output = &pipeline->stages[i + 1].input;
+    }
+
+    *argc = command_argc;
+    return NSH_STATUS_OK;
+}
+
+nsh_io_t* nsh_pipeline_input(nsh_pipeline_t* pipeline)
+{
+    return (pipeline->count > 0) ? &pipeline->stages[0].input : pipeline->output;
+}
+
+void nsh_pipeline_set_output(nsh_pipeline_t* pipeline, nsh_io_t* output)
+{
+    pipeline->output = output;
+    if (pipeline->count > 0) {
+        pipeline->stages[pipeline->count - 1].output = output;
+    }
+}
+
+void nsh_pipeline_close(nsh_pipeline_t* pipeline)
+{
+    for (unsigned int i = 0; i < pipeline->count; i++) {
+        nsh_pipe_stage_t* stage = &pipeline->stages[i];
+        nsh_io_flush(&stage->input);
+        if (stage->filter->finish != NULL) {
+            stage->filter->finish(stage);
+        }
+    }
+    pipeline->count = 0;
+}
+
+void nsh_pipe_stage_stop(nsh_pipe_stage_t* stage)
+{
+    nsh_pipeline_t* pipeline = stage->pipeline;
+    if (!pipeline->closed) {
+        pipeline->closed = true;
+        nsh_cancel_token_cancel(pipeline->cancel);
+    }
+}
+
+#endif // NSH_FEATURE_USE_PIPES == 1
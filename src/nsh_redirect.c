@@ -0,0 +1,102 @@
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_REDIRECTION == 1
+
+#include <nsh/nsh_redirect.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static void* nsh_redirect_stdio_open(const char* path, bool append)
+{
+    return fopen(path, append ? "ab" : "wb");
+}
+
+static void nsh_redirect_stdio_write(void* file, const char* data, unsigned int size)
+{
+    fwrite(data, 1, size, (FILE*)file);
+}
+
+static nsh_status_t nsh_redirect_stdio_close(void* file)
+{
+    bool failed = ferror((FILE*)file) != 0;
+    // fclose() writes the buffered bytes, and reports if it could not
+    if (fclose((FILE*)file) != 0) {
+        failed = true;
+    }
+    return failed ? NSH_STATUS_FAILURE : NSH_STATUS_OK;
+}
+
+const nsh_redirect_backend_t nsh_redirect_stdio_backend = {
+    .open = nsh_redirect_stdio_open,
+    .write = nsh_redirect_stdio_write,
+    .close = nsh_redirect_stdio_close,
+};
+
+static int nsh_redirect_io_read(void* ctx)
+{
+    // Commands whose output is redirected have no input
+    NSH_UNUSED(ctx);
+    return -1;
+}
+
+static void nsh_redirect_io_write(void* ctx, const char* data, unsigned int size)
+{
+    nsh_redirect_t* redirect = (nsh_redirect_t*)ctx;
+    redirect->backend->write(redirect->file, data, size);
+}
+
+static const nsh_io_backend_t nsh_redirect_io_backend = {
+    .read = nsh_redirect_io_read,
+    .write = nsh_redirect_io_write,
+};
+
+void nsh_redirect_init(nsh_redirect_t* redirect, const nsh_redirect_backend_t* backend)
+{
+    redirect->backend = backend;
+    redirect->file = NULL;
+}
+
+nsh_status_t nsh_redirect_parse(unsigned int* argc, char** argv, const char** path, bool* append)
+{
+    *path = NULL;
+    *append = false;
+    for (unsigned int i = 0; i < *argc; i++) {
+        bool is_append = (strcmp(argv[i], NSH_REDIRECT_APPEND_OPERATOR) == 0);
+        if (!is_append && strcmp(argv[i], NSH_REDIRECT_OPERATOR) != 0) {
+            continue;
+        }
+        // The operator and the file name end the command line
+        if (i + 2 != *argc) {
+            return NSH_STATUS_WRONG_ARG;
+        }
+        *path = argv[i + 1];
+        *append = is_append;
+        *argc = i;
+        break;
+    }
+    return NSH_STATUS_OK;
+}
+
+nsh_status_t nsh_redirect_open(nsh_redirect_t* redirect, const char* path, bool append)
+{
+    // Set up the I/O on each use, since nsh_init() returns the shell by value
+    nsh_io_init(&redirect->io, &nsh_redirect_io_backend, redirect);
+    redirect->file = redirect->backend->open(path, append);
+    return (redirect->file != NULL) ? NSH_STATUS_OK : NSH_STATUS_FAILURE;
+}
+
+nsh_status_t nsh_redirect_close(nsh_redirect_t* redirect)
+{
+    if (redirect->file == NULL) {
+        return NSH_STATUS_OK;
+    }
+    nsh_io_flush(&redirect->io);
+    nsh_status_t status = redirect->backend->close(redirect->file);
+    redirect->file = NULL;
+    return status;
+}
+
+#endif // NSH_FEATURE_USE_REDIRECTION == 1
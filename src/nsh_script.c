@@ -0,0 +1,689 @@
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_SCRIPTS == 1
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_cmd_builtins.h>
+#include <nsh/nsh_script.h>
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Room of an argument replaced by a variable value, "-2147483648" and its null terminator.
+ */
+#define NSH_SCRIPT_INTEGER_SIZE 12u
+
+// Token of the statement being compiled, located in the source to keep the token array small
+typedef struct nsh_script_token {
+    uint16_t offset;
+    uint16_t size;
+} nsh_script_token_t;
+
+typedef enum nsh_script_block_kind {
+    NSH_SCRIPT_BLOCK_IF,
+    NSH_SCRIPT_BLOCK_ELSE,
+    NSH_SCRIPT_BLOCK_WHILE,
+    NSH_SCRIPT_BLOCK_FOR,
+} nsh_script_block_kind_t;
+
+/*
+ * Block being compiled. 'branch' is the jump leaving the block, its target
+ * being set once the end of the block is known. The loops jump back to it.
+ */
+typedef struct nsh_script_block {
+    nsh_script_block_kind_t kind;
+    unsigned int branch;
+    uint8_t variable; ///< Variable incremented by a for loop
+    uint8_t bound;    ///< Variable holding the bound of a for loop
+} nsh_script_block_t;
+
+typedef struct nsh_script_compiler {
+    nsh_script_t* script;
+    const struct nsh_s* nsh;
+    const char* source;
+    nsh_script_block_t blocks[NSH_SCRIPT_MAX_DEPTH];
+    unsigned int depth;
+} nsh_script_compiler_t;
+
+static const struct {
+    const char* symbol;
+    nsh_script_operator_t op;
+} nsh_script_operators[] = {
+    { "+", NSH_SCRIPT_OPERATOR_ADD },
+    { "-", NSH_SCRIPT_OPERATOR_SUB },
+    { "*", NSH_SCRIPT_OPERATOR_MUL },
+    { "/", NSH_SCRIPT_OPERATOR_DIV },
+    { "%", NSH_SCRIPT_OPERATOR_MOD },
+    { "==", NSH_SCRIPT_OPERATOR_EQ },
+    { "!=", NSH_SCRIPT_OPERATOR_NE },
+    { "<", NSH_SCRIPT_OPERATOR_LT },
+    { "<=", NSH_SCRIPT_OPERATOR_LE },
+    { ">", NSH_SCRIPT_OPERATOR_GT },
+    { ">=", NSH_SCRIPT_OPERATOR_GE },
+    // Aliases of the comparisons, the shell taking '<' and '>' for redirections
+    { "-eq", NSH_SCRIPT_OPERATOR_EQ },
+    { "-ne", NSH_SCRIPT_OPERATOR_NE },
+    { "-lt", NSH_SCRIPT_OPERATOR_LT },
+    { "-le", NSH_SCRIPT_OPERATOR_LE },
+    { "-gt", NSH_SCRIPT_OPERATOR_GT },
+    { "-ge", NSH_SCRIPT_OPERATOR_GE },
+};
+
+static inline const char* nsh_script_token_str(const nsh_script_compiler_t* compiler, const nsh_script_token_t* token)
+{
+    return &compiler->source[token->offset];
+}
+
+static bool nsh_script_token_is(const nsh_script_compiler_t* compiler, const nsh_script_token_t* token, const char* str)
+{
+    return token->size == strlen(str) && memcmp(nsh_script_token_str(compiler, token), str, token->size) == 0;
+}
+
+static bool nsh_script_is_name(const char* str, unsigned int size)
+{
+    if (size == 0 || size >= NSH_MAX_STRING_SIZE || !(isalpha((unsigned char)str[0]) || str[0] == '_')) {
+        return false;
+    }
+    for (unsigned int i = 1; i < size; i++) {
+        if (!(isalnum((unsigned char)str[i]) || str[i] == '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int nsh_script_find_variable(const nsh_script_t* script, const char* name, unsigned int size)
+{
+    // The hidden variables have an empty name
+    for (unsigned int i = 0; size > 0 && i < script->variable_count; i++) {
+        if (strlen(script->variable_names[i]) == size && memcmp(script->variable_names[i], name, size) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Find the variable, or declare it. An empty name declares a hidden variable.
+static nsh_status_t nsh_script_declare_variable(nsh_script_t* script, const char* name, unsigned int size,
+    uint8_t* variable)
+{
+    int index = (size > 0) ? nsh_script_find_variable(script, name, size) : -1;
+    if (index < 0) {
+        if (script->variable_count >= NSH_SCRIPT_MAX_VARIABLES) {
+            script->error = "too many variables";
+            return NSH_STATUS_BUFFER_OVERFLOW;
+        }
+        index = (int)script->variable_count++;
+        memcpy(script->variable_names[index], name, size);
+        script->variable_names[index][size] = '\0';
+    }
+    *variable = (uint8_t)index;
+    return NSH_STATUS_OK;
+}
+
+// Parse an integer, "$name" or "$?"
+static nsh_status_t nsh_script_parse_operand(nsh_script_t* script, const char* str, unsigned int size,
+    nsh_script_operand_t* operand)
+{
+    if (size == 2 && memcmp(str, "$?", 2) == 0) {
+        operand->kind = NSH_SCRIPT_OPERAND_VARIABLE;
+        operand->value = NSH_SCRIPT_STATUS_VARIABLE;
+        return NSH_STATUS_OK;
+    }
+    if (size > 0 && str[0] == '$') {
+        int index = nsh_script_find_variable(script, str + 1, size - 1);
+        if (index < 0) {
+            script->error = "unknown variable";
+            return NSH_STATUS_WRONG_ARG;
+        }
+        operand->kind = NSH_SCRIPT_OPERAND_VARIABLE;
+        operand->value = index;
+        return NSH_STATUS_OK;
+    }
+
+    char number[NSH_MAX_STRING_SIZE];
+    if (size == 0 || size >= sizeof(number)) {
+        script->error = "invalid number";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    memcpy(number, str, size);
+    number[size] = '\0';
+    char* end;
+    errno = 0;
+    long value = strtol(number, &end, 0);
+    if (*end != '\0' || errno != 0 || value < INT32_MIN || value > INT32_MAX) {
+        script->error = "invalid number";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    operand->kind = NSH_SCRIPT_OPERAND_INTEGER;
+    operand->value = (int32_t)value;
+    return NSH_STATUS_OK;
+}
+
+// Parse "<operand> [<operator> <operand>]" into the expression of 'instruction'
+static nsh_status_t nsh_script_parse_expression(nsh_script_compiler_t* compiler, const nsh_script_token_t* tokens,
+    unsigned int count, nsh_script_instruction_t* instruction)
+{
+    nsh_script_t* script = compiler->script;
+    if (count != 1 && count != 3) {
+        script->error = "expected an operand, or an operator between two operands";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    nsh_status_t status = nsh_script_parse_operand(script, nsh_script_token_str(compiler, &tokens[0]), tokens[0].size,
+        &instruction->u.expr.lhs);
+    instruction->op = NSH_SCRIPT_OPERATOR_NONE;
+    if (status != NSH_STATUS_OK || count == 1) {
+        return status;
+    }
+    for (unsigned int i = 0; i < sizeof(nsh_script_operators) / sizeof(nsh_script_operators[0]); i++) {
+        if (nsh_script_token_is(compiler, &tokens[1], nsh_script_operators[i].symbol)) {
+            instruction->op = (uint8_t)nsh_script_operators[i].op;
+        }
+    }
+    if (instruction->op == NSH_SCRIPT_OPERATOR_NONE) {
+        script->error = "unknown operator";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    return nsh_script_parse_operand(script, nsh_script_token_str(compiler, &tokens[2]), tokens[2].size,
+        &instruction->u.expr.rhs);
+}
+
+// Append a zeroed instruction, keeping room for the final NSH_SCRIPT_OP_END
+static nsh_script_instruction_t* nsh_script_emit(nsh_script_t* script, nsh_script_opcode_t opcode)
+{
+    if (script->code_size >= NSH_SCRIPT_MAX_INSTRUCTIONS - 1) {
+        script->error = "too many instructions";
+        return NULL;
+    }
+    nsh_script_instruction_t* instruction = &script->code[script->code_size++];
+    memset(instruction, 0, sizeof(*instruction));
+    instruction->opcode = (uint8_t)opcode;
+    return instruction;
+}
+
+static nsh_status_t nsh_script_push_block(nsh_script_compiler_t* compiler, nsh_script_block_kind_t kind,
+    unsigned int branch, uint8_t variable, uint8_t bound)
+{
+    if (compiler->depth >= NSH_SCRIPT_MAX_DEPTH) {
+        compiler->script->error = "too deeply nested";
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+    compiler->blocks[compiler->depth++]
+        = (nsh_script_block_t) { .kind = kind, .branch = branch, .variable = variable, .bound = bound };
+    return NSH_STATUS_OK;
+}
+
+// Compile "if <expr>" and "while <expr>", jumping past the block if the expression is 0
+static nsh_status_t nsh_script_compile_condition(nsh_script_compiler_t* compiler, nsh_script_block_kind_t kind,
+    const nsh_script_token_t* tokens, unsigned int count)
+{
+    nsh_script_t* script = compiler->script;
+    unsigned int branch = script->code_size;
+    nsh_script_instruction_t* instruction = nsh_script_emit(script, NSH_SCRIPT_OP_JUMP_UNLESS);
+    if (instruction == NULL) {
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+    nsh_status_t status = nsh_script_parse_expression(compiler, tokens, count, instruction);
+    if (status != NSH_STATUS_OK) {
+        return status;
+    }
+    return nsh_script_push_block(compiler, kind, branch, 0, 0);
+}
+
+/*
+ * Compile "for <name> in <from>..<to>" into "let <name> <from>; let <hidden> <to>; if $<name> <= $<hidden>",
+ * the end of the loop incrementing the variable and jumping back to its first statement at once.
+ */
+static nsh_status_t nsh_script_compile_for(nsh_script_compiler_t* compiler, const nsh_script_token_t* tokens,
+    unsigned int count)
+{
+    nsh_script_t* script = compiler->script;
+    const char* range = (count == 4) ? nsh_script_token_str(compiler, &tokens[3]) : NULL;
+    const char* dots = NULL;
+    for (unsigned int i = 0; range != NULL && i + 1 < tokens[3].size; i++) {
+        if (range[i] == '.' && range[i + 1] == '.') {
+            dots = &range[i];
+            break;
+        }
+    }
+    if (dots == NULL || !nsh_script_token_is(compiler, &tokens[2], "in")) {
+        script->error = "expected 'for <name> in <from>..<to>'";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    if (!nsh_script_is_name(nsh_script_token_str(compiler, &tokens[1]), tokens[1].size)) {
+        script->error = "invalid variable name";
+        return NSH_STATUS_WRONG_ARG;
+    }
+
+    // Parse the bounds before declaring the variable, which they cannot refer to
+    nsh_script_operand_t from;
+    nsh_script_operand_t to;
+    nsh_status_t status = nsh_script_parse_operand(script, range, (unsigned int)(dots - range), &from);
+    if (status != NSH_STATUS_OK) {
+        return status;
+    }
+    status = nsh_script_parse_operand(script, dots + 2, tokens[3].size - (unsigned int)(dots + 2 - range), &to);
+    if (status != NSH_STATUS_OK) {
+        return status;
+    }
+    uint8_t variable;
+    uint8_t bound;
+    status = nsh_script_declare_variable(script, nsh_script_token_str(compiler, &tokens[1]), tokens[1].size, &variable);
+    if (status != NSH_STATUS_OK) {
+        return status;
+    }
+    status = nsh_script_declare_variable(script, "", 0, &bound);
+    if (status != NSH_STATUS_OK) {
+        return status;
+    }
+
+    nsh_script_instruction_t* instruction = nsh_script_emit(script, NSH_SCRIPT_OP_SET);
+    if (instruction == NULL) {
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+    instruction->variable = variable;
+    instruction->u.expr.lhs = from;
+    instruction = nsh_script_emit(script, NSH_SCRIPT_OP_SET);
+    if (instruction == NULL) {
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+    instruction->variable = bound;
+    instruction->u.expr.lhs = to;
+
+    unsigned int branch = script->code_size;
+    instruction = nsh_script_emit(script, NSH_SCRIPT_OP_JUMP_UNLESS);
+    if (instruction == NULL) {
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+    instruction->op = NSH_SCRIPT_OPERATOR_LE;
+    instruction->u.expr.lhs = (nsh_script_operand_t) { .kind = NSH_SCRIPT_OPERAND_VARIABLE, .value = variable };
+    instruction->u.expr.rhs = (nsh_script_operand_t) { .kind = NSH_SCRIPT_OPERAND_VARIABLE, .value = bound };
+    return nsh_script_push_block(compiler, NSH_SCRIPT_BLOCK_FOR, branch, variable, bound);
+}
+
+static nsh_status_t nsh_script_compile_else(nsh_script_compiler_t* compiler)
+{
+    nsh_script_t* script = compiler->script;
+    nsh_script_block_t* block = (compiler->depth > 0) ? &compiler->blocks[compiler->depth - 1] : NULL;
+    if (block == NULL || block->kind != NSH_SCRIPT_BLOCK_IF) {
+        script->error = "'else' without 'if'";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    unsigned int jump = script->code_size;
+    if (nsh_script_emit(script, NSH_SCRIPT_OP_JUMP) == NULL) {
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+    script->code[block->branch].target = (uint16_t)script->code_size;
+    block->kind = NSH_SCRIPT_BLOCK_ELSE;
+    block->branch = jump;
+    return NSH_STATUS_OK;
+}
+
+static nsh_status_t nsh_script_compile_end(nsh_script_compiler_t* compiler)
+{
+    nsh_script_t* script = compiler->script;
+    if (compiler->depth == 0) {
+        script->error = "'end' without block";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    const nsh_script_block_t* block = &compiler->blocks[--compiler->depth];
+    if (block->kind == NSH_SCRIPT_BLOCK_FOR) {
+        nsh_script_instruction_t* instruction = nsh_script_emit(script, NSH_SCRIPT_OP_NEXT);
+        if (instruction == NULL) {
+            return NSH_STATUS_BUFFER_OVERFLOW;
+        }
+        instruction->variable = block->variable;
+        instruction->u.bound = block->bound;
+        instruction->target = (uint16_t)(block->branch + 1);
+    }
+    if (block->kind == NSH_SCRIPT_BLOCK_WHILE) {
+        nsh_script_instruction_t* instruction = nsh_script_emit(script, NSH_SCRIPT_OP_JUMP);
+        if (instruction == NULL) {
+            return NSH_STATUS_BUFFER_OVERFLOW;
+        }
+        instruction->target = (uint16_t)block->branch;
+    }
+    script->code[block->branch].target = (uint16_t)script->code_size;
+    return NSH_STATUS_OK;
+}
+
+static nsh_status_t nsh_script_compile_let(nsh_script_compiler_t* compiler, const nsh_script_token_t* tokens,
+    unsigned int count)
+{
+    nsh_script_t* script = compiler->script;
+    if (count < 2 || !nsh_script_is_name(nsh_script_token_str(compiler, &tokens[1]), tokens[1].size)) {
+        script->error = "expected 'let <name> <expression>'";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    nsh_script_instruction_t* instruction = nsh_script_emit(script, NSH_SCRIPT_OP_SET);
+    if (instruction == NULL) {
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+    // Parse the expression first, so that it cannot refer to the variable it declares
+    nsh_status_t status = nsh_script_parse_expression(compiler, &tokens[2], count - 2, instruction);
+    if (status != NSH_STATUS_OK) {
+        return status;
+    }
+    return nsh_script_declare_variable(script, nsh_script_token_str(compiler, &tokens[1]), tokens[1].size,
+        &instruction->variable);
+}
+
+// Copy the arguments of the command into the pool, and resolve its handler
+static nsh_status_t nsh_script_compile_call(nsh_script_compiler_t* compiler, const nsh_script_token_t* tokens,
+    unsigned int count)
+{
+    nsh_script_t* script = compiler->script;
+    nsh_script_instruction_t* instruction = nsh_script_emit(script, NSH_SCRIPT_OP_CALL);
+    if (instruction == NULL) {
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+    if (script->arg_count + count > NSH_SCRIPT_MAX_ARGS) {
+        script->error = "too many arguments";
+        return NSH_STATUS_BUFFER_OVERFLOW;
+    }
+    instruction->argc = (uint8_t)count;
+    instruction->target = (uint16_t)script->arg_count;
+
+    for (unsigned int i = 0; i < count; i++) {
+        uint8_t variable = NSH_SCRIPT_NO_VARIABLE;
+        const char* str = nsh_script_token_str(compiler, &tokens[i]);
+        unsigned int size = tokens[i].size + 1;
+        if (i > 0 && str[0] == '$') {
+            nsh_script_operand_t operand;
+            nsh_status_t status = nsh_script_parse_operand(script, str, tokens[i].size, &operand);
+            if (status != NSH_STATUS_OK) {
+                return status;
+            }
+            variable = (uint8_t)operand.value;
+            size = NSH_SCRIPT_INTEGER_SIZE;
+            instruction->has_variable_args = true;
+        }
+        if (script->pool_size + size > sizeof(script->pool)) {
+            script->error = "script too long";
+            return NSH_STATUS_BUFFER_OVERFLOW;
+        }
+        // The slot of a variable is filled with its value at each call, so its name is not kept
+        char* arg = &script->pool[script->pool_size];
+        script->pool_size += size;
+        if (variable == NSH_SCRIPT_NO_VARIABLE) {
+            memcpy(arg, str, tokens[i].size);
+            arg[tokens[i].size] = '\0';
+        } else {
+            arg[0] = '\0';
+        }
+        script->args[script->arg_count] = (uint16_t)(arg - script->pool);
+        script->arg_variables[script->arg_count] = variable;
+        script->arg_count++;
+    }
+
+    const char* name = &script->pool[script->args[instruction->target]];
+    const nsh_cmd_t* cmd = nsh_cmd_array_find(&compiler->nsh->cmds, name);
+    if (cmd != NULL) {
+        instruction->u.handler = cmd->handler;
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+    } else {
+        instruction->u.handler = compiler->nsh->command_not_found_handler;
+#endif
+    }
+    if (instruction->u.handler == NULL) {
+        script->error = "unknown command";
+        return NSH_STATUS_CMD_NOT_FOUND;
+    }
+    if (instruction->u.handler == cmd_builtin_script) {
+        script->error = "a script cannot run scripts";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    return NSH_STATUS_OK;
+}
+
+static nsh_status_t nsh_script_compile_statement(nsh_script_compiler_t* compiler, const nsh_script_token_t* tokens,
+    unsigned int count)
+{
+    if (nsh_script_token_is(compiler, &tokens[0], "let")) {
+        return nsh_script_compile_let(compiler, tokens, count);
+    }
+    if (nsh_script_token_is(compiler, &tokens[0], "if")) {
+        return nsh_script_compile_condition(compiler, NSH_SCRIPT_BLOCK_IF, &tokens[1], count - 1);
+    }
+    if (nsh_script_token_is(compiler, &tokens[0], "while")) {
+        return nsh_script_compile_condition(compiler, NSH_SCRIPT_BLOCK_WHILE, &tokens[1], count - 1);
+    }
+    if (nsh_script_token_is(compiler, &tokens[0], "for")) {
+        return nsh_script_compile_for(compiler, tokens, count);
+    }
+    if (nsh_script_token_is(compiler, &tokens[0], "else") || nsh_script_token_is(compiler, &tokens[0], "end")) {
+        if (count != 1) {
+            compiler->script->error = "unexpected argument";
+            return NSH_STATUS_WRONG_ARG;
+        }
+        return nsh_script_token_is(compiler, &tokens[0], "else") ? nsh_script_compile_else(compiler)
+                                                       : nsh_script_compile_end(compiler);
+    }
+    return nsh_script_compile_call(compiler, tokens, count);
+}
+
+static nsh_status_t nsh_script_compile_statements(nsh_script_compiler_t* compiler, const char* source)
+{
+    nsh_script_t* script = compiler->script;
+    nsh_script_token_t tokens[NSH_SCRIPT_MAX_ARGS];
+    const char* str = source;
+
+    while (*str != '\0') {
+        // Split the statement into tokens separated by blanks
+        unsigned int count = 0;
+        script->error_statement++;
+        while (*str != '\0' && *str != '\n' && *str != ';') {
+            if (*str == ' ' || *str == '\t' || *str == '\r') {
+                str++;
+                continue;
+            }
+            if (count >= NSH_SCRIPT_MAX_ARGS) {
+                script->error = "too many arguments";
+                return NSH_STATUS_BUFFER_OVERFLOW;
+            }
+            const char* begin = str;
+            while (*str != '\0' && *str != '\n' && *str != ';' && *str != ' ' && *str != '\t' && *str != '\r') {
+                str++;
+            }
+            if (str - source > UINT16_MAX) {
+                script->error = "script too long";
+                return NSH_STATUS_BUFFER_OVERFLOW;
+            }
+            tokens[count].offset = (uint16_t)(begin - source);
+            tokens[count].size = (uint16_t)(str - begin);
+            count++;
+        }
+        if (*str != '\0') {
+            str++;
+        }
+
+        if (count > 0) {
+            nsh_status_t status = nsh_script_compile_statement(compiler, tokens, count);
+            if (status != NSH_STATUS_OK) {
+                return status;
+            }
+        }
+    }
+
+    if (compiler->depth > 0) {
+        script->error = "missing 'end'";
+        return NSH_STATUS_WRONG_ARG;
+    }
+    script->code[script->code_size++].opcode = NSH_SCRIPT_OP_END;
+    return NSH_STATUS_OK;
+}
+
+nsh_status_t nsh_script_compile(nsh_script_t* script, const struct nsh_s* nsh, const char* source)
+{
+    script->code_size = 0;
+    script->arg_count = 0;
+    script->pool_size = 0;
+    script->variable_count = 0;
+    script->error_statement = 0;
+    script->error = NULL;
+
+    nsh_script_compiler_t compiler = { .script = script, .nsh = nsh, .source = source, .depth = 0 };
+    nsh_status_t status = nsh_script_compile_statements(&compiler, source);
+    if (status != NSH_STATUS_OK) {
+        // Leave a script doing nothing
+        script->code_size = 0;
+        script->code[0].opcode = NSH_SCRIPT_OP_END;
+    } else {
+        script->error_statement = 0;
+    }
+    return status;
+}
+
+static inline int32_t nsh_script_operand_value(const nsh_script_t* script, const nsh_script_operand_t* operand)
+{
+    return (operand->kind == NSH_SCRIPT_OPERAND_INTEGER) ? operand->value : script->variables[operand->value];
+}
+
+// Evaluate the expression of 'instruction', wrapping around on overflow. Return false on a division by zero.
+static inline bool nsh_script_evaluate(const nsh_script_t* script, const nsh_script_instruction_t* instruction,
+    int32_t* value)
+{
+    int32_t lhs = nsh_script_operand_value(script, &instruction->u.expr.lhs);
+    if (instruction->op == NSH_SCRIPT_OPERATOR_NONE) {
+        *value = lhs;
+        return true;
+    }
+    int32_t rhs = nsh_script_operand_value(script, &instruction->u.expr.rhs);
+
+    switch (instruction->op) {
+    case NSH_SCRIPT_OPERATOR_ADD:
+        *value = (int32_t)((uint32_t)lhs + (uint32_t)rhs);
+        break;
+    case NSH_SCRIPT_OPERATOR_SUB:
+        *value = (int32_t)((uint32_t)lhs - (uint32_t)rhs);
+        break;
+    case NSH_SCRIPT_OPERATOR_MUL:
+        *value = (int32_t)((uint32_t)lhs * (uint32_t)rhs);
+        break;
+    case NSH_SCRIPT_OPERATOR_DIV:
+    case NSH_SCRIPT_OPERATOR_MOD:
+        if (rhs == 0) {
+            return false;
+        }
+        if (rhs == -1) {
+            // INT32_MIN / -1 overflows
+            *value = (instruction->op == NSH_SCRIPT_OPERATOR_DIV) ? (int32_t)(0u - (uint32_t)lhs) : 0;
+        } else {
+            *value = (instruction->op == NSH_SCRIPT_OPERATOR_DIV) ? lhs / rhs : lhs % rhs;
+        }
+        break;
+    case NSH_SCRIPT_OPERATOR_EQ:
+        *value = lhs == rhs;
+        break;
+    case NSH_SCRIPT_OPERATOR_NE:
+        *value = lhs != rhs;
+        break;
+    case NSH_SCRIPT_OPERATOR_LT:
+        *value = lhs < rhs;
+        break;
+    case NSH_SCRIPT_OPERATOR_LE:
+        *value = lhs <= rhs;
+        break;
+    case NSH_SCRIPT_OPERATOR_GT:
+        *value = lhs > rhs;
+        break;
+    default:
+        *value = lhs >= rhs;
+        break;
+    }
+    return true;
+}
+
+static void nsh_script_format_integer(char* str, int32_t value)
+{
+    char digits[NSH_SCRIPT_INTEGER_SIZE];
+    unsigned int count = 0;
+    uint32_t magnitude = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+    do {
+        digits[count++] = (char)('0' + magnitude % 10u);
+        magnitude /= 10u;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *str++ = '-';
+    }
+    while (count > 0) {
+        *str++ = digits[--count];
+    }
+    *str = '\0';
+}
+
+nsh_status_t nsh_script_run(nsh_script_t* script, nsh_cmd_ctx_t* ctx)
+{
+    // The handlers may reorder their argv, not the arguments of the script
+    char* argv[NSH_SCRIPT_MAX_ARGS];
+    nsh_status_t status = NSH_STATUS_OK;
+    int32_t value;
+
+    script->error = NULL;
+    memset(script->variables, 0, sizeof(script->variables));
+    for (unsigned int pc = 0;;) {
+        const nsh_script_instruction_t* instruction = &script->code[pc++];
+        switch (instruction->opcode) {
+        case NSH_SCRIPT_OP_CALL:
+            if (instruction->has_variable_args) {
+                for (unsigned int i = instruction->target; i < instruction->target + instruction->argc; i++) {
+                    uint8_t variable = script->arg_variables[i];
+                    if (variable != NSH_SCRIPT_NO_VARIABLE) {
+                        nsh_script_format_integer(&script->pool[script->args[i]], script->variables[variable]);
+                    }
+                }
+            }
+            for (unsigned int i = 0; i < instruction->argc; i++) {
+                argv[i] = &script->pool[script->args[instruction->target + i]];
+            }
+            status = instruction->u.handler(ctx, instruction->argc, argv);
+            script->variables[NSH_SCRIPT_STATUS_VARIABLE] = (int32_t)status;
+            if (status == NSH_STATUS_QUIT || status == NSH_STATUS_CANCELLED) {
+                return status;
+            }
+            break;
+        case NSH_SCRIPT_OP_SET:
+            if (!nsh_script_evaluate(script, instruction, &value)) {
+                script->error = "division by zero";
+                return NSH_STATUS_WRONG_ARG;
+            }
+            script->variables[instruction->variable] = value;
+            break;
+        case NSH_SCRIPT_OP_JUMP:
+            // Let the loops be cancelled, even when they call no command
+            if (instruction->target < pc && nsh_cmd_is_cancelled(ctx)) {
+                return NSH_STATUS_CANCELLED;
+            }
+            pc = instruction->target;
+            break;
+        case NSH_SCRIPT_OP_NEXT:
+            // The variable stops at the bound, which cannot overflow
+            if (script->variables[instruction->variable] < script->variables[instruction->u.bound]) {
+                if (nsh_cmd_is_cancelled(ctx)) {
+                    return NSH_STATUS_CANCELLED;
+                }
+                script->variables[instruction->variable]++;
+                pc = instruction->target;
+            }
+            break;
+        case NSH_SCRIPT_OP_JUMP_UNLESS:
+            if (!nsh_script_evaluate(script, instruction, &value)) {
+                script->error = "division by zero";
+                return NSH_STATUS_WRONG_ARG;
+            }
+            if (value == 0) {
+                pc = instruction->target;
+            }
+            break;
+        default:
+            return status;
+        }
+    }
+}
+
+#endif // NSH_FEATURE_USE_SCRIPTS == 1
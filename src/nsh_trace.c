@@ -0,0 +1,80 @@
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_TRACE == 1
+
+#include <nsh/nsh_trace.h>
+
+#include <stddef.h>
+
+void nsh_trace_start(nsh_trace_t* trace, nsh_trace_clock_t* clock, uint32_t frequency_hz)
+{
+    nsh_trace_stop(trace);
+    trace->head = 0;
+    trace->frequency_hz = frequency_hz;
+    NSH_ATOMIC_STORE(&trace->clock, clock);
+}
+
+void nsh_trace_stop(nsh_trace_t* trace)
+{
+    NSH_ATOMIC_STORE(&trace->clock, NULL);
+}
+
+uint32_t nsh_trace_now(const nsh_trace_t* trace)
+{
+    nsh_trace_clock_t* clock = (trace != NULL) ? NSH_ATOMIC_LOAD(&trace->clock) : NULL;
+    return (clock != NULL) ? clock() : 0;
+}
+
+void nsh_trace_push(nsh_trace_t* trace, const void* instance, nsh_trace_phase_t phase, uint32_t start)
+{
+    nsh_trace_clock_t* clock = (trace != NULL) ? NSH_ATOMIC_LOAD(&trace->clock) : NULL;
+    if (clock == NULL) {
+        return;
+    }
+    uint32_t end = clock();
+    unsigned int index = NSH_ATOMIC_FETCH_ADD(&trace->head, 1u);
+    nsh_trace_record_t* record = &trace->ring[index & (NSH_TRACE_RING_SIZE - 1u)];
+    record->instance = instance;
+    record->start = start;
+    record->duration = end - start;
+    record->phase = (uint8_t)phase;
+}
+
+unsigned int nsh_trace_count(const nsh_trace_t* trace)
+{
+    unsigned int head = NSH_ATOMIC_LOAD(&trace->head);
+    return (head < NSH_TRACE_RING_SIZE) ? head : NSH_TRACE_RING_SIZE;
+}
+
+unsigned int nsh_trace_overwritten_count(const nsh_trace_t* trace)
+{
+    return NSH_ATOMIC_LOAD(&trace->head) - nsh_trace_count(trace);
+}
+
+const nsh_trace_record_t* nsh_trace_get(const nsh_trace_t* trace, unsigned int index)
+{
+    unsigned int oldest = NSH_ATOMIC_LOAD(&trace->head) - nsh_trace_count(trace);
+    return &trace->ring[(oldest + index) & (NSH_TRACE_RING_SIZE - 1u)];
+}
+
+uint32_t nsh_trace_frequency(const nsh_trace_t* trace)
+{
+    return trace->frequency_hz;
+}
+
+const char* nsh_trace_phase_name(nsh_trace_phase_t phase)
+{
+    static const char* const names[NSH_TRACE_PHASE_COUNT] = {
+        [NSH_TRACE_PHASE_READ] = "read",
+        [NSH_TRACE_PHASE_ECHO] = "echo",
+        [NSH_TRACE_PHASE_SPLIT] = "split",
+        [NSH_TRACE_PHASE_LOOKUP] = "lookup",
+        [NSH_TRACE_PHASE_HANDLER] = "handler",
+        [NSH_TRACE_PHASE_FLUSH] = "flush",
+    };
+    return ((unsigned int)phase < NSH_TRACE_PHASE_COUNT) ? names[phase] : "unknown";
+}
+
+#endif // NSH_FEATURE_USE_TRACE == 1
@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 200809L // nanosleep
+
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_JOBS == 1
+
+#include <nsh/nsh_executor_posix.h>
+
+#include <time.h>
+
+static void* nsh_posix_executor_worker(void* arg)
+{
+    nsh_posix_executor_t* pool = (nsh_posix_executor_t*)arg;
+
+    pthread_mutex_lock(&pool->queue_mutex);
+    while (true) {
+        while (pool->queue_count == 0 && !pool->stopping) {
+            pthread_cond_wait(&pool->queue_not_empty, &pool->queue_mutex);
+        }
+        if (pool->queue_count == 0) {
+            break; // Stopping, and no task left
+        }
+        void (*task)(void*) = pool->queue[pool->queue_head].task;
+        void* task_arg = pool->queue[pool->queue_head].arg;
+        pool->queue_head = (pool->queue_head + 1u) % NSH_JOB_MAX_COUNT;
+        pool->queue_count--;
+
+        pthread_mutex_unlock(&pool->queue_mutex);
+        task(task_arg);
+        pthread_mutex_lock(&pool->queue_mutex);
+    }
+    pthread_mutex_unlock(&pool->queue_mutex);
+
+    return NULL;
+}
+
+static nsh_status_t nsh_posix_executor_submit(void* ctx, void (*task)(void* arg), void* arg)
+{
+    nsh_posix_executor_t* pool = (nsh_posix_executor_t*)ctx;
+    nsh_status_t status = NSH_STATUS_OK;
+
+    pthread_mutex_lock(&pool->queue_mutex);
+    if (pool->queue_count == NSH_JOB_MAX_COUNT || pool->stopping) {
+        status = NSH_STATUS_FAILURE;
+    } else {
+        unsigned int tail = (pool->queue_head + pool->queue_count) % NSH_JOB_MAX_COUNT;
+        pool->queue[tail].task = task;
+        pool->queue[tail].arg = arg;
+        pool->queue_count++;
+        pthread_cond_signal(&pool->queue_not_empty);
+    }
+    pthread_mutex_unlock(&pool->queue_mutex);
+
+    return status;
+}
+
+static void nsh_posix_executor_lock(void* ctx)
+{
+    pthread_mutex_lock(&((nsh_posix_executor_t*)ctx)->jobs_mutex);
+}
+
+static void nsh_posix_executor_unlock(void* ctx)
+{
+    pthread_mutex_unlock(&((nsh_posix_executor_t*)ctx)->jobs_mutex);
+}
+
+static void nsh_posix_executor_yield(void* ctx)
+{
+    NSH_UNUSED(ctx);
+    struct timespec delay = { .tv_sec = 0, .tv_nsec = 1000000 };
+    nanosleep(&delay, NULL);
+}
+
+nsh_status_t nsh_posix_executor_init(nsh_posix_executor_t* pool)
+{
+    pool->executor.submit = nsh_posix_executor_submit;
+    pool->executor.lock = nsh_posix_executor_lock;
+    pool->executor.unlock = nsh_posix_executor_unlock;
+    pool->executor.yield = nsh_posix_executor_yield;
+    pool->executor.poll = NULL;
+    pool->executor.ctx = pool;
+    pool->worker_count = 0;
+    pool->queue_head = 0;
+    pool->queue_count = 0;
+    pool->stopping = false;
+
+    pthread_mutex_init(&pool->queue_mutex, NULL);
+    pthread_cond_init(&pool->queue_not_empty, NULL);
+    pthread_mutex_init(&pool->jobs_mutex, NULL);
+
+    for (unsigned int i = 0; i < NSH_JOB_MAX_COUNT; i++) {
+        if (pthread_create(&pool->workers[i], NULL, nsh_posix_executor_worker, pool) != 0) {
+            nsh_posix_executor_destroy(pool);
+            return NSH_STATUS_FAILURE;
+        }
+        pool->worker_count++;
+    }
+
+    return NSH_STATUS_OK;
+}
+
+void nsh_posix_executor_destroy(nsh_posix_executor_t* pool)
+{
+    pthread_mutex_lock(&pool->queue_mutex);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->queue_not_empty);
+    pthread_mutex_unlock(&pool->queue_mutex);
+
+    for (unsigned int i = 0; i < pool->worker_count; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    pool->worker_count = 0;
+
+    pthread_mutex_destroy(&pool->jobs_mutex);
+    pthread_cond_destroy(&pool->queue_not_empty);
+    pthread_mutex_destroy(&pool->queue_mutex);
+}
+
+#endif // NSH_FEATURE_USE_JOBS == 1
@@ -0,0 +1,62 @@
+#define _POSIX_C_SOURCE 200809L // sigaction, clock_gettime
+
+#include <nsh/nsh_interrupt_posix.h>
+
+#include <signal.h>
+#include <stddef.h>
+#include <time.h>
+
+static nsh_t* volatile nsh_posix_interrupted_shell = NULL;
+static struct sigaction nsh_posix_previous_sigint;
+
+/*
+ * Only sets the cancel token of the shell, which is async-signal-safe.
+ */
+static void nsh_posix_sigint_handler(int signal_number)
+{
+    NSH_UNUSED(signal_number);
+    nsh_t* nsh = nsh_posix_interrupted_shell;
+    if (nsh != NULL) {
+        nsh_interrupt(nsh);
+    }
+}
+
+unsigned int nsh_posix_clock_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned int)now.tv_sec * 1000u + (unsigned int)(now.tv_nsec / 1000000);
+}
+
+#if NSH_FEATURE_USE_CMD_STATS == 1 || NSH_FEATURE_USE_TRACE == 1
+uint32_t nsh_posix_clock_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec * 1000000u + (uint32_t)(now.tv_nsec / 1000);
+}
+#endif
+
+nsh_status_t nsh_posix_interrupt_install(nsh_t* nsh)
+{
+    struct sigaction action;
+    action.sa_handler = nsh_posix_sigint_handler;
+    sigemptyset(&action.sa_mask);
+    // Reading the input resumes after the signal, Ctrl-C only interrupts the command
+    action.sa_flags = SA_RESTART;
+
+    nsh_posix_interrupted_shell = nsh;
+    if (sigaction(SIGINT, &action, &nsh_posix_previous_sigint) != 0) {
+        nsh_posix_interrupted_shell = NULL;
+        return NSH_STATUS_FAILURE;
+    }
+    return NSH_STATUS_OK;
+}
+
+void nsh_posix_interrupt_uninstall(void)
+{
+    if (nsh_posix_interrupted_shell != NULL) {
+        sigaction(SIGINT, &nsh_posix_previous_sigint, NULL);
+        nsh_posix_interrupted_shell = NULL;
+    }
+}
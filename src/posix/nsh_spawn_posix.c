@@ -0,0 +1,214 @@
+#define _GNU_SOURCE // pipe2, posix_spawn, kill
+
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+
+#include <nsh/nsh_spawn_posix.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+extern char** environ;
+
+/*
+ * Period at which the cancellation of the command is polled while the program
+ * does not write anything.
+ */
+#define NSH_SPAWN_POLL_PERIOD_MS 10
+
+/*
+ * Delay given to a cancelled program to exit after SIGTERM, before it is
+ * killed with SIGKILL.
+ */
+#define NSH_SPAWN_TERMINATE_GRACE_MS 200
+
+/*
+ * Write the output of the program, translating the line endings for a terminal
+ * in raw mode.
+ */
+static void nsh_spawn_put_output(nsh_io_t* io, const char* output, size_t size)
+{
+    const char* end = output + size;
+    while (output < end) {
+        const char* newline = memchr(output, '\n', (size_t)(end - output));
+        if (newline == NULL) {
+            nsh_io_put_buffer(io, output, (unsigned int)(end - output));
+            return;
+        }
+        nsh_io_put_buffer(io, output, (unsigned int)(newline - output));
+        nsh_io_put_newline(io);
+        output = newline + 1;
+    }
+}
+
+/*
+ * Create the pipe of the output of the program, kept out of the programs
+ * launched concurrently by the background jobs.
+ */
+static int nsh_spawn_open_pipe(int pipe_fds[2])
+{
+#if defined(__APPLE__)
+    // No pipe2() there, a program launched between the two calls may still inherit the pipe
+    if (pipe(pipe_fds) != 0) {
+        return -1;
+    }
+    fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#else
+    return pipe2(pipe_fds, O_CLOEXEC);
+#endif
+}
+
+/*
+ * Wait for the end of the program, without blocking if 'timeout_ms' is not
+ * negative. Return the pid on success, 0 on timeout, and -1 on error.
+ */
+static pid_t nsh_spawn_wait(pid_t pid, int* wait_status, int timeout_ms)
+{
+    for (;;) {
+        pid_t result = waitpid(pid, wait_status, (timeout_ms < 0) ? 0 : WNOHANG);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result != 0 || timeout_ms <= 0) {
+            return result;
+        }
+        const struct timespec period = { .tv_sec = 0, .tv_nsec = NSH_SPAWN_POLL_PERIOD_MS * 1000000L };
+        nanosleep(&period, NULL);
+        timeout_ms -= NSH_SPAWN_POLL_PERIOD_MS;
+    }
+}
+
+/*
+ * Terminate a cancelled program, killing it if it is still running after the
+ * grace period.
+ */
+static void nsh_spawn_terminate(pid_t pid)
+{
+    int wait_status;
+    kill(pid, SIGTERM);
+    if (nsh_spawn_wait(pid, &wait_status, NSH_SPAWN_TERMINATE_GRACE_MS) == 0) {
+        kill(pid, SIGKILL);
+        nsh_spawn_wait(pid, &wait_status, -1);
+    }
+}
+
+/*
+ * Launch the program with its standard output and error redirected to the
+ * write end of 'pipe_fds'.
+ */
+static int nsh_spawn_program(pid_t* pid, char** spawn_argv, const int pipe_fds[2])
+{
+    posix_spawn_file_actions_t actions;
+    int error = posix_spawn_file_actions_init(&actions);
+    if (error != 0) {
+        return error;
+    }
+    error = posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    if (error == 0) {
+        error = posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+    }
+    if (error == 0) {
+        error = posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDERR_FILENO);
+    }
+    if (error == 0) {
+        error = posix_spawn_file_actions_addclose(&actions, pipe_fds[0]);
+    }
+    if (error == 0) {
+        error = posix_spawn_file_actions_addclose(&actions, pipe_fds[1]);
+    }
+    if (error == 0) {
+        error = posix_spawnp(pid, spawn_argv[0], &actions, NULL, spawn_argv, environ);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    return error;
+}
+
+nsh_status_t nsh_posix_spawn_command(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    // The tokenizer does not terminate argv with a null pointer
+    char* spawn_argv[NSH_CMD_ARGS_MAX_COUNT + 1];
+    if (argc == 0) {
+        return NSH_STATUS_WRONG_ARG;
+    }
+    if (argc > NSH_CMD_ARGS_MAX_COUNT) {
+        return NSH_STATUS_MAX_ARGS_NB_REACH;
+    }
+    memcpy(spawn_argv, argv, argc * sizeof(char*));
+    spawn_argv[argc] = NULL;
+
+    int pipe_fds[2];
+    if (nsh_spawn_open_pipe(pipe_fds) != 0) {
+        return NSH_STATUS_FAILURE;
+    }
+
+    pid_t pid;
+    int error = nsh_spawn_program(&pid, spawn_argv, pipe_fds);
+    close(pipe_fds[1]);
+    if (error != 0) {
+        close(pipe_fds[0]);
+        return (error == ENOENT) ? NSH_STATUS_CMD_NOT_FOUND : NSH_STATUS_FAILURE;
+    }
+
+    // Stream the output until the program closes it, or until the command is cancelled
+    bool cancelled = false;
+    char output[256];
+    struct pollfd poll_fd = { .fd = pipe_fds[0], .events = POLLIN, .revents = 0 };
+    for (;;) {
+        if (nsh_cmd_is_cancelled(ctx)) {
+            cancelled = true;
+            break;
+        }
+        int ready = poll(&poll_fd, 1, NSH_SPAWN_POLL_PERIOD_MS);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        ssize_t size = read(pipe_fds[0], output, sizeof(output));
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            break;
+        }
+        nsh_spawn_put_output(ctx->io, output, (size_t)size);
+        nsh_io_flush(ctx->io);
+    }
+    close(pipe_fds[0]);
+
+    // The program may still run after closing its output
+    int wait_status;
+    while (!cancelled) {
+        pid_t result = nsh_spawn_wait(pid, &wait_status, NSH_SPAWN_POLL_PERIOD_MS);
+        if (result < 0) {
+            return NSH_STATUS_FAILURE;
+        }
+        if (result > 0) {
+            break;
+        }
+        cancelled = nsh_cmd_is_cancelled(ctx);
+    }
+    if (cancelled) {
+        nsh_spawn_terminate(pid);
+        return NSH_STATUS_CANCELLED;
+    }
+    if (WIFEXITED(wait_status) && WEXITSTATUS(wait_status) == 0) {
+        return NSH_STATUS_OK;
+    }
+    return NSH_STATUS_FAILURE;
+}
+
+#endif // NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
@@ -0,0 +1,95 @@
+#define _POSIX_C_SOURCE 200809L // getpid
+
+#include <nsh/nsh_config.h>
+
+#include <nsh/nsh_common_defs.h>
+
+#if NSH_FEATURE_USE_TRACE == 1
+
+#include <nsh/nsh_trace_chrome.h>
+
+#include <inttypes.h>
+#include <unistd.h>
+
+/*
+ * Convert trace clock ticks into nanoseconds, the clock ticking every
+ * microsecond if its frequency is unknown.
+ */
+static uint64_t nsh_trace_ticks_to_ns(const nsh_trace_t* trace, uint32_t ticks)
+{
+    uint32_t frequency_hz = nsh_trace_frequency(trace);
+    if (frequency_hz == 0) {
+        return (uint64_t)ticks * 1000u;
+    }
+    return (uint64_t)ticks * 1000000000u / frequency_hz;
+}
+
+/*
+ * Identify the instance which made the record at 'index' by its first record,
+ * to write it as a thread of the process.
+ */
+static unsigned int nsh_trace_instance_id(const nsh_trace_t* trace, unsigned int index)
+{
+    const void* instance = nsh_trace_get(trace, index)->instance;
+    unsigned int first = 0;
+    while (nsh_trace_get(trace, first)->instance != instance) {
+        first++;
+    }
+    return first + 1u;
+}
+
+/*
+ * Earliest start of the records. Records are pushed when their phase ends, so
+ * an enclosing phase may start before the oldest record. The clock wrapping
+ * around, starts are compared by their signed difference.
+ */
+static uint32_t nsh_trace_origin(const nsh_trace_t* trace, unsigned int count)
+{
+    uint32_t origin = (count > 0) ? nsh_trace_get(trace, 0)->start : 0;
+    for (unsigned int i = 1; i < count; i++) {
+        uint32_t start = nsh_trace_get(trace, i)->start;
+        if ((int32_t)(start - origin) < 0) {
+            origin = start;
+        }
+    }
+    return origin;
+}
+
+nsh_status_t nsh_trace_export_chrome(const nsh_trace_t* trace, FILE* file)
+{
+    unsigned int count = nsh_trace_count(trace);
+    uint32_t origin = nsh_trace_origin(trace, count);
+    long pid = (long)getpid();
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+    for (unsigned int i = 0; i < count; i++) {
+        const nsh_trace_record_t* record = nsh_trace_get(trace, i);
+        // Timestamps in microseconds, with a nanosecond resolution
+        uint64_t ts_ns = nsh_trace_ticks_to_ns(trace, record->start - origin);
+        uint64_t dur_ns = nsh_trace_ticks_to_ns(trace, record->duration);
+        fprintf(file,
+            "%s\n{\"name\":\"%s\",\"cat\":\"nsh\",\"ph\":\"X\",\"ts\":%" PRIu64 ".%03u,\"dur\":%" PRIu64
+            ".%03u,\"pid\":%ld,\"tid\":%u}",
+            (i == 0) ? "" : ",", nsh_trace_phase_name((nsh_trace_phase_t)record->phase), ts_ns / 1000u,
+            (unsigned int)(ts_ns % 1000u), dur_ns / 1000u, (unsigned int)(dur_ns % 1000u), pid,
+            nsh_trace_instance_id(trace, i));
+    }
+    fprintf(file, "\n],\"otherData\":{\"overwritten\":%u}}\n", nsh_trace_overwritten_count(trace));
+
+    return (ferror(file) != 0) ? NSH_STATUS_FAILURE : NSH_STATUS_OK;
+}
+
+nsh_status_t nsh_trace_export_chrome_to_path(const nsh_trace_t* trace, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return NSH_STATUS_FAILURE;
+    }
+    nsh_status_t status = nsh_trace_export_chrome(trace, file);
+    if (fclose(file) != 0) {
+        status = NSH_STATUS_FAILURE;
+    }
+    return status;
+}
+
+#endif // NSH_FEATURE_USE_TRACE == 1
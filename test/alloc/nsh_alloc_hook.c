@@ -0,0 +1,63 @@
+#include "nsh_alloc_hook.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/*
+ * Implementation of the allocator of the GNU C library, which it calls itself
+ * once malloc and friends are replaced by the executable.
+ */
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+static _Thread_local bool nsh_alloc_hook_counting;
+static _Thread_local unsigned int nsh_alloc_hook_counter;
+
+void nsh_alloc_hook_start(void)
+{
+    nsh_alloc_hook_counter = 0;
+    nsh_alloc_hook_counting = true;
+}
+
+unsigned int nsh_alloc_hook_stop(void)
+{
+    nsh_alloc_hook_counting = false;
+    return nsh_alloc_hook_counter;
+}
+
+unsigned int nsh_alloc_hook_count(void)
+{
+    return nsh_alloc_hook_counter;
+}
+
+void* malloc(size_t size)
+{
+    if (nsh_alloc_hook_counting) {
+        nsh_alloc_hook_counter++;
+    }
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    if (nsh_alloc_hook_counting) {
+        nsh_alloc_hook_counter++;
+    }
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    if (nsh_alloc_hook_counting) {
+        nsh_alloc_hook_counter++;
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    __libc_free(ptr);
+}
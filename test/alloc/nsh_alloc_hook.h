@@ -0,0 +1,33 @@
+#ifndef NSH_ALLOC_HOOK_H_
+#define NSH_ALLOC_HOOK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Count the heap allocations (malloc, calloc, realloc) of the calling thread,
+ * including the ones made by the C library itself. The allocation functions of
+ * the C library are replaced by functions forwarding to its implementation.
+ */
+
+/**
+ * @brief Start counting the allocations of the calling thread, from 0.
+ */
+void nsh_alloc_hook_start(void);
+
+/**
+ * @brief Stop counting, returning the number of allocations since nsh_alloc_hook_start().
+ */
+unsigned int nsh_alloc_hook_stop(void);
+
+/**
+ * @brief Number of allocations of the calling thread since nsh_alloc_hook_start().
+ */
+unsigned int nsh_alloc_hook_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NSH_ALLOC_HOOK_H_
@@ -0,0 +1,187 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_io_memory.h>
+
+#include "nsh_alloc_hook.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+/*
+ * Allocations made by each command of a shell, counted by replacing the
+ * handlers of all its commands with a handler forwarding to the original one.
+ * The table is static since a handler has no user data to find it.
+ */
+struct CommandAllocations {
+    const char* name;
+    nsh_cmd_handler_t* handler;
+    unsigned int allocations;
+};
+
+CommandAllocations command_allocations[NSH_CMD_MAX_COUNT];
+unsigned int command_count;
+
+nsh_status_t cmd_counting(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    for (unsigned int i = 0; i < command_count; i++) {
+        if (std::strcmp(command_allocations[i].name, argv[0]) == 0) {
+            unsigned int before = nsh_alloc_hook_count();
+            nsh_status_t status = command_allocations[i].handler(ctx, argc, argv);
+            command_allocations[i].allocations += nsh_alloc_hook_count() - before;
+            return status;
+        }
+    }
+    return NSH_STATUS_CMD_NOT_FOUND;
+}
+
+void count_command_allocations(nsh_t& nsh)
+{
+    command_count = nsh.cmds.count;
+    for (unsigned int i = 0; i < command_count; i++) {
+        command_allocations[i] = { nsh.cmds.array[i].name, nsh.cmds.array[i].handler, 0 };
+        nsh.cmds.array[i].handler = cmd_counting;
+    }
+}
+
+// Print the allocations of each command, then the ones made by the shell itself
+unsigned int report_allocations(unsigned int total)
+{
+    unsigned int in_commands = 0;
+    std::printf("%-16s %11s\n", "command", "allocations");
+    for (unsigned int i = 0; i < command_count; i++) {
+        std::printf("%-16s %11u\n", command_allocations[i].name, command_allocations[i].allocations);
+        in_commands += command_allocations[i].allocations;
+    }
+    std::printf("%-16s %11u\n", "(shell)", total - in_commands);
+    return total - in_commands;
+}
+
+// User command formatting its output, without allocating
+nsh_status_t cmd_print(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+#if NSH_FEATURE_USE_PRINTF == 1
+    nsh_io_printf(ctx->io, "%s: %u args, %d (0x%08x) %5.2f", argv[0], argc, -42, 42u, 3.14);
+#endif
+    for (unsigned int i = 1; i < argc; i++) {
+        nsh_io_put_string(ctx->io, argv[i]);
+    }
+    return NSH_STATUS_OK;
+}
+
+// User command allocating on the heap
+nsh_status_t cmd_alloc(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    std::vector<std::string> words(4, std::string(64, 'x'));
+    nsh_io_put_unsigned(ctx->io, static_cast<unsigned int>(words.size()));
+    return NSH_STATUS_OK;
+}
+
+// Keystrokes going through every library code path which does not need a platform service
+const std::string script = "help\n"
+                           "version\n"
+                           "print a b c\n"
+                           "hel\b\b\blp\n"
+                           "ver\t\n"
+                           "\x1b[A\x1b[A\x1b[B\n"
+                           "pri\x1b[A\n"
+                           "\x12vers\x12\n"
+                           "\x12xyz\x07\n"
+                           "unknown command\n"
+                           "hel\x03"
+                           "\x1b[C\n"
+                           "a b c d e f g h i j k l m n o p q r s t u v w x y z 0 1 2 3 4 5 6 7 8 9\n"
+                           "ThisIsAVeryLongArgument\n"
+                           "Writing the first 90 percent of a computer program takes 90 percent of the time. "
+                           "The remaining ten percent also takes 90 percent of the time.\n"
+#if NSH_FEATURE_USE_JOBS == 1
+                           "print &\n"
+                           "jobs\n"
+#endif
+#if NSH_FEATURE_USE_CMD_STATS == 1
+                           "stats\n"
+#endif
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+                           "mem\n"
+#endif
+#if NSH_FEATURE_USE_PIPES == 1
+                           "print a b c | grep b | wc\n"
+                           "help | hex\n"
+                           "print a b c | head -n 1\n"
+#endif
+#if NSH_FEATURE_USE_SCRIPTS == 1
+                           "script for i in 1..3; print $i; end\n"
+                           "script\n"
+#endif
+                           "exit\n";
+
+class NshNoAlloc : public testing::Test {
+protected:
+    unsigned int run(const std::string& input)
+    {
+        static nsh_t nsh;
+        nsh_alloc_hook_start();
+        nsh_init_inplace(&nsh);
+        nsh_register_command(&nsh, "print", cmd_print);
+        nsh_register_command(&nsh, "alloc", cmd_alloc);
+        count_command_allocations(nsh);
+        nsh_io_memory_init(&mem, input.data(), static_cast<unsigned int>(input.size()), output, sizeof(output));
+        nsh_set_io(&nsh, &nsh_io_memory_backend, &mem);
+        nsh_run(&nsh);
+        return nsh_alloc_hook_stop();
+    }
+
+    unsigned int allocations_of(const char* name)
+    {
+        for (unsigned int i = 0; i < command_count; i++) {
+            if (std::strcmp(command_allocations[i].name, name) == 0) {
+                return command_allocations[i].allocations;
+            }
+        }
+        return 0;
+    }
+
+    char output[64 * 1024];
+    nsh_io_memory_t mem;
+};
+
+} // namespace
+
+TEST(NshAllocHook, SuccessCountAllocations)
+{
+    nsh_alloc_hook_start();
+    void* volatile ptr = std::malloc(16);
+    ptr = std::realloc(ptr, 32);
+    std::free(ptr);
+    ptr = std::calloc(4, 4);
+    std::free(ptr);
+    // Stored into a volatile pointer so that the optimizer cannot elide the allocation
+    int* volatile object = new int(42);
+    delete object;
+
+    ASSERT_EQ(nsh_alloc_hook_stop(), 4u);
+}
+
+TEST_F(NshNoAlloc, SuccessLibraryPathsAllocationFree)
+{
+    unsigned int total = run(script);
+
+    ASSERT_EQ(report_allocations(total), 0u) << "the shell allocated outside of the commands";
+    ASSERT_EQ(total, 0u) << "the builtins or nsh_io_printf allocated";
+}
+
+TEST_F(NshNoAlloc, SuccessReportHandlerAllocations)
+{
+    unsigned int total = run("print x\nalloc\nalloc\nexit\n");
+
+    ASSERT_EQ(report_allocations(total), 0u);
+    ASSERT_EQ(allocations_of("print"), 0u);
+    ASSERT_GE(allocations_of("alloc"), 2u * 5u);
+    ASSERT_EQ(allocations_of("alloc"), total);
+}
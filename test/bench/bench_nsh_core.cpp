@@ -0,0 +1,213 @@
+/*
+ * Microbenchmarks of the hot paths of Nsh: command line splitting, command
+ * lookup, autocompletion, history, the processing of whole lines through
+ * the memory I/O backend, and the loops of compiled scripts.
+ *
+ * Built once per configuration of the library, run the nsh-bench target to
+ * write the results of each one as JSON.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_io_memory.h>
+
+#include "nsh_internal.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+nsh_status_t cmd_nop(nsh_cmd_ctx_t*, unsigned int, char**)
+{
+    return NSH_STATUS_OK;
+}
+
+// Names of distinct commands sharing a common prefix, as in a real command set
+std::string command_name(unsigned int index)
+{
+    return "cmd" + std::to_string(index);
+}
+
+// Shell with its command table filled, writing its output nowhere
+struct BenchShell {
+    nsh_io_memory_t mem;
+    nsh_t nsh;
+
+    BenchShell(const BenchShell&) = delete;
+    BenchShell& operator=(const BenchShell&) = delete;
+
+    BenchShell()
+    {
+        nsh_init_inplace(&nsh);
+        for (unsigned int i = nsh.cmds.count; i < NSH_CMD_MAX_COUNT; i++) {
+            nsh_register_command(&nsh, command_name(i).c_str(), cmd_nop);
+        }
+        feed("");
+    }
+
+    void feed(const std::string& input)
+    {
+        nsh_io_memory_init(&mem, input.data(), static_cast<unsigned int>(input.size()), nullptr, 0);
+        nsh_set_io(&nsh, &nsh_io_memory_backend, &mem);
+    }
+};
+
+// Command line calling the last registered command
+std::string make_command_line(unsigned int token_count)
+{
+    std::string line = command_name(NSH_CMD_MAX_COUNT - 1);
+    for (unsigned int i = 1; i < token_count; i++) {
+        line += " arg" + std::to_string(i);
+    }
+    return line;
+}
+
+void BM_SplitCommandLine(benchmark::State& state)
+{
+    auto token_count = static_cast<unsigned int>(state.range(0));
+    std::string line = make_command_line(token_count);
+    static char tokens[NSH_CMD_ARGS_MAX_COUNT][NSH_MAX_STRING_SIZE];
+
+    for (auto _ : state) {
+        unsigned int count = 0;
+        nsh_status_t status = nsh_split_command_line(line.c_str(), ' ', tokens, &count, NSH_CMD_ARGS_MAX_COUNT);
+        benchmark::DoNotOptimize(status);
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(line.size()));
+}
+BENCHMARK(BM_SplitCommandLine)->Arg(1)->Arg(4)->Arg(NSH_CMD_ARGS_MAX_COUNT - 1);
+
+// Find the first, the middle or the last registered command, or a missing one
+void BM_CmdArrayFind(benchmark::State& state)
+{
+    BenchShell shell;
+    auto position = static_cast<unsigned int>(state.range(0));
+    std::string name = (position < shell.nsh.cmds.count) ? shell.nsh.cmds.array[position].name : "missing";
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nsh_cmd_array_find(&shell.nsh.cmds, name.c_str()));
+    }
+}
+BENCHMARK(BM_CmdArrayFind)->Arg(0)->Arg(NSH_CMD_MAX_COUNT / 2)->Arg(NSH_CMD_MAX_COUNT - 1)->Arg(NSH_CMD_MAX_COUNT);
+
+#if NSH_FEATURE_USE_AUTOCOMPLETION == 1
+// Complete a prefix matching all the registered commands but the builtins, or a single one
+void BM_Autocomplete(benchmark::State& state)
+{
+    BenchShell shell;
+    std::string prefix = (state.range(0) == 0) ? "cmd" : command_name(NSH_CMD_MAX_COUNT - 1);
+    for (char c : prefix) {
+        nsh_line_buffer_append_char(&shell.nsh.line, c);
+    }
+
+    for (auto _ : state) {
+        shell.mem.output_size = 0;
+        nsh_autocomplete(&shell.nsh);
+        nsh_io_flush(&shell.nsh.io);
+    }
+}
+BENCHMARK(BM_Autocomplete)->Arg(0)->Arg(1);
+#endif
+
+#if NSH_FEATURE_USE_HISTORY == 1
+void BM_HistoryAdd(benchmark::State& state)
+{
+    static nsh_history_t history;
+    nsh_history_reset(&history);
+    std::vector<std::string> entries;
+    for (unsigned int i = 0; i < 64; i++) {
+        entries.push_back(make_command_line(i % 8 + 1));
+    }
+
+    std::size_t next = 0;
+    for (auto _ : state) {
+        nsh_history_add_entry(&history, entries[next].c_str());
+        next = (next + 1) % entries.size();
+    }
+}
+BENCHMARK(BM_HistoryAdd);
+
+// Get the entry of the given age from a full history
+void BM_HistoryGet(benchmark::State& state)
+{
+    static nsh_history_t history;
+    nsh_history_reset(&history);
+    for (unsigned int i = 0; !nsh_history_is_full(&history); i++) {
+        nsh_history_add_entry(&history, make_command_line(i % 8 + 1).c_str());
+    }
+    unsigned int age = std::min(static_cast<unsigned int>(state.range(0)), nsh_history_entry_count(&history) - 1);
+    char entry[NSH_LINE_BUFFER_SIZE];
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nsh_history_get_entry(&history, age, entry));
+    }
+}
+BENCHMARK(BM_HistoryGet)->Arg(0)->Arg(16)->Arg(1024);
+#endif
+
+// Read, split and execute command lines, from the first keystroke to the return of the handler
+void BM_ProcessLine(benchmark::State& state)
+{
+    BenchShell shell;
+    std::string script;
+    for (unsigned int i = 0; i < 100; i++) {
+        script += make_command_line(i % 8 + 1) + "\n";
+    }
+
+    for (auto _ : state) {
+        shell.feed(script);
+        nsh_run(&shell.nsh);
+    }
+    state.SetItemsProcessed(state.iterations() * 100);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(script.size()));
+}
+BENCHMARK(BM_ProcessLine);
+
+#if NSH_FEATURE_USE_SCRIPTS == 1
+constexpr unsigned int script_loop_count = 1000;
+
+// Call the last registered command from a C loop, the baseline of the script loops
+void BM_DirectCalls(benchmark::State& state)
+{
+    BenchShell shell;
+    const nsh_cmd_t* cmd = nsh_cmd_array_find(&shell.nsh.cmds, command_name(NSH_CMD_MAX_COUNT - 1).c_str());
+    char name[NSH_MAX_STRING_SIZE];
+    char arg[] = "arg";
+    char value[] = "1000";
+    std::copy_n(cmd->name, NSH_MAX_STRING_SIZE, name);
+    char* argv[] = { name, arg, value };
+    nsh_cmd_ctx_t ctx = { &shell.nsh, &shell.nsh.io, &shell.nsh.cancel };
+
+    for (auto _ : state) {
+        for (unsigned int i = 1; i <= script_loop_count; i++) {
+            benchmark::DoNotOptimize(cmd->handler(&ctx, 3, argv));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * script_loop_count);
+}
+BENCHMARK(BM_DirectCalls);
+
+// Call the last registered command from a compiled for loop, passing the loop variable or not
+void BM_ScriptLoop(benchmark::State& state)
+{
+    BenchShell shell;
+    std::string source = "for i in 1.." + std::to_string(script_loop_count) + "; "
+        + command_name(NSH_CMD_MAX_COUNT - 1) + (state.range(0) == 0 ? " arg 1000" : " arg $i") + "; end";
+    nsh_script_compile(&shell.nsh.script, &shell.nsh, source.c_str());
+    nsh_cmd_ctx_t ctx = { &shell.nsh, &shell.nsh.io, &shell.nsh.cancel };
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nsh_script_run(&shell.nsh.script, &ctx));
+    }
+    state.SetItemsProcessed(state.iterations() * script_loop_count);
+}
+BENCHMARK(BM_ScriptLoop)->Arg(0)->Arg(1);
+#endif
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,304 @@
+/*
+ * Replay a generated corpus of keystrokes through a native shell process and
+ * report its end-to-end throughput: commands per second, input bytes per
+ * second, and output bytes per command.
+ *
+ * The corpus mixes known and unknown commands with arguments, typos corrected
+ * with backspaces, autocompletion with tabs, history recalls with the arrow
+ * keys and lines discarded with Ctrl-C, and ends with a marker command and
+ * "exit". It is streamed into the shell either over a pipe or over a
+ * pseudo-terminal in raw mode, while its output is drained. The run fails if the
+ * marker is not echoed, the shell having stopped before the end of the corpus.
+ *
+ * The unknown commands are named so that no program of the PATH matches them,
+ * since the shell may run them as external programs.
+ *
+ * Usage: bench_nsh_e2e <shell> [pipe|pty] [commands] [seed]
+ *        bench_nsh_e2e --generate [commands] [seed]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+const std::vector<std::string> known_commands = { "help", "version" };
+// At most NSH_MAX_STRING_SIZE - 1 characters, as any argument
+const std::vector<std::string> unknown_commands = { "nsh-missing-0", "nsh-missing-1", "nsh-missing-2",
+    "nsh-missing-3", "nsh-missing-4", "nsh-missing-5", "nsh-missing-6", "nsh-missing-7" };
+// Last command of the corpus, echoed once every previous keystroke is processed
+const std::string end_marker = "nsh-bench-end";
+const std::vector<std::string> arguments = { "on", "off", "read", "write", "set", "get", "status", "reset", "0",
+    "1", "42", "0x40", "115200", "PA5", "-v", "--all" };
+// Prefixes completed into a single command by the tab key
+const std::vector<std::string> completable_prefixes = { "he", "hel", "ver", "vers" };
+
+const char* const arrow_up = "\x1b[A";
+const char* const arrow_down = "\x1b[B";
+
+struct Corpus {
+    std::string keystrokes;
+    unsigned int commands = 0; ///< Lines submitted or discarded
+};
+
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(unsigned int seed)
+        : m_random(seed)
+    {
+    }
+
+    Corpus generate(unsigned int commands)
+    {
+        Corpus corpus;
+        for (unsigned int i = 0; i < commands; i++) {
+            corpus.keystrokes += line();
+        }
+        corpus.keystrokes += end_marker + "\nexit\n";
+        corpus.commands = commands + 2;
+        return corpus;
+    }
+
+private:
+    // Keystrokes of a line, submitted by Enter or discarded by Ctrl-C
+    std::string line()
+    {
+        unsigned int kind = uniform(100);
+        if (kind < 35) {
+            return pick(known_commands) + "\n";
+        }
+        if (kind < 60) {
+            return command_with_arguments() + "\n";
+        }
+        if (kind < 70) {
+            return typo_corrected(command_with_arguments()) + "\n";
+        }
+        if (kind < 80) {
+            return pick(completable_prefixes) + "\t\n";
+        }
+        if (kind < 90) {
+            std::string keys;
+            for (unsigned int i = 0, count = 1 + uniform(3); i < count; i++) {
+                keys += arrow_up;
+            }
+            if (uniform(2) == 0) {
+                keys += arrow_down;
+            }
+            return keys + "\n";
+        }
+        if (kind < 95) {
+            std::string text = command_with_arguments();
+            return text.substr(0, 1 + uniform(static_cast<unsigned int>(text.size()))) + "\x03";
+        }
+        return "\n";
+    }
+
+    std::string command_with_arguments()
+    {
+        std::string text = pick(unknown_commands);
+        for (unsigned int i = 0, count = uniform(7); i < count; i++) {
+            text += " " + pick(arguments);
+        }
+        return text;
+    }
+
+    // Type wrong characters in the middle of 'text', then erase them
+    std::string typo_corrected(const std::string& text)
+    {
+        std::size_t position = 1 + uniform(static_cast<unsigned int>(text.size()));
+        unsigned int typo_size = 1 + uniform(3);
+        std::string keys = text.substr(0, position);
+        keys.append(typo_size, 'x');
+        keys.append(typo_size, '\b');
+        return keys + text.substr(position);
+    }
+
+    const std::string& pick(const std::vector<std::string>& values)
+    {
+        return values[uniform(static_cast<unsigned int>(values.size()))];
+    }
+
+    unsigned int uniform(unsigned int bound)
+    {
+        return std::uniform_int_distribution<unsigned int>(0, bound - 1)(m_random);
+    }
+
+    std::mt19937 m_random;
+};
+
+struct ShellProcess {
+    pid_t pid = -1;
+    int input_fd = -1;  ///< Written by the harness
+    int output_fd = -1; ///< Read by the harness
+};
+
+bool spawn_over_pipes(const char* shell, ShellProcess& process)
+{
+    int input[2];
+    int output[2];
+    if (pipe(input) != 0 || pipe(output) != 0) {
+        return false;
+    }
+    process.pid = fork();
+    if (process.pid == 0) {
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        close(input[0]);
+        close(input[1]);
+        close(output[0]);
+        close(output[1]);
+        execl(shell, shell, static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(input[0]);
+    close(output[1]);
+    process.input_fd = input[1];
+    process.output_fd = output[0];
+    return process.pid > 0;
+}
+
+bool spawn_over_pty(const char* shell, ShellProcess& process)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        return false;
+    }
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0) {
+        return false;
+    }
+    // Raw mode from the start, so that no keystroke is echoed nor interpreted by the line discipline
+    struct termios raw;
+    tcgetattr(slave, &raw);
+    cfmakeraw(&raw);
+    tcsetattr(slave, TCSANOW, &raw);
+
+    process.pid = fork();
+    if (process.pid == 0) {
+        setsid();
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        close(slave);
+        close(master);
+        execl(shell, shell, static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(slave);
+    process.input_fd = master;
+    process.output_fd = master;
+    return process.pid > 0;
+}
+
+void write_all(int fd, const std::string& data)
+{
+    std::size_t written = 0;
+    while (written < data.size()) {
+        ssize_t size = write(fd, data.data() + written, data.size() - written);
+        if (size <= 0) {
+            return;
+        }
+        written += static_cast<std::size_t>(size);
+    }
+}
+
+// Read until the end of the output, a pseudo-terminal reporting an error once the shell has exited
+std::size_t drain(int fd, std::string& tail)
+{
+    std::size_t total = 0;
+    char buffer[4096];
+    ssize_t size;
+    while ((size = read(fd, buffer, sizeof(buffer))) > 0) {
+        total += static_cast<std::size_t>(size);
+        // Only the end of the output is kept, to look for the marker
+        tail.append(buffer, static_cast<std::size_t>(size));
+        if (tail.size() > 2 * sizeof(buffer)) {
+            tail.erase(0, tail.size() - sizeof(buffer));
+        }
+    }
+    return total;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::fprintf(stderr,
+            "usage: %s <shell> [pipe|pty] [commands] [seed]\n"
+            "       %s --generate [commands] [seed]\n",
+            argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+    bool generate_only = std::strcmp(argv[1], "--generate") == 0;
+    int next_arg = generate_only ? 2 : 3;
+    bool use_pty = !generate_only && argc > 2 && std::strcmp(argv[2], "pty") == 0;
+    unsigned int commands = 100000;
+    unsigned int seed = 1;
+    if (argc > next_arg) {
+        commands = static_cast<unsigned int>(std::strtoul(argv[next_arg], nullptr, 10));
+    }
+    if (argc > next_arg + 1) {
+        seed = static_cast<unsigned int>(std::strtoul(argv[next_arg + 1], nullptr, 10));
+    }
+
+    Corpus corpus = CorpusGenerator(seed).generate(commands);
+    if (generate_only) {
+        std::fwrite(corpus.keystrokes.data(), 1, corpus.keystrokes.size(), stdout);
+        return EXIT_SUCCESS;
+    }
+
+    // A shell exiting before the end of the corpus is reported by its status rather than by SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+
+    ShellProcess process;
+    bool spawned = use_pty ? spawn_over_pty(argv[1], process) : spawn_over_pipes(argv[1], process);
+    if (!spawned) {
+        std::fprintf(stderr, "ERROR: cannot start %s over a %s\n", argv[1], use_pty ? "pseudo-terminal" : "pipe");
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread writer([&] {
+        write_all(process.input_fd, corpus.keystrokes);
+        if (!use_pty) {
+            close(process.input_fd);
+        }
+    });
+    std::string output_tail;
+    std::size_t output_size = drain(process.output_fd, output_tail);
+    writer.join();
+    int status = 0;
+    waitpid(process.pid, &status, 0);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    close(process.output_fd);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::fprintf(stderr, "ERROR: the shell did not exit normally\n");
+        return EXIT_FAILURE;
+    }
+    if (output_tail.find(end_marker) == std::string::npos) {
+        std::fprintf(stderr, "ERROR: the shell stopped before the end of the corpus\n");
+        return EXIT_FAILURE;
+    }
+
+    std::printf("%8s %10s %12s %14s %14s %16s\n", "mode", "commands", "time (ms)", "commands/s", "input MB/s",
+        "output B/command");
+    std::printf("%8s %10u %12.1f %14.0f %14.2f %16.1f\n", use_pty ? "pty" : "pipe", corpus.commands,
+        elapsed.count() * 1000.0, corpus.commands / elapsed.count(),
+        static_cast<double>(corpus.keystrokes.size()) / elapsed.count() / 1e6,
+        static_cast<double>(output_size) / corpus.commands);
+
+    return EXIT_SUCCESS;
+}
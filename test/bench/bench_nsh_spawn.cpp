@@ -0,0 +1,148 @@
+/*
+ * Compare the latency of launching an external program with posix_spawn, as
+ * nsh_posix_spawn_command() does, against fork and exec, and measure the
+ * latency of an external command run through the shell.
+ *
+ * Each launch runs /bin/true and waits for it to exit. fork copies the page
+ * tables of the parent, its cost growing with the memory the parent touched,
+ * while posix_spawn does not, so the launches are measured with a parent
+ * touching no memory then 'rss' megabytes.
+ *
+ * Usage: bench_nsh_spawn [launches] [rss]
+ */
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_io_memory.h>
+#include <nsh/nsh_spawn_posix.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+const char* const program = "/bin/true";
+
+bool launch_posix_spawn()
+{
+    char* argv[] = { const_cast<char*>(program), nullptr };
+    pid_t pid;
+    if (posix_spawn(&pid, program, nullptr, nullptr, argv, environ) != 0) {
+        return false;
+    }
+    int status;
+    return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool launch_fork_exec()
+{
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        char* argv[] = { const_cast<char*>(program), nullptr };
+        execve(program, argv, environ);
+        _exit(127);
+    }
+    int status;
+    return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Run 'launches' launches, returning the mean latency in microseconds, or a negative value on failure
+template <typename Launch>
+double measure(Launch launch, unsigned int launches)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < launches; i++) {
+        if (!launch()) {
+            return -1.0;
+        }
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / launches;
+}
+
+// Run 'launches' command lines "true" through a shell falling back to nsh_posix_spawn_command()
+double measure_shell(unsigned int launches)
+{
+    std::string script;
+    for (unsigned int i = 0; i < launches; i++) {
+        script += "true\n";
+    }
+    std::vector<char> output(script.size() * 4 + 1024);
+    static nsh_t nsh;
+    nsh_init_inplace(&nsh);
+    nsh_set_command_not_found_handler(&nsh, nsh_posix_spawn_command);
+    nsh_io_memory_t mem;
+    nsh_io_memory_init(&mem, script.data(), static_cast<unsigned int>(script.size()), output.data(),
+        static_cast<unsigned int>(output.size()));
+    nsh_set_io(&nsh, &nsh_io_memory_backend, &mem);
+
+    auto start = std::chrono::steady_clock::now();
+    nsh_run(&nsh);
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (std::string(output.data(), std::min<std::size_t>(mem.output_size, output.size())).find("ERROR")
+        != std::string::npos) {
+        return -1.0;
+    }
+    return elapsed.count() / launches;
+}
+
+void print_row(const char* method, unsigned int rss_mb, double latency_us)
+{
+    std::printf("%-14s %8u %14.1f\n", method, rss_mb, latency_us);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned int launches = (argc > 1) ? static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10)) : 1000u;
+    unsigned int rss_mb = (argc > 2) ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : 256u;
+    if (launches == 0) {
+        std::fprintf(stderr, "usage: %s [launches] [rss]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("%-14s %8s %14s\n", "method", "rss (MB)", "latency (us)");
+    std::vector<double> results;
+    for (unsigned int touched_mb : { 0u, rss_mb }) {
+        // Touch every page so that it is mapped in the parent
+        std::vector<char> memory(static_cast<std::size_t>(touched_mb) * 1024 * 1024, 1);
+
+        double spawn_us = measure(launch_posix_spawn, launches);
+        double fork_us = measure(launch_fork_exec, launches);
+        print_row("posix_spawn", touched_mb, spawn_us);
+        print_row("fork+exec", touched_mb, fork_us);
+        results.push_back(spawn_us);
+        results.push_back(fork_us);
+        if (touched_mb == 0) {
+            double shell_us = measure_shell(launches);
+            print_row("nsh", touched_mb, shell_us);
+            results.push_back(shell_us);
+        }
+        if (rss_mb == 0) {
+            break;
+        }
+    }
+
+    for (double result : results) {
+        if (result < 0.0) {
+            std::fprintf(stderr, "ERROR: %s did not run successfully\n", program);
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/*
+ * Run N independent shells on N threads, each one executing the same script
+ * from memory, and report the throughput for 1, 2, 4... N threads.
+ * Since the shells share no state, the throughput shall scale linearly with the
+ * number of threads, up to the number of available cores.
+ *
+ * Usage: bench_nsh_threads [max-threads] [commands-per-shell]
+ */
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_io_memory.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+nsh_status_t cmd_sum(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    long sum = 0;
+    for (unsigned int i = 1; i < argc; i++) {
+        sum += std::strtol(argv[i], nullptr, 10);
+    }
+    nsh_io_printf(ctx->io, "%ld", sum);
+    return NSH_STATUS_OK;
+}
+
+struct BenchShell {
+    std::vector<char> output;
+    nsh_io_memory_t mem;
+    nsh_t nsh;
+
+    BenchShell(const BenchShell&) = delete;
+    BenchShell& operator=(const BenchShell&) = delete;
+
+    BenchShell(const std::string& script, std::size_t output_capacity)
+        : output(output_capacity)
+    {
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+        nsh_register_command(&nsh, "sum", cmd_sum);
+        nsh_io_memory_init(&mem, script.data(), static_cast<unsigned int>(script.size()), output.data(),
+            static_cast<unsigned int>(output.size()));
+        nsh_set_io(&nsh, &nsh_io_memory_backend, &mem);
+    }
+
+    std::string written() const
+    {
+        return std::string(output.data(), mem.output_size);
+    }
+};
+
+std::string make_script(unsigned int commands)
+{
+    std::string script;
+    for (unsigned int i = 0; i < commands; i++) {
+        script += "sum " + std::to_string(i) + " " + std::to_string(i % 7) + " 42\n";
+    }
+    script += "exit\n";
+    return script;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned int max_threads = std::thread::hardware_concurrency();
+    unsigned int commands = 20000;
+    if (argc > 1) {
+        max_threads = static_cast<unsigned int>(std::strtoul(argv[1], nullptr, 10));
+    }
+    if (argc > 2) {
+        commands = static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10));
+    }
+    if (max_threads == 0) {
+        max_threads = 1;
+    }
+
+    std::string script = make_script(commands);
+
+    // Single shell runs, giving the output size then the expected output
+    auto reference = std::make_unique<BenchShell>(script, 0);
+    nsh_run(&reference->nsh);
+    std::size_t output_size = reference->mem.output_size;
+    reference = std::make_unique<BenchShell>(script, output_size);
+    nsh_run(&reference->nsh);
+    std::string expected = reference->written();
+
+    std::vector<unsigned int> threads_counts;
+    for (unsigned int threads_count = 1; threads_count < max_threads; threads_count *= 2) {
+        threads_counts.push_back(threads_count);
+    }
+    threads_counts.push_back(max_threads);
+
+    std::printf("%8s %12s %14s %9s %11s\n", "threads", "time (ms)", "commands/s", "speedup", "efficiency");
+
+    double base_throughput = 0.0;
+    for (unsigned int threads_count : threads_counts) {
+        std::vector<std::unique_ptr<BenchShell>> shells;
+        for (unsigned int i = 0; i < threads_count; i++) {
+            shells.push_back(std::make_unique<BenchShell>(script, output_size));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (auto& shell : shells) {
+            threads.emplace_back([&shell] { nsh_run(&shell->nsh); });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        for (auto& shell : shells) {
+            if (shell->written() != expected) {
+                std::fprintf(stderr, "ERROR: the output of a shell differs with %u threads\n", threads_count);
+                return EXIT_FAILURE;
+            }
+        }
+
+        double throughput = threads_count * static_cast<double>(commands) / elapsed.count();
+        if (threads_count == 1) {
+            base_throughput = throughput;
+        }
+        double speedup = throughput / base_throughput;
+        std::printf("%8u %12.1f %14.0f %9.2f %10.0f%%\n", threads_count, elapsed.count() * 1000.0, throughput,
+            speedup, 100.0 * speedup / threads_count);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -17,17 +17,47 @@ void enableRawMode()
 }
 
 #include <nsh/nsh.h>
+#include <nsh/nsh_interrupt_posix.h>
+#include <nsh/nsh_spawn_posix.h>
+#include <nsh/nsh_trace_chrome.h>
 
 #include <stdio.h>
 
+static nsh_t nsh;
+#if NSH_FEATURE_USE_TRACE == 1
+static nsh_trace_t trace;
+#endif
+
 int main(void)
 {
     enableRawMode();
     // setvbuf(stdin, NULL, _IONBF, 0);
     // setvbuf(stdout, NULL, _IONBF, 0);
-    nsh_status_t status = NSH_STATUS_OK;
-    nsh_t nsh = nsh_init(&status);            // status intentionally ignored
+    nsh_init_inplace(&nsh);                   // status intentionally ignored
     nsh_register_command(&nsh, "null", NULL); // NSH_NON_NULL precondition not satisfied
+    nsh_set_clock(&nsh, nsh_posix_clock_ms);
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    nsh_set_cycle_counter(&nsh, nsh_posix_clock_us, 1000000u);
+#endif
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+    nsh_set_command_not_found_handler(&nsh, nsh_posix_spawn_command); // Run the programs of the PATH
+#endif
+    nsh_posix_interrupt_install(&nsh); // Ctrl-C cancels the running command
+#if NSH_FEATURE_USE_TRACE == 1
+    // Trace the session into the Chrome trace file named by NSH_TRACE_FILE, if any
+    const char* trace_path = getenv("NSH_TRACE_FILE");
+    if (trace_path != NULL) {
+        nsh_trace_start(&trace, nsh_posix_clock_us, 1000000u);
+        nsh_set_trace(&nsh, &trace);
+    }
+#endif
     nsh_run(&nsh);
+    nsh_posix_interrupt_uninstall();
+#if NSH_FEATURE_USE_TRACE == 1
+    if (trace_path != NULL) {
+        nsh_trace_stop(&trace);
+        nsh_trace_export_chrome_to_path(&trace, trace_path);
+    }
+#endif
     return 0;
 }
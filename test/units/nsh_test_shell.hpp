@@ -0,0 +1,32 @@
+#ifndef NSH_TEST_SHELL_HPP_
+#define NSH_TEST_SHELL_HPP_
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_io_memory.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace nsh_test {
+
+/**
+ * @brief Run the shell on 'script' until the script is exhausted or exited, and return everything the shell wrote.
+ *
+ * The output beyond 'output_capacity' bytes is dropped.
+ */
+inline std::string run(nsh_t& nsh, const std::string& script, std::size_t output_capacity = 16 * 1024)
+{
+    std::vector<char> output(output_capacity);
+    nsh_io_memory_t mem;
+    nsh_io_memory_init(&mem, script.data(), static_cast<unsigned int>(script.size()), output.data(),
+        static_cast<unsigned int>(output.size()));
+    nsh_set_io(&nsh, &nsh_io_memory_backend, &mem);
+    nsh_run(&nsh);
+    return std::string(output.data(), std::min<std::size_t>(mem.output_size, output.size()));
+}
+
+} // namespace nsh_test
+
+#endif // NSH_TEST_SHELL_HPP_
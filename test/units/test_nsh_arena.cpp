@@ -0,0 +1,186 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+
+#include <string>
+#include <vector>
+
+using testing::HasSubstr;
+using testing::Not;
+
+namespace {
+
+constexpr nsh_limits_t small_limits = {
+    .line_buffer_size = 32,
+    .cmd_max_count = 6,
+    .cmd_args_max_count = 4,
+    .cmd_history_size = 64,
+};
+
+unsigned int last_argc;
+
+nsh_status_t cmd_count_args(nsh_cmd_ctx_t*, unsigned int argc, char**)
+{
+    last_argc = argc;
+    return NSH_STATUS_OK;
+}
+
+class NshArena : public testing::Test {
+protected:
+    void SetUp() override { last_argc = 0; }
+
+    nsh_status_t init(const nsh_limits_t& limits)
+    {
+        arena.assign(nsh_arena_size(&limits) / sizeof(void*) + 1, nullptr);
+        return nsh_init_with_arena(&nsh, arena.data(), nsh_arena_size(&limits), &limits);
+    }
+
+    std::string run(const std::string& script) { return nsh_test::run(nsh, script); }
+
+    std::vector<void*> arena; ///< Pointer-aligned storage
+    nsh_t nsh;
+};
+
+} // namespace
+
+TEST(NshArenaSize, SuccessSizeMatchesMacro)
+{
+    static_assert(NSH_ARENA_SIZE(32u, 6u, 4u, 64u) > 0, "usable in constant expressions");
+
+    ASSERT_EQ(nsh_arena_size(&small_limits), NSH_ARENA_SIZE(32u, 6u, 4u, 64u));
+#if NSH_FEATURE_USE_HISTORY == 1
+    ASSERT_EQ(nsh_arena_size(&small_limits), 6 * sizeof(nsh_cmd_t) + 4 * (sizeof(char*) + NSH_MAX_STRING_SIZE) + 96);
+#endif
+}
+
+TEST_F(NshArena, FailureArenaTooSmall)
+{
+    arena.assign(nsh_arena_size(&small_limits) / sizeof(void*) + 1, nullptr);
+
+    ASSERT_EQ(nsh_init_with_arena(&nsh, arena.data(), nsh_arena_size(&small_limits) - 1, &small_limits),
+        NSH_STATUS_BUFFER_OVERFLOW);
+}
+
+TEST_F(NshArena, FailureMisalignedArena)
+{
+    arena.assign(nsh_arena_size(&small_limits) / sizeof(void*) + 2, nullptr);
+    char* misaligned = reinterpret_cast<char*>(arena.data()) + 1;
+
+    ASSERT_EQ(nsh_init_with_arena(&nsh, misaligned, nsh_arena_size(&small_limits), &small_limits),
+        NSH_STATUS_WRONG_ARG);
+}
+
+TEST_F(NshArena, FailureInvalidLimits)
+{
+    nsh_limits_t limits = small_limits;
+    limits.line_buffer_size = 0;
+    ASSERT_EQ(init(limits), NSH_STATUS_WRONG_ARG);
+
+#if NSH_FEATURE_USE_HISTORY == 1
+    limits = small_limits;
+    limits.cmd_history_size = limits.line_buffer_size;
+    ASSERT_EQ(init(limits), NSH_STATUS_WRONG_ARG);
+#endif
+}
+
+TEST_F(NshArena, FailureTooFewCommandsForBuiltins)
+{
+    nsh_limits_t limits = small_limits;
+    limits.cmd_max_count = 1;
+
+    ASSERT_EQ(init(limits), NSH_STATUS_WRONG_ARG);
+}
+
+#if NSH_FEATURE_USE_HISTORY == 1
+TEST_F(NshArena, SuccessSmallestHistory)
+{
+    nsh_limits_t limits = small_limits;
+    limits.cmd_history_size = limits.line_buffer_size - 1 + NSH_HISTORY_ENTRY_OVERHEAD;
+    ASSERT_EQ(init(limits), NSH_STATUS_OK);
+
+    std::string line(limits.line_buffer_size - 1, 'a');
+    run(line + "\n");
+
+    char entry[32];
+    ASSERT_EQ(nsh_history_get_entry(&nsh.history, 0, entry), NSH_STATUS_OK);
+    ASSERT_EQ(std::string(entry), line);
+
+    limits.cmd_history_size--;
+    ASSERT_EQ(init(limits), NSH_STATUS_WRONG_ARG);
+}
+#endif
+
+TEST_F(NshArena, SuccessRunShell)
+{
+    ASSERT_EQ(init(small_limits), NSH_STATUS_OK);
+
+    auto output = run("help\nexit\n");
+
+    ASSERT_THAT(output, HasSubstr("This is an helpful help message !"));
+}
+
+#if NSH_FEATURE_USE_AUTOCOMPLETION == 1
+TEST_F(NshArena, SuccessAutocomplete)
+{
+    ASSERT_EQ(init(small_limits), NSH_STATUS_OK);
+
+    auto output = run("e\t\n");
+
+    ASSERT_THAT(output, HasSubstr("\r\nexit \r\n> e"));
+}
+#endif
+
+TEST_F(NshArena, SuccessLineLimitedToRuntimeSize)
+{
+    ASSERT_EQ(init(small_limits), NSH_STATUS_OK);
+    ASSERT_EQ(NSH_LINE_BUFFER_CAPACITY(&nsh.line), 32u);
+
+    unsigned int appended = 0;
+    while (nsh_line_buffer_append_char(&nsh.line, 'a') == NSH_STATUS_OK) {
+        appended++;
+    }
+
+    ASSERT_EQ(appended, 32u);
+}
+
+TEST_F(NshArena, FailureCommandLimit)
+{
+    ASSERT_EQ(init(small_limits), NSH_STATUS_OK);
+    unsigned int builtin_count = nsh.cmds.count;
+
+    for (unsigned int i = builtin_count; i < small_limits.cmd_max_count; i++) {
+        ASSERT_EQ(nsh_register_command(&nsh, ("cmd" + std::to_string(i)).c_str(), cmd_count_args), NSH_STATUS_OK);
+    }
+
+    ASSERT_EQ(nsh_register_command(&nsh, "one_too_many", cmd_count_args), NSH_STATUS_MAX_CMD_NB_REACH);
+}
+
+TEST_F(NshArena, FailureArgumentLimit)
+{
+    ASSERT_EQ(init(small_limits), NSH_STATUS_OK);
+    nsh_register_command(&nsh, "args", cmd_count_args);
+
+    run("args a b\nargs a b c d e\n");
+
+    // The second command line has too many arguments and is ignored
+    ASSERT_EQ(last_argc, 3u);
+}
+
+#if NSH_FEATURE_USE_HISTORY == 1
+TEST_F(NshArena, SuccessHistoryInArena)
+{
+    ASSERT_EQ(init(small_limits), NSH_STATUS_OK);
+
+    auto output = run("version\n\x1b[A\n");
+
+    ASSERT_EQ(nsh_history_entry_count(&nsh.history), 1u);
+    ASSERT_THAT(output, Not(HasSubstr("not found")));
+}
+#endif
+
+#endif // NSH_FEATURE_USE_RUNTIME_LIMITS == 1
@@ -0,0 +1,206 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#include "nsh_test_shell.hpp"
+
+#include <atomic>
+#include <string>
+
+#if GTEST_HAS_PTHREAD
+#include <thread>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <nsh/nsh_interrupt_posix.h>
+
+#include <csignal>
+#endif
+
+using testing::HasSubstr;
+
+namespace {
+
+// Simulated time, elapsing each time it is read
+unsigned int fake_now_ms;
+
+unsigned int fake_clock()
+{
+    return fake_now_ms++;
+}
+
+std::atomic<bool> spinning;
+
+nsh_status_t cmd_spin(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    spinning = true;
+    while (!nsh_cmd_is_cancelled(ctx)) {
+#if GTEST_HAS_PTHREAD
+        std::this_thread::yield();
+#endif
+    }
+    return NSH_STATUS_CANCELLED;
+}
+
+// Interrupt itself, as a Ctrl-C received while the command runs
+nsh_status_t cmd_self_interrupt(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    nsh_interrupt(ctx->nsh);
+    return nsh_cmd_is_cancelled(ctx) ? NSH_STATUS_CANCELLED : NSH_STATUS_OK;
+}
+
+nsh_status_t cmd_check(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    nsh_io_put_string(ctx->io, nsh_cmd_is_cancelled(ctx) ? "cancelled" : "running");
+    return NSH_STATUS_OK;
+}
+
+class NshCancel : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        fake_now_ms = 0;
+        spinning = false;
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+        nsh_register_command(&nsh, "spin", cmd_spin);
+        nsh_register_command(&nsh, "self_interrupt", cmd_self_interrupt);
+        nsh_register_command(&nsh, "check", cmd_check);
+    }
+
+    std::string run(const std::string& script) { return nsh_test::run(nsh, script); }
+
+    nsh_t nsh;
+};
+
+} // namespace
+
+TEST(NshCancelToken, SuccessCancel)
+{
+    nsh_cancel_token_t token;
+    nsh_cancel_token_init(&token, nullptr, 0);
+    ASSERT_FALSE(nsh_cancel_token_is_cancelled(&token));
+
+    nsh_cancel_token_cancel(&token);
+
+    ASSERT_TRUE(nsh_cancel_token_is_cancelled(&token));
+    ASSERT_FALSE(token.timed_out);
+}
+
+TEST(NshCancelToken, SuccessDeadline)
+{
+    fake_now_ms = 0;
+    nsh_cancel_token_t token;
+    nsh_cancel_token_init(&token, fake_clock, 10);
+
+    unsigned int polls = 0;
+    while (!nsh_cancel_token_is_cancelled(&token)) {
+        polls++;
+    }
+
+    ASSERT_EQ(polls, 9u);
+    ASSERT_TRUE(token.timed_out);
+}
+
+TEST(NshCancelToken, SuccessDeadlineAcrossClockWrapAround)
+{
+    fake_now_ms = 0xFFFFFFF0u;
+    nsh_cancel_token_t token;
+    nsh_cancel_token_init(&token, fake_clock, 100);
+
+    ASSERT_FALSE(nsh_cancel_token_is_cancelled(&token));
+    fake_now_ms = 50;
+    ASSERT_FALSE(nsh_cancel_token_is_cancelled(&token));
+    fake_now_ms = 90;
+    ASSERT_TRUE(nsh_cancel_token_is_cancelled(&token));
+}
+
+TEST(NshCancelToken, SuccessNoDeadlineWithoutTimeout)
+{
+    nsh_cancel_token_t token;
+    nsh_cancel_token_init(&token, fake_clock, 0);
+
+    fake_now_ms = 0xFFFFFFFFu;
+    ASSERT_FALSE(nsh_cancel_token_is_cancelled(&token));
+}
+
+TEST_F(NshCancel, SuccessTimeout)
+{
+    nsh_set_clock(&nsh, fake_clock);
+    nsh_set_command_timeout(&nsh, 100);
+
+    auto output = run("spin\ncheck\n");
+
+    ASSERT_THAT(output, HasSubstr("ERROR: command 'spin' timed out\r\n"));
+    // The next command gets a new token
+    ASSERT_THAT(output, HasSubstr("running"));
+}
+
+TEST_F(NshCancel, SuccessInterrupt)
+{
+    auto output = run("self_interrupt\ncheck\n");
+
+    ASSERT_THAT(output, HasSubstr("ERROR: command 'self_interrupt' cancelled\r\n"));
+    ASSERT_THAT(output, HasSubstr("running"));
+}
+
+TEST_F(NshCancel, SuccessInterruptBeforeCommandIgnored)
+{
+    nsh_interrupt(&nsh);
+
+    auto output = run("check\n");
+
+    ASSERT_THAT(output, HasSubstr("running"));
+}
+
+TEST_F(NshCancel, SuccessCtrlCDiscardsLine)
+{
+    auto output = run("chec\x03"
+                      "check\n");
+
+    ASSERT_THAT(output, HasSubstr("> chec^C\r\n> check\r\n"));
+    ASSERT_THAT(output, HasSubstr("running"));
+}
+
+#if GTEST_HAS_PTHREAD
+TEST_F(NshCancel, SuccessInterruptFromAnotherThread)
+{
+    std::thread interrupter([this] {
+        // Interrupt once the command is running, the token being reset when it starts
+        while (!spinning) {
+            std::this_thread::yield();
+        }
+        nsh_interrupt(&nsh);
+    });
+
+    auto output = run("spin\n");
+    interrupter.join();
+
+    ASSERT_THAT(output, HasSubstr("ERROR: command 'spin' cancelled\r\n"));
+}
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST_F(NshCancel, SuccessPosixSigint)
+{
+    ASSERT_EQ(nsh_posix_interrupt_install(&nsh), NSH_STATUS_OK);
+    nsh_register_command(&nsh, "sigint", [](nsh_cmd_ctx_t* ctx, unsigned int, char**) {
+        std::raise(SIGINT);
+        return nsh_cmd_is_cancelled(ctx) ? NSH_STATUS_CANCELLED : NSH_STATUS_OK;
+    });
+
+    auto output = run("sigint\n");
+    nsh_posix_interrupt_uninstall();
+
+    ASSERT_THAT(output, HasSubstr("ERROR: command 'sigint' cancelled\r\n"));
+}
+
+TEST(NshPosixClock, SuccessMonotonic)
+{
+    unsigned int start = nsh_posix_clock_ms();
+    unsigned int end = nsh_posix_clock_ms();
+
+    ASSERT_LE(end - start, 1000u);
+}
+#endif
@@ -3,12 +3,13 @@
 
 #include <nsh/nsh_cmd_array.h>
 
+using testing::AllOf;
 using testing::Each;
-using testing::FieldsAre;
+using testing::Field;
 using testing::StrEq;
 
 static constexpr const char cmd_test_name[NSH_MAX_STRING_SIZE] = "test";
-static nsh_status_t cmd_test_handler(unsigned int, char**)
+static nsh_status_t cmd_test_handler(nsh_cmd_ctx_t*, unsigned int, char**)
 {
     return NSH_STATUS_OK;
 }
@@ -21,7 +22,7 @@ TEST(NshCmdArrayInit, Success)
 
     ASSERT_EQ(status, NSH_STATUS_OK);
     ASSERT_EQ(cmds.count, 0);
-    ASSERT_THAT(cmds.array, Each(FieldsAre(nullptr, StrEq(""))));
+    ASSERT_THAT(cmds.array, Each(AllOf(Field(&nsh_cmd_t::handler, nullptr), Field(&nsh_cmd_t::name, StrEq("")))));
 }
 
 TEST(NshCmdArrayRegister, SuccessOneElement)
@@ -122,15 +123,15 @@ TEST(NshCmdArrayFind, Success)
     ASSERT_STREQ(cmd->name, "cmd2_test");
 }
 
-static nsh_status_t cmd1(unsigned int, char**)
+static nsh_status_t cmd1(nsh_cmd_ctx_t*, unsigned int, char**)
 {
     return static_cast<nsh_status_t>(1);
 }
-static nsh_status_t cmd2(unsigned int, char**)
+static nsh_status_t cmd2(nsh_cmd_ctx_t*, unsigned int, char**)
 {
     return static_cast<nsh_status_t>(2);
 }
-static nsh_status_t cmd3(unsigned int, char**)
+static nsh_status_t cmd3(nsh_cmd_ctx_t*, unsigned int, char**)
 {
     return static_cast<nsh_status_t>(3);
 }
@@ -0,0 +1,229 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_coroutine.hpp>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_JOBS == 1 && defined(__cpp_impl_coroutine)
+
+#include <nsh/nsh_io_memory.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+using testing::HasSubstr;
+
+namespace {
+
+// Simulated time, elapsing only when the executor is idle
+std::chrono::milliseconds fake_now;
+
+std::chrono::milliseconds fake_clock()
+{
+    return fake_now;
+}
+
+void fake_idle(std::chrono::milliseconds delay)
+{
+    fake_now += delay;
+}
+
+bool notified = false;
+
+// Print the tick number 'argv[1]' times, every 100ms
+nsh::Task<nsh_status_t> cmd_ticker(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    unsigned long count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1;
+    for (unsigned long i = 0; i < count; i++) {
+        if (!co_await nsh::sleep_for(100ms)) {
+            co_return NSH_STATUS_FAILURE;
+        }
+        nsh_io_put_unsigned(ctx->io, static_cast<unsigned int>(i));
+        nsh_io_put_char(ctx->io, ' ');
+    }
+    co_return NSH_STATUS_OK;
+}
+
+nsh::Task<nsh_status_t> cmd_waiter(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    if (!co_await nsh::wait_until([] { return notified; })) {
+        co_return NSH_STATUS_FAILURE;
+    }
+    nsh_io_put_string(ctx->io, "notified");
+    co_return NSH_STATUS_OK;
+}
+
+nsh::Task<nsh_status_t> cmd_timeout(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    bool ready = co_await nsh::wait_until([] { return false; }, 50ms);
+    nsh_io_put_string(ctx->io, ready ? "ready" : "timeout");
+    co_return NSH_STATUS_OK;
+}
+
+nsh::Task<unsigned int> slow_sum(unsigned int a, unsigned int b)
+{
+    co_await nsh::sleep_for(10ms);
+    co_return a + b;
+}
+
+nsh::Task<nsh_status_t> cmd_sum(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    unsigned int sum = co_await slow_sum(1, 2);
+    sum = co_await slow_sum(sum, 3);
+    nsh_io_put_string(ctx->io, "sum=");
+    nsh_io_put_unsigned(ctx->io, sum);
+    co_return NSH_STATUS_OK;
+}
+
+nsh_status_t cmd_notify(nsh_cmd_ctx_t*, unsigned int, char**)
+{
+    notified = true;
+    return NSH_STATUS_OK;
+}
+
+/*
+ * Input backend without input available while a release time is not reached,
+ * the simulated time elapsing while waiting.
+ */
+struct DelayedInput {
+    nsh_io_memory_t mem;
+    std::chrono::milliseconds release_time;
+    unsigned int release_offset; ///< Input offset from which the characters are delayed
+};
+
+int delayed_input_read(void* ctx)
+{
+    return nsh_io_memory_backend.read(&static_cast<DelayedInput*>(ctx)->mem);
+}
+
+void delayed_input_write(void* ctx, const char* data, unsigned int size)
+{
+    nsh_io_memory_backend.write(&static_cast<DelayedInput*>(ctx)->mem, data, size);
+}
+
+bool delayed_input_wait(void* ctx, unsigned int timeout_ms)
+{
+    auto* input = static_cast<DelayedInput*>(ctx);
+    if (input->mem.input_offset < input->release_offset || fake_now >= input->release_time) {
+        return true;
+    }
+    std::chrono::milliseconds remaining = input->release_time - fake_now;
+    std::chrono::milliseconds timeout(timeout_ms);
+    fake_now += (timeout < remaining) ? timeout : remaining;
+    return fake_now >= input->release_time;
+}
+
+const nsh_io_backend_t delayed_input_backend = {
+    .read = delayed_input_read,
+    .write = delayed_input_write,
+    .wait = delayed_input_wait,
+};
+
+class NshCoroutine : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        fake_now = 0ms;
+        notified = false;
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+        nsh_register_command(&nsh, "ticker", nsh::coroutine_handler<cmd_ticker>);
+        nsh_register_command(&nsh, "waiter", nsh::coroutine_handler<cmd_waiter>);
+        nsh_register_command(&nsh, "timeout", nsh::coroutine_handler<cmd_timeout>);
+        nsh_register_command(&nsh, "sum", nsh::coroutine_handler<cmd_sum>);
+        nsh_register_command(&nsh, "notify", cmd_notify);
+        nsh_set_executor(&nsh, executor.executor());
+    }
+
+    std::string run(const std::string& script) { return nsh_test::run(nsh, script); }
+
+    nsh::CoroutineExecutor executor { fake_clock, fake_idle };
+    nsh_t nsh;
+};
+
+} // namespace
+
+TEST_F(NshCoroutine, SuccessForeground)
+{
+    auto output = run("ticker 3\n");
+
+    ASSERT_THAT(output, HasSubstr("0 1 2 "));
+    ASSERT_GE(fake_now, 300ms);
+}
+
+TEST_F(NshCoroutine, SuccessBackgroundCommandsRunConcurrently)
+{
+    auto output = run("ticker 3 &\nticker 3 &\nfg 1\nfg 2\n");
+
+    ASSERT_THAT(output, HasSubstr("[1] Done ticker"));
+    ASSERT_THAT(output, HasSubstr("[2] Done ticker"));
+    ASSERT_LT(fake_now, 600ms);
+}
+
+TEST_F(NshCoroutine, SuccessWaitUntil)
+{
+    auto output = run("waiter &\nnotify\nfg\n");
+
+    ASSERT_THAT(output, HasSubstr("notified"));
+    ASSERT_THAT(output, HasSubstr("[1] Done waiter"));
+}
+
+TEST_F(NshCoroutine, SuccessWaitUntilTimeout)
+{
+    auto output = run("timeout\n");
+
+    ASSERT_THAT(output, HasSubstr("timeout"));
+    ASSERT_GE(fake_now, 50ms);
+}
+
+TEST_F(NshCoroutine, SuccessAwaitNestedTasks)
+{
+    auto output = run("sum &\nfg\n");
+
+    ASSERT_THAT(output, HasSubstr("sum=6"));
+}
+
+TEST_F(NshCoroutine, SuccessKillSuspended)
+{
+    auto output = run("ticker 1000 &\nkill 1\nfg\n");
+
+    ASSERT_THAT(output, HasSubstr("[1] Exit " + std::to_string(NSH_STATUS_FAILURE) + " ticker"));
+    ASSERT_LT(fake_now, 1000ms);
+}
+
+TEST_F(NshCoroutine, SuccessResumedWhileWaitingForInput)
+{
+    std::string script = "ticker 2 &\nexit\n";
+    std::vector<char> buffer(16 * 1024);
+    DelayedInput input;
+    nsh_io_memory_init(&input.mem, script.data(), static_cast<unsigned int>(script.size()), buffer.data(),
+        static_cast<unsigned int>(buffer.size()));
+    input.release_time = 1000ms;
+    input.release_offset = static_cast<unsigned int>(script.find("exit"));
+    nsh_set_io(&nsh, &delayed_input_backend, &input);
+
+    nsh_run(&nsh);
+
+    // The job completed while the shell was waiting for the exit command
+    std::string result(buffer.data(), std::min<std::size_t>(input.mem.output_size, buffer.size()));
+    ASSERT_THAT(result, HasSubstr("0 1 \r\n[1] Done ticker"));
+    ASSERT_LT(result.find("[1] Done ticker"), result.find("exit"));
+}
+
+TEST(NshCoroutineNoExecutor, SuccessForeground)
+{
+    nsh_status_t status;
+    nsh_t nsh = nsh_init(&status);
+    nsh_register_command(&nsh, "sum", nsh::coroutine_handler<cmd_sum>);
+
+    auto result = nsh_test::run(nsh, "sum\nsum &\n");
+    ASSERT_THAT(result, HasSubstr("sum=6"));
+    ASSERT_THAT(result, HasSubstr("ERROR: no executor for background jobs"));
+}
+
+#endif // NSH_FEATURE_USE_JOBS == 1 && defined(__cpp_impl_coroutine)
@@ -3,6 +3,30 @@
 
 #include <nsh/nsh_history.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static std::string read_entry(const nsh_history_t& hist, unsigned int entry)
+{
+    char buffer[NSH_LINE_BUFFER_SIZE] = {};
+    nsh_history_read_entry(&hist, entry, buffer);
+    return buffer;
+}
+
+// Distinct entries of a fixed size, since consecutive duplicates are not memorized
+static std::string numbered_entry(const char* prefix, unsigned int number)
+{
+    std::string number_str = std::to_string(number);
+    return prefix + std::string(4 - number_str.size(), '0') + number_str;
+}
+
+// Number of entries of the given size fitting in the history
+static unsigned int entries_per_history(unsigned int entry_size)
+{
+    return NSH_CMD_HISTORY_SIZE / (entry_size + NSH_HISTORY_ENTRY_OVERHEAD);
+}
+
 TEST(NshHistoryReset, Success)
 {
     nsh_history_t hist;
@@ -10,7 +34,8 @@ TEST(NshHistoryReset, Success)
 
     ASSERT_EQ(hist.head, 0);
     ASSERT_EQ(hist.tail, 0);
-    ASSERT_EQ(hist.size, 0);
+    ASSERT_EQ(hist.wrap, 0);
+    ASSERT_EQ(hist.count, 0);
 }
 
 TEST(NshHistoryAddEntry, SuccessOneElement)
@@ -21,10 +46,10 @@ TEST(NshHistoryAddEntry, SuccessOneElement)
     const char new_entry[] = "new_entry";
     nsh_history_add_entry(&hist, new_entry);
 
-    ASSERT_EQ(hist.size, 1);
-    ASSERT_EQ(hist.head, 1);
+    ASSERT_EQ(hist.count, 1);
+    ASSERT_EQ(hist.head, sizeof(new_entry) - 1 + NSH_HISTORY_ENTRY_OVERHEAD);
     ASSERT_EQ(hist.tail, 0);
-    ASSERT_STREQ(hist.entries[0], new_entry);
+    ASSERT_EQ(read_entry(hist, 0), new_entry);
 }
 
 TEST(NshHistoryAddEntry, SuccessTwoElement)
@@ -37,11 +62,26 @@ TEST(NshHistoryAddEntry, SuccessTwoElement)
     nsh_history_add_entry(&hist, new_entry1);
     nsh_history_add_entry(&hist, new_entry2);
 
-    ASSERT_EQ(hist.size, 2);
-    ASSERT_EQ(hist.head, 2);
+    const unsigned int record_size = sizeof(new_entry1) - 1 + NSH_HISTORY_ENTRY_OVERHEAD;
+    ASSERT_EQ(hist.count, 2);
+    ASSERT_EQ(hist.head, 2 * record_size);
     ASSERT_EQ(hist.tail, 0);
-    ASSERT_STREQ(hist.entries[0], new_entry1);
-    ASSERT_STREQ(hist.entries[1], new_entry2);
+    ASSERT_EQ(read_entry(hist, 0), new_entry1);
+    ASSERT_EQ(read_entry(hist, record_size), new_entry2);
+}
+
+TEST(NshHistoryAddEntry, SuccessShortEntriesArePacked)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    for (unsigned int i = 0; i < entries_per_history(4); i++) {
+        nsh_history_add_entry(&hist, numbered_entry("", i).c_str());
+    }
+
+    // Far more entries than fixed slots of NSH_LINE_BUFFER_SIZE bytes would allow
+    ASSERT_EQ(nsh_history_entry_count(&hist), entries_per_history(4));
+    ASSERT_GT(nsh_history_entry_count(&hist), NSH_CMD_HISTORY_SIZE / NSH_LINE_BUFFER_SIZE);
 }
 
 TEST(NshHistoryAddEntry, SuccessWhenOverriding)
@@ -49,23 +89,79 @@ TEST(NshHistoryAddEntry, SuccessWhenOverriding)
     nsh_history_t hist;
     nsh_history_reset(&hist);
 
-    const char new_entry[] = "new_entry";
-    for (unsigned int i = 0; i < NSH_CMD_HISTORY_SIZE; i++) {
-        nsh_history_add_entry(&hist, new_entry);
+    const unsigned int capacity = entries_per_history(9);
+    for (unsigned int i = 0; i < capacity; i++) {
+        nsh_history_add_entry(&hist, numbered_entry("entry", i).c_str());
     }
 
-    ASSERT_EQ(hist.size, NSH_CMD_HISTORY_SIZE);
-    ASSERT_EQ(hist.head, 0);
+    ASSERT_EQ(hist.count, capacity);
     ASSERT_EQ(hist.tail, 0);
 
     const char entry_override[] = "overriden";
     nsh_history_add_entry(&hist, entry_override);
 
-    ASSERT_EQ(hist.size, NSH_CMD_HISTORY_SIZE);
-    ASSERT_EQ(hist.head, 1);
-    ASSERT_EQ(hist.tail, 1);
-    ASSERT_STREQ(hist.entries[0], entry_override);
-    ASSERT_STREQ(hist.entries[1], new_entry);
+    ASSERT_EQ(hist.count, capacity);
+    ASSERT_EQ(hist.head, sizeof(entry_override) - 1 + NSH_HISTORY_ENTRY_OVERHEAD);
+    ASSERT_EQ(hist.tail, hist.head);
+    ASSERT_EQ(read_entry(hist, 0), entry_override);
+    ASSERT_EQ(read_entry(hist, hist.tail), numbered_entry("entry", 1));
+}
+
+TEST(NshHistoryAddEntry, SuccessLongEntryEvictsSeveralEntries)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    const unsigned int capacity = entries_per_history(4);
+    for (unsigned int i = 0; i < capacity; i++) {
+        nsh_history_add_entry(&hist, numbered_entry("", i).c_str());
+    }
+
+    const std::string long_entry(NSH_LINE_BUFFER_SIZE - 1, 'a');
+    nsh_history_add_entry(&hist, long_entry.c_str());
+
+    const unsigned int evicted = (NSH_LINE_BUFFER_SIZE - 1 + NSH_HISTORY_ENTRY_OVERHEAD + (4 + NSH_HISTORY_ENTRY_OVERHEAD) - 1)
+        / (4 + NSH_HISTORY_ENTRY_OVERHEAD);
+    ASSERT_EQ(nsh_history_entry_count(&hist), capacity + 1 - evicted);
+    ASSERT_EQ(read_entry(hist, nsh_history_most_recent(&hist)), long_entry);
+}
+
+TEST(NshHistoryAddEntry, SuccessTooLongEntryIsTruncated)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    const std::string too_long_entry(NSH_LINE_BUFFER_SIZE + 10, 'a');
+    nsh_history_add_entry(&hist, too_long_entry.c_str());
+
+    ASSERT_EQ(read_entry(hist, 0), too_long_entry.substr(0, NSH_LINE_BUFFER_SIZE - 1));
+}
+
+TEST(NshHistoryAddEntry, SuccessConsecutiveDuplicateIgnored)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "help");
+    nsh_history_add_entry(&hist, "help");
+
+    ASSERT_EQ(nsh_history_entry_count(&hist), 1);
+
+    nsh_history_add_entry(&hist, "version");
+    nsh_history_add_entry(&hist, "help");
+
+    ASSERT_EQ(nsh_history_entry_count(&hist), 3);
+}
+
+TEST(NshHistoryAddEntry, SuccessPrefixOfPreviousNotDuplicate)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "help");
+    nsh_history_add_entry(&hist, "hel");
+
+    ASSERT_EQ(nsh_history_entry_count(&hist), 2);
 }
 
 TEST(NshHistoryEntryCount, SuccessAtInit)
@@ -81,12 +177,12 @@ TEST(NshHistoryEntryCount, SuccessWhenFull)
     nsh_history_t hist;
     nsh_history_reset(&hist);
 
-    const char new_entry[] = "new_entry";
-    for (unsigned int i = 0; i < NSH_CMD_HISTORY_SIZE; i++) {
-        nsh_history_add_entry(&hist, new_entry);
+    const unsigned int capacity = entries_per_history(9);
+    for (unsigned int i = 0; i < capacity; i++) {
+        nsh_history_add_entry(&hist, numbered_entry("entry", i).c_str());
     }
 
-    ASSERT_EQ(nsh_history_entry_count(&hist), NSH_CMD_HISTORY_SIZE);
+    ASSERT_EQ(nsh_history_entry_count(&hist), capacity);
 }
 
 TEST(NshHistoryEntryCount, SuccessWhenOverriding)
@@ -94,15 +190,15 @@ TEST(NshHistoryEntryCount, SuccessWhenOverriding)
     nsh_history_t hist;
     nsh_history_reset(&hist);
 
-    const char new_entry[] = "new_entry";
-    for (unsigned int i = 0; i < NSH_CMD_HISTORY_SIZE; i++) {
-        nsh_history_add_entry(&hist, new_entry);
+    const unsigned int capacity = entries_per_history(9);
+    for (unsigned int i = 0; i < capacity; i++) {
+        nsh_history_add_entry(&hist, numbered_entry("entry", i).c_str());
     }
 
     const char entry_override[] = "overriden";
     nsh_history_add_entry(&hist, entry_override);
 
-    ASSERT_EQ(nsh_history_entry_count(&hist), NSH_CMD_HISTORY_SIZE);
+    ASSERT_EQ(nsh_history_entry_count(&hist), capacity);
 }
 
 TEST(NshHistoryIsEmpty, SuccessEmpty)
@@ -124,6 +220,28 @@ TEST(NshHistoryIsEmpty, SuccessNotEmpty)
     ASSERT_EQ(nsh_history_is_empty(&hist), false);
 }
 
+TEST(NshHistoryIsFull, SuccessNotFull)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "new_entry");
+
+    ASSERT_EQ(nsh_history_is_full(&hist), false);
+}
+
+TEST(NshHistoryIsFull, SuccessFull)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    for (unsigned int i = 0; i < entries_per_history(4); i++) {
+        nsh_history_add_entry(&hist, numbered_entry("", i).c_str());
+    }
+
+    ASSERT_EQ(nsh_history_is_full(&hist), true);
+}
+
 TEST(NshHistoryGetEntry, SuccessFirstElement)
 {
     nsh_history_t hist;
@@ -144,19 +262,19 @@ TEST(NshHistoryGetEntry, SuccessWhenOverriding)
     nsh_history_t hist;
     nsh_history_reset(&hist);
 
-    const char new_entry[] = "new_entry";
-    for (unsigned int i = 0; i < NSH_CMD_HISTORY_SIZE; i++) {
-        nsh_history_add_entry(&hist, new_entry);
+    const unsigned int capacity = entries_per_history(9);
+    for (unsigned int i = 0; i < capacity; i++) {
+        nsh_history_add_entry(&hist, numbered_entry("entry", i).c_str());
     }
 
     const char entry_override[] = "overriden";
     nsh_history_add_entry(&hist, entry_override);
 
     char entry[NSH_LINE_BUFFER_SIZE] = {};
-    auto status = nsh_history_get_entry(&hist, 1, entry);
-
-    ASSERT_EQ(status, NSH_STATUS_OK);
-    ASSERT_STREQ(entry, new_entry);
+    ASSERT_EQ(nsh_history_get_entry(&hist, 0, entry), NSH_STATUS_OK);
+    ASSERT_STREQ(entry, entry_override);
+    ASSERT_EQ(nsh_history_get_entry(&hist, 1, entry), NSH_STATUS_OK);
+    ASSERT_EQ(entry, numbered_entry("entry", capacity - 1));
 }
 
 TEST(NshHistoryGetEntry, FailureInvalidNegativeAge)
@@ -179,4 +297,192 @@ TEST(NshHistoryGetEntry, FailureInvalidTooHighAge)
     auto status = nsh_history_get_entry(&hist, 1, entry);
 
     ASSERT_EQ(status, NSH_STATUS_WRONG_ARG);
-}
\ No newline at end of file
+}
+
+TEST(NshHistoryViewEntry, SuccessPointsIntoRing)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "help");
+    nsh_history_add_entry(&hist, "version");
+
+    unsigned int size = 0;
+    const char* entry = nsh_history_view_entry(&hist, nsh_history_most_recent(&hist), &size);
+
+    ASSERT_EQ(std::string(entry, size), "version");
+    ASSERT_GE(entry, hist.ring);
+    ASSERT_LT(entry + size, hist.ring + sizeof(hist.ring));
+}
+
+TEST(NshHistoryWalk, SuccessEmpty)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    ASSERT_EQ(nsh_history_most_recent(&hist), NSH_HISTORY_INVALID_ENTRY);
+    ASSERT_EQ(nsh_history_previous(&hist, NSH_HISTORY_INVALID_ENTRY), NSH_HISTORY_INVALID_ENTRY);
+    ASSERT_EQ(nsh_history_next(&hist, NSH_HISTORY_INVALID_ENTRY), NSH_HISTORY_INVALID_ENTRY);
+}
+
+TEST(NshHistoryWalk, SuccessBothDirectionsWhenWrapped)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    // Add entries of various sizes until the ring wraps several times
+    std::vector<std::string> added;
+    for (unsigned int i = 0; i < 3 * entries_per_history(8); i++) {
+        added.push_back(std::string(1 + i % 16, static_cast<char>('a' + i % 26)));
+        nsh_history_add_entry(&hist, added.back().c_str());
+    }
+    ASSERT_NE(hist.wrap, 0);
+
+    // Walk from the most recent entry to the oldest one
+    std::vector<std::string> walked;
+    unsigned int entry = nsh_history_most_recent(&hist);
+    unsigned int oldest = entry;
+    for (; entry != NSH_HISTORY_INVALID_ENTRY; entry = nsh_history_previous(&hist, entry)) {
+        walked.push_back(read_entry(hist, entry));
+        oldest = entry;
+    }
+    ASSERT_EQ(walked.size(), nsh_history_entry_count(&hist));
+    ASSERT_EQ(oldest, hist.tail);
+    ASSERT_TRUE(std::equal(walked.begin(), walked.end(), added.rbegin()));
+
+    // Walk back from the oldest entry to the most recent one
+    unsigned int count = 0;
+    for (entry = oldest; entry != NSH_HISTORY_INVALID_ENTRY; entry = nsh_history_next(&hist, entry)) {
+        ASSERT_EQ(read_entry(hist, entry), walked[walked.size() - 1 - count]);
+        count++;
+    }
+    ASSERT_EQ(count, walked.size());
+}
+
+TEST(NshHistoryFindPrefix, SuccessOnlyPrefixMatches)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "help");
+    nsh_history_add_entry(&hist, "version");
+    nsh_history_add_entry(&hist, "the help");
+    nsh_history_add_entry(&hist, "he");
+
+    auto first_match = nsh_history_find_prefix(&hist, "hel", 3, nsh_history_most_recent(&hist));
+    ASSERT_EQ(read_entry(hist, first_match), "help");
+    ASSERT_EQ(nsh_history_find_prefix(&hist, "hel", 3, nsh_history_previous(&hist, first_match)),
+        NSH_HISTORY_INVALID_ENTRY);
+}
+
+TEST(NshHistoryFindPrefix, SuccessEmptyPrefix)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "help");
+    nsh_history_add_entry(&hist, "version");
+
+    auto most_recent = nsh_history_most_recent(&hist);
+    ASSERT_EQ(nsh_history_find_prefix(&hist, "", 0, most_recent), most_recent);
+}
+
+TEST(NshHistoryFindPrefix, FailureEmpty)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    ASSERT_EQ(nsh_history_find_prefix(&hist, "he", 2, nsh_history_most_recent(&hist)), NSH_HISTORY_INVALID_ENTRY);
+}
+
+#if NSH_FEATURE_USE_HISTORY_SEARCH == 1
+
+TEST(NshHistorySignature, SuccessEmpty)
+{
+    ASSERT_EQ(nsh_history_signature("", 0), 0u);
+}
+
+TEST(NshHistorySignature, SuccessContainsPatternSignature)
+{
+    const char entry[] = "reg write 0x40";
+    const char pattern[] = "wr";
+
+    auto entry_signature = nsh_history_signature(entry, sizeof(entry) - 1);
+    auto pattern_signature = nsh_history_signature(pattern, sizeof(pattern) - 1);
+
+    ASSERT_EQ(entry_signature & pattern_signature, pattern_signature);
+}
+
+TEST(NshHistorySearch, SuccessMostRecentMatch)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "help");
+    nsh_history_add_entry(&hist, "version");
+    nsh_history_add_entry(&hist, "hello world");
+    nsh_history_add_entry(&hist, "exit");
+
+    auto most_recent = nsh_history_most_recent(&hist);
+    ASSERT_EQ(read_entry(hist, nsh_history_search(&hist, "he", 2, most_recent)), "hello world");
+    ASSERT_EQ(read_entry(hist, nsh_history_search(&hist, "ers", 3, most_recent)), "version");
+    ASSERT_EQ(read_entry(hist, nsh_history_search(&hist, "world", 5, most_recent)), "hello world");
+}
+
+TEST(NshHistorySearch, SuccessOlderMatch)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "help");
+    nsh_history_add_entry(&hist, "version");
+    nsh_history_add_entry(&hist, "hello world");
+
+    auto first_match = nsh_history_search(&hist, "he", 2, nsh_history_most_recent(&hist));
+    auto second_match = nsh_history_search(&hist, "he", 2, nsh_history_previous(&hist, first_match));
+
+    ASSERT_EQ(read_entry(hist, second_match), "help");
+}
+
+TEST(NshHistorySearch, SuccessEmptyPattern)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "help");
+
+    ASSERT_EQ(nsh_history_search(&hist, "", 0, nsh_history_most_recent(&hist)), nsh_history_most_recent(&hist));
+}
+
+TEST(NshHistorySearch, SuccessWhenOverriding)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    const unsigned int capacity = entries_per_history(8);
+    nsh_history_add_entry(&hist, "needle00");
+    for (unsigned int i = 0; i < capacity - 1; i++) {
+        nsh_history_add_entry(&hist, numbered_entry("hays", i).c_str());
+    }
+
+    ASSERT_EQ(nsh_history_search(&hist, "need", 4, nsh_history_most_recent(&hist)), 0u);
+
+    nsh_history_add_entry(&hist, "haystack");
+
+    ASSERT_EQ(nsh_history_search(&hist, "need", 4, nsh_history_most_recent(&hist)), NSH_HISTORY_INVALID_ENTRY);
+}
+
+TEST(NshHistorySearch, FailureNoMatch)
+{
+    nsh_history_t hist;
+    nsh_history_reset(&hist);
+
+    nsh_history_add_entry(&hist, "help");
+    nsh_history_add_entry(&hist, "version");
+
+    auto most_recent = nsh_history_most_recent(&hist);
+    ASSERT_EQ(nsh_history_search(&hist, "exit", 4, most_recent), NSH_HISTORY_INVALID_ENTRY);
+    ASSERT_EQ(nsh_history_search(&hist, "plh", 3, most_recent), NSH_HISTORY_INVALID_ENTRY);
+}
+
+#endif // NSH_FEATURE_USE_HISTORY_SEARCH == 1
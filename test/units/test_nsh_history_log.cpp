@@ -0,0 +1,328 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh_history_log.h>
+
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Storage emulating a Flash memory: erased bytes read as 0xFF and the capacity is limited
+struct MemoryStorage {
+    std::vector<unsigned char> data;
+    unsigned int capacity;
+    unsigned int written = 0;
+    unsigned int rotations = 0;
+    nsh_history_storage_t storage;
+
+    explicit MemoryStorage(unsigned int capacity_)
+        : data(capacity_, 0xFF)
+        , capacity(capacity_)
+        , storage { &MemoryStorage::read, &MemoryStorage::append, &MemoryStorage::rotate, this }
+    {
+    }
+
+    static unsigned int read(void* ctx, unsigned int offset, void* buffer, unsigned int size)
+    {
+        auto* self = static_cast<MemoryStorage*>(ctx);
+        if (offset >= self->capacity) {
+            return 0;
+        }
+        size = std::min(size, self->capacity - offset);
+        std::copy_n(self->data.begin() + offset, size, static_cast<unsigned char*>(buffer));
+        return size;
+    }
+
+    static nsh_status_t append(void* ctx, const void* buffer, unsigned int size)
+    {
+        auto* self = static_cast<MemoryStorage*>(ctx);
+        if (self->written + size > self->capacity) {
+            return NSH_STATUS_BUFFER_OVERFLOW;
+        }
+        std::copy_n(static_cast<const unsigned char*>(buffer), size, self->data.begin() + self->written);
+        self->written += size;
+        return NSH_STATUS_OK;
+    }
+
+    static nsh_status_t rotate(void* ctx)
+    {
+        auto* self = static_cast<MemoryStorage*>(ctx);
+        std::fill(self->data.begin(), self->data.end(), 0xFF);
+        self->written = 0;
+        self->rotations++;
+        return NSH_STATUS_OK;
+    }
+};
+
+std::vector<std::string> history_entries(const nsh_history_t& hist)
+{
+    std::vector<std::string> entries;
+    for (auto entry = nsh_history_oldest(&hist); entry != NSH_HISTORY_INVALID_ENTRY; entry = nsh_history_next(&hist, entry)) {
+        unsigned int size = 0;
+        const char* chars = nsh_history_view_entry(&hist, entry, &size);
+        entries.emplace_back(chars, size);
+    }
+    return entries;
+}
+
+} // namespace
+
+TEST(NshHistoryLogCrc16, SuccessCheckValue)
+{
+    // Check value of CRC-16/CCITT-FALSE
+    ASSERT_EQ(nsh_history_log_crc16(0xFFFF, "123456789", 9), 0x29B1);
+}
+
+TEST(NshHistoryLogFlush, SuccessOnlyPendingEntriesWritten)
+{
+    MemoryStorage storage(1024);
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, &storage.storage);
+
+    nsh_history_log_add_entry(&log, &hist, "help");
+    nsh_history_log_add_entry(&log, &hist, "version");
+    ASSERT_EQ(log.pending, 2);
+    ASSERT_EQ(storage.written, 0);
+
+    ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+    ASSERT_EQ(log.pending, 0);
+    ASSERT_EQ(storage.written, 2 * NSH_HISTORY_LOG_RECORD_HEADER_SIZE + 4 + 7);
+
+    nsh_history_log_add_entry(&log, &hist, "exit");
+    ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+    ASSERT_EQ(storage.written, 3 * NSH_HISTORY_LOG_RECORD_HEADER_SIZE + 4 + 7 + 4);
+}
+
+TEST(NshHistoryLogAddEntry, SuccessDuplicateNotPending)
+{
+    MemoryStorage storage(1024);
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, &storage.storage);
+
+    nsh_history_log_add_entry(&log, &hist, "help");
+    nsh_history_log_add_entry(&log, &hist, "help");
+
+    ASSERT_EQ(log.pending, 1);
+}
+
+TEST(NshHistoryLogIsBatchComplete, Success)
+{
+    MemoryStorage storage(1024);
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, &storage.storage);
+
+    for (unsigned int i = 0; i < NSH_HISTORY_LOG_BATCH_SIZE; i++) {
+        ASSERT_FALSE(nsh_history_log_is_batch_complete(&log));
+        nsh_history_log_add_entry(&log, &hist, std::to_string(i).c_str());
+    }
+
+    ASSERT_TRUE(nsh_history_log_is_batch_complete(&log));
+}
+
+TEST(NshHistoryLogLoad, SuccessReplayInOrder)
+{
+    MemoryStorage storage(1024);
+    {
+        nsh_history_t hist;
+        nsh_history_log_t log;
+        nsh_history_reset(&hist);
+        nsh_history_log_init(&log, &storage.storage);
+        nsh_history_log_add_entry(&log, &hist, "help");
+        nsh_history_log_add_entry(&log, &hist, "version");
+        nsh_history_log_add_entry(&log, &hist, "reg write 0x40 1");
+        ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+    }
+
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, &storage.storage);
+
+    ASSERT_EQ(nsh_history_log_load(&log, &hist), NSH_STATUS_OK);
+    ASSERT_THAT(history_entries(hist), testing::ElementsAre("help", "version", "reg write 0x40 1"));
+    ASSERT_EQ(log.pending, 0);
+    ASSERT_EQ(storage.rotations, 0);
+}
+
+TEST(NshHistoryLogLoad, SuccessEmptyStorage)
+{
+    MemoryStorage storage(1024);
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, &storage.storage);
+
+    ASSERT_EQ(nsh_history_log_load(&log, &hist), NSH_STATUS_OK);
+    ASSERT_TRUE(nsh_history_is_empty(&hist));
+}
+
+TEST(NshHistoryLogLoad, SuccessCorruptedRecordDiscarded)
+{
+    MemoryStorage storage(1024);
+    {
+        nsh_history_t hist;
+        nsh_history_log_t log;
+        nsh_history_reset(&hist);
+        nsh_history_log_init(&log, &storage.storage);
+        nsh_history_log_add_entry(&log, &hist, "help");
+        nsh_history_log_add_entry(&log, &hist, "version");
+        ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+    }
+    // Corrupt the last character of "version"
+    storage.data[storage.written - 1] = 'X';
+
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, &storage.storage);
+
+    ASSERT_EQ(nsh_history_log_load(&log, &hist), NSH_STATUS_OK);
+    ASSERT_THAT(history_entries(hist), testing::ElementsAre("help"));
+    // The log has been rewritten without the corrupted record
+    ASSERT_EQ(storage.rotations, 1);
+    ASSERT_EQ(storage.written, NSH_HISTORY_LOG_RECORD_HEADER_SIZE + 4);
+}
+
+TEST(NshHistoryLogFlush, SuccessRotateWhenFull)
+{
+    MemoryStorage storage(64);
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, &storage.storage);
+
+    // 12 bytes per record, the sixth one does not fit
+    for (unsigned int i = 0; i < 5; i++) {
+        nsh_history_log_add_entry(&log, &hist, ("cmd" + std::to_string(i) + "abcd").c_str());
+        ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+    }
+    ASSERT_EQ(storage.rotations, 0);
+
+    nsh_history_reset(&hist);
+    nsh_history_log_add_entry(&log, &hist, "cmd5abcd");
+    ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+
+    // The log now only contains the history content
+    ASSERT_EQ(storage.rotations, 1);
+    ASSERT_EQ(storage.written, NSH_HISTORY_LOG_RECORD_HEADER_SIZE + 8);
+
+    nsh_history_t restored;
+    nsh_history_reset(&restored);
+    ASSERT_EQ(nsh_history_log_load(&log, &restored), NSH_STATUS_OK);
+    ASSERT_THAT(history_entries(restored), testing::ElementsAre("cmd5abcd"));
+}
+
+TEST(NshHistoryLogFlush, SuccessNoStorage)
+{
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, nullptr);
+
+    nsh_history_log_add_entry(&log, &hist, "help");
+
+    ASSERT_EQ(log.pending, 0);
+    ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+    ASSERT_EQ(nsh_history_log_load(&log, &hist), NSH_STATUS_OK);
+}
+
+#if !defined(GTEST_HAS_FILE_SYSTEM) || GTEST_HAS_FILE_SYSTEM
+
+TEST(NshHistoryFileStorage, SuccessPersistAcrossReopening)
+{
+    const std::string path = testing::TempDir() + "nsh_history_file_storage_test.log";
+    std::remove(path.c_str());
+
+    {
+        nsh_history_storage_t storage;
+        nsh_history_file_t file;
+        ASSERT_EQ(nsh_history_file_storage_init(&storage, &file, path.c_str()), NSH_STATUS_OK);
+
+        nsh_history_t hist;
+        nsh_history_log_t log;
+        nsh_history_reset(&hist);
+        nsh_history_log_init(&log, &storage);
+        nsh_history_log_add_entry(&log, &hist, "help");
+        nsh_history_log_add_entry(&log, &hist, "version");
+        ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+
+        // Rotation truncates the file and keeps it usable
+        ASSERT_EQ(storage.rotate(storage.ctx), NSH_STATUS_OK);
+        nsh_history_log_add_entry(&log, &hist, "exit");
+        ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+
+        nsh_history_file_storage_close(&file);
+    }
+
+    nsh_history_storage_t storage;
+    nsh_history_file_t file;
+    ASSERT_EQ(nsh_history_file_storage_init(&storage, &file, path.c_str()), NSH_STATUS_OK);
+
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, &storage);
+    ASSERT_EQ(nsh_history_log_load(&log, &hist), NSH_STATUS_OK);
+    ASSERT_THAT(history_entries(hist), testing::ElementsAre("exit"));
+
+    nsh_history_file_storage_close(&file);
+    std::remove(path.c_str());
+}
+
+TEST(NshHistoryFileStorage, FailureRotateKeepsFile)
+{
+    const std::string path = testing::TempDir() + "nsh_history_file_storage_rotate_test.log";
+    std::remove(path.c_str());
+    nsh_history_storage_t storage;
+    nsh_history_file_t file;
+    ASSERT_EQ(nsh_history_file_storage_init(&storage, &file, path.c_str()), NSH_STATUS_OK);
+    nsh_history_t hist;
+    nsh_history_log_t log;
+    nsh_history_reset(&hist);
+    nsh_history_log_init(&log, &storage);
+    nsh_history_log_add_entry(&log, &hist, "help");
+    ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+
+    // The file cannot be created again, as if its directory had been removed
+    file.path = "/nonexistent-directory/history.log";
+    ASSERT_EQ(storage.rotate(storage.ctx), NSH_STATUS_FAILURE);
+
+    // The current file is still written and read
+    nsh_history_log_add_entry(&log, &hist, "version");
+    ASSERT_EQ(nsh_history_log_flush(&log, &hist), NSH_STATUS_OK);
+    nsh_history_reset(&hist);
+    ASSERT_EQ(nsh_history_log_load(&log, &hist), NSH_STATUS_OK);
+    ASSERT_THAT(history_entries(hist), testing::ElementsAre("help", "version"));
+
+    nsh_history_file_storage_close(&file);
+    std::remove(path.c_str());
+}
+
+TEST(NshHistoryFileStorage, FailureClosedFile)
+{
+    const std::string path = testing::TempDir() + "nsh_history_file_storage_closed_test.log";
+    nsh_history_storage_t storage;
+    nsh_history_file_t file;
+    ASSERT_EQ(nsh_history_file_storage_init(&storage, &file, path.c_str()), NSH_STATUS_OK);
+    nsh_history_file_storage_close(&file);
+
+    char data[4];
+    ASSERT_EQ(storage.read(storage.ctx, 0, data, sizeof(data)), 0u);
+    ASSERT_EQ(storage.append(storage.ctx, "data", 4), NSH_STATUS_FAILURE);
+    std::remove(path.c_str());
+}
+
+#endif // GTEST_HAS_FILE_SYSTEM
+
+#endif // NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
@@ -0,0 +1,218 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_io_memory.h>
+
+#include "nsh_test_shell.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if GTEST_HAS_PTHREAD
+#include <thread>
+#endif
+
+using testing::HasSubstr;
+using testing::Not;
+
+namespace {
+
+nsh_status_t cmd_print_args(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    for (unsigned int i = 1; i < argc; i++) {
+        nsh_io_put_string(ctx->io, argv[i]);
+    }
+    return NSH_STATUS_OK;
+}
+
+// Shell with a 'print' command
+nsh_t print_shell()
+{
+    nsh_status_t status;
+    nsh_t nsh = nsh_init(&status);
+    nsh_register_command(&nsh, "print", cmd_print_args);
+    return nsh;
+}
+
+} // namespace
+
+TEST(NshIoMemory, SuccessReadUntilExhausted)
+{
+    nsh_io_memory_t mem;
+    nsh_io_memory_init(&mem, "ab", 2, nullptr, 0);
+    nsh_io_t io;
+    nsh_io_init(&io, &nsh_io_memory_backend, &mem);
+
+    ASSERT_EQ(nsh_io_get_char(&io), 'a');
+    ASSERT_EQ(nsh_io_get_char(&io), 'b');
+    ASSERT_EQ(nsh_io_get_char(&io), NSH_IO_EOT);
+    ASSERT_EQ(nsh_io_get_char(&io), NSH_IO_EOT);
+}
+
+TEST(NshIoMemory, SuccessOutputCountedWhenDropped)
+{
+    char output[4];
+    nsh_io_memory_t mem;
+    nsh_io_memory_init(&mem, "", 0, output, sizeof(output));
+
+    nsh_io_memory_backend.write(&mem, "abcdef", 6);
+
+    ASSERT_EQ(mem.output_size, 6u);
+    ASSERT_EQ(std::string(output, sizeof(output)), "abcd");
+}
+
+TEST(NshIoOutput, SuccessBufferedUntilFlush)
+{
+    char output[16];
+    nsh_io_memory_t mem;
+    nsh_io_memory_init(&mem, "x", 1, output, sizeof(output));
+    nsh_io_t io;
+    nsh_io_init(&io, &nsh_io_memory_backend, &mem);
+
+    nsh_io_put_string(&io, "abc");
+    ASSERT_EQ(mem.output_size, 0u);
+
+    // Waiting for input flushes the output first
+    nsh_io_get_char(&io);
+    ASSERT_EQ(std::string(output, mem.output_size), "abc");
+}
+
+TEST(NshIoOutput, SuccessLongerThanBuffer)
+{
+    std::string expected(3 * NSH_IO_OUTPUT_BUFFER_SIZE + 1, 'a');
+    std::vector<char> output(expected.size());
+    nsh_io_memory_t mem;
+    nsh_io_memory_init(&mem, "", 0, output.data(), static_cast<unsigned int>(output.size()));
+    nsh_io_t io;
+    nsh_io_init(&io, &nsh_io_memory_backend, &mem);
+
+    nsh_io_put_string(&io, expected.c_str());
+    nsh_io_flush(&io);
+
+    ASSERT_EQ(std::string(output.data(), mem.output_size), expected);
+}
+
+#if NSH_FEATURE_USE_PRINTF == 1
+
+TEST(NshIoOutput, SuccessPrintfFlushesWhenNotFitting)
+{
+    std::vector<char> output(2 * NSH_IO_OUTPUT_BUFFER_SIZE);
+    nsh_io_memory_t mem;
+    nsh_io_memory_init(&mem, "", 0, output.data(), static_cast<unsigned int>(output.size()));
+    nsh_io_t io;
+    nsh_io_init(&io, &nsh_io_memory_backend, &mem);
+
+    std::string filler(NSH_IO_OUTPUT_BUFFER_SIZE - 2, '-');
+    nsh_io_put_string(&io, filler.c_str());
+    ASSERT_EQ(nsh_io_printf(&io, "%d", 1234), 4);
+    nsh_io_flush(&io);
+
+    ASSERT_EQ(std::string(output.data(), mem.output_size), filler + "1234");
+}
+
+TEST(NshIoOutput, SuccessPrintfStreamsLongOutput)
+{
+    std::vector<char> output(8 * NSH_IO_OUTPUT_BUFFER_SIZE);
+    nsh_io_memory_t mem;
+    nsh_io_memory_init(&mem, "", 0, output.data(), static_cast<unsigned int>(output.size()));
+    nsh_io_t io;
+    nsh_io_init(&io, &nsh_io_memory_backend, &mem);
+
+    std::string text(2 * NSH_IO_OUTPUT_BUFFER_SIZE, 'a');
+    std::string expected = "[" + text + "] 42 -7 0x1f 2.50 c %     ab|x   |  0042";
+    ASSERT_EQ(nsh_io_printf(&io, "[%s] %u %ld %#x %.2f %c %% %*.*s|%-4s|%6.4lld", text.c_str(), 42u, -7L, 31u, 2.5,
+                  'c', 6, 2, "abc", "x", 42LL),
+        static_cast<int>(expected.size()));
+    nsh_io_flush(&io);
+
+    ASSERT_EQ(std::string(output.data(), mem.output_size), expected);
+}
+
+#endif
+
+TEST(NshRun, SuccessMemoryIo)
+{
+    nsh_t nsh = print_shell();
+
+    auto written = nsh_test::run(nsh, "print hello\nexit\n");
+
+    ASSERT_THAT(written, HasSubstr("\r\nhello"));
+    ASSERT_THAT(written, HasSubstr("exit"));
+}
+
+TEST(NshRun, SuccessQuitWhenInputExhausted)
+{
+    nsh_t nsh = print_shell();
+
+    ASSERT_THAT(nsh_test::run(nsh, "print hello\n"), HasSubstr("hello"));
+}
+
+TEST(NshRun, SuccessOwnPrompt)
+{
+    std::string script = "print a\n";
+    char output[256];
+    nsh_io_memory_t mem;
+    nsh_io_memory_init(&mem, script.data(), static_cast<unsigned int>(script.size()), output, sizeof(output));
+    nsh_t shell1 = print_shell();
+    nsh_t shell2 = print_shell();
+    // Replacing the backend resets the prompt, so the prompt is set once the backend is in place
+    nsh_set_io(&shell2, &nsh_io_memory_backend, &mem);
+    nsh_set_prompt(&shell2, "shell2$ ");
+
+    ASSERT_THAT(nsh_test::run(shell1, script), Not(HasSubstr("shell2$ ")));
+    nsh_run(&shell2);
+    ASSERT_THAT(std::string(output, mem.output_size), HasSubstr("shell2$ "));
+}
+
+TEST(NshRun, SuccessInitInplace)
+{
+    static nsh_t nsh;
+    std::memset(&nsh, 0xA5, sizeof(nsh)); // Previous content shall not matter
+
+    ASSERT_EQ(nsh_init_inplace(&nsh), NSH_STATUS_OK);
+    nsh_register_command(&nsh, "print", cmd_print_args);
+    auto written = nsh_test::run(nsh, "print hello\nversion\n");
+
+    ASSERT_THAT(written, HasSubstr("\r\nhello"));
+    ASSERT_THAT(written, Not(HasSubstr("not found")));
+}
+
+#if GTEST_HAS_PTHREAD
+
+TEST(NshRun, SuccessConcurrentInstances)
+{
+    std::string script;
+    for (int i = 0; i < 200; i++) {
+        script += "print " + std::to_string(i) + "\n";
+    }
+    script += "exit\n";
+
+    constexpr std::size_t output_capacity = 64 * 1024;
+    nsh_t reference_shell = print_shell();
+    std::string reference = nsh_test::run(reference_shell, script, output_capacity);
+    ASSERT_LT(reference.size(), output_capacity);
+
+    // Each instance shall produce the same output as if it were alone
+    std::vector<std::unique_ptr<nsh_t>> shells;
+    std::vector<std::string> outputs(4);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < outputs.size(); i++) {
+        shells.push_back(std::make_unique<nsh_t>(print_shell()));
+    }
+    for (std::size_t i = 0; i < outputs.size(); i++) {
+        threads.emplace_back([&, i] { outputs[i] = nsh_test::run(*shells[i], script, output_capacity); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& output : outputs) {
+        ASSERT_EQ(output, reference);
+    }
+}
+
+#endif // GTEST_HAS_PTHREAD
@@ -0,0 +1,193 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_io_dma.h>
+
+#include <string>
+
+using testing::HasSubstr;
+
+namespace {
+
+/*
+ * Simulated UART and DMA: a transfer completes, or the next input bytes are
+ * received, when the CPU waits for an interrupt.
+ */
+class MockDmaUart {
+public:
+    explicit MockDmaUart(nsh_io_dma_t* dma)
+        : m_dma(dma)
+    {
+        driver.start_tx = start_tx;
+        driver.idle = idle;
+        driver.ctx = this;
+        nsh_io_dma_init(dma, &driver);
+    }
+
+    // Complete the transfer in progress, as the DMA interrupt would do
+    void complete_tx()
+    {
+        wire += pending;
+        pending.clear();
+        transferring = false;
+        nsh_io_dma_tx_complete(m_dma);
+    }
+
+    // Receive 'data' into the circular DMA buffer, up to the next idle line
+    void receive(const std::string& data)
+    {
+        for (char c : data) {
+            rx_buffer[rx_write_position] = c;
+            rx_write_position = (rx_write_position + 1) % sizeof(rx_buffer);
+            if (rx_write_position == 0) {
+                // DMA transfer complete interrupt
+                nsh_io_dma_rx_update(m_dma, rx_buffer, sizeof(rx_buffer), sizeof(rx_buffer));
+            }
+        }
+        // Idle line interrupt
+        nsh_io_dma_rx_update(m_dma, rx_buffer, sizeof(rx_buffer), rx_write_position);
+    }
+
+    nsh_io_dma_driver_t driver;
+    std::string wire;    ///< Bytes transmitted
+    std::string pending; ///< Bytes being transmitted
+    bool transferring = false;
+    bool overlapping_transfers = false;
+    unsigned int idle_count = 0;
+    std::string input; ///< Bytes received one line per idle
+    char rx_buffer[16];
+    unsigned int rx_write_position = 0;
+
+private:
+    static void start_tx(void* ctx, const char* data, unsigned int size)
+    {
+        auto* uart = static_cast<MockDmaUart*>(ctx);
+        uart->overlapping_transfers = uart->overlapping_transfers || uart->transferring;
+        uart->pending.assign(data, size);
+        uart->transferring = true;
+    }
+
+    static void idle(void* ctx)
+    {
+        auto* uart = static_cast<MockDmaUart*>(ctx);
+        uart->idle_count++;
+        if (uart->transferring) {
+            uart->complete_tx();
+        } else if (!uart->input.empty()) {
+            std::size_t line_size = uart->input.find('\n');
+            line_size = (line_size == std::string::npos) ? uart->input.size() : line_size + 1;
+            uart->receive(uart->input.substr(0, line_size));
+            uart->input.erase(0, line_size);
+        }
+    }
+
+    nsh_io_dma_t* m_dma;
+};
+
+class NshIoDma : public testing::Test {
+protected:
+    void write(const std::string& data)
+    {
+        nsh_io_dma_backend.write(&dma, data.data(), static_cast<unsigned int>(data.size()));
+    }
+
+    nsh_io_dma_t dma;
+    MockDmaUart uart { &dma };
+};
+
+} // namespace
+
+TEST_F(NshIoDma, SuccessWriteStartsTransfer)
+{
+    write("hello");
+
+    ASSERT_TRUE(uart.transferring);
+    ASSERT_EQ(uart.pending, "hello");
+    ASSERT_EQ(uart.idle_count, 0u);
+}
+
+TEST_F(NshIoDma, SuccessWriteWhileTransferring)
+{
+    write("hello");
+    write(" world");
+
+    // The second write is buffered until the first transfer completes
+    ASSERT_EQ(uart.pending, "hello");
+    ASSERT_EQ(dma.tx_count, 1u);
+
+    nsh_io_dma_flush(&dma);
+
+    ASSERT_EQ(uart.wire, "hello world");
+    ASSERT_FALSE(uart.overlapping_transfers);
+}
+
+TEST_F(NshIoDma, SuccessLargeWriteDoubleBuffered)
+{
+    std::string data;
+    for (unsigned int i = 0; i < 1024; i++) {
+        data += static_cast<char>('a' + i % 26);
+    }
+
+    write(data);
+    nsh_io_dma_flush(&dma);
+
+    ASSERT_EQ(uart.wire, data);
+    ASSERT_FALSE(uart.overlapping_transfers);
+    // One transfer per full buffer, and the CPU only waits for the transfers
+    ASSERT_EQ(dma.tx_count, 1024u / NSH_IO_DMA_TX_BUFFER_SIZE);
+    ASSERT_LE(uart.idle_count, dma.tx_count);
+}
+
+TEST_F(NshIoDma, SuccessReceiveWrapAround)
+{
+    std::string data = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+    uart.receive(data.substr(0, 10));
+    uart.receive(data.substr(10));
+
+    char received[64];
+    unsigned int size = nsh_rx_ring_pop(&dma.rx, received, sizeof(received));
+    ASSERT_EQ(std::string(received, size), data);
+}
+
+TEST_F(NshIoDma, SuccessReadWaitsForInput)
+{
+    uart.input = "ab";
+
+    ASSERT_EQ(nsh_io_dma_backend.read(&dma), 'a');
+    ASSERT_EQ(nsh_io_dma_backend.read(&dma), 'b');
+    ASSERT_EQ(uart.idle_count, 1u);
+}
+
+TEST_F(NshIoDma, SuccessRunShell)
+{
+    uart.input = "help\nexit\n";
+    nsh_status_t status;
+    nsh_t nsh = nsh_init(&status);
+    nsh_set_io(&nsh, &nsh_io_dma_backend, &dma);
+
+    nsh_run(&nsh);
+    nsh_io_dma_flush(&dma);
+
+    ASSERT_THAT(uart.wire, HasSubstr("help\r\n"));
+    ASSERT_THAT(uart.wire, HasSubstr("This is an helpful help message !"));
+    ASSERT_FALSE(uart.overlapping_transfers);
+}
+
+TEST_F(NshIoDma, SuccessInterruptOnCtrlC)
+{
+    unsigned int interrupts = 0;
+    nsh_io_dma_set_interrupt_handler(
+        &dma, [](void* ctx) { (*static_cast<unsigned int*>(ctx))++; }, &interrupts);
+
+    uart.receive("ab");
+    ASSERT_EQ(interrupts, 0u);
+    uart.receive("\x03" "c");
+    ASSERT_EQ(interrupts, 1u);
+
+    // The Ctrl-C is still read by the shell
+    char received[8];
+    ASSERT_EQ(nsh_rx_ring_pop(&dma.rx, received, sizeof(received)), 4u);
+    ASSERT_EQ(received[2], NSH_IO_ETX);
+}
@@ -0,0 +1,161 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_JOBS == 1 && GTEST_HAS_PTHREAD
+
+#include <nsh/nsh_executor_posix.h>
+#include <nsh/nsh_interrupt_posix.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using testing::HasSubstr;
+
+namespace {
+
+nsh_status_t cmd_print(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    for (unsigned int i = 1; i < argc; i++) {
+        nsh_io_put_string(ctx->io, argv[i]);
+    }
+    return NSH_STATUS_OK;
+}
+
+nsh_status_t cmd_spin(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    while (!nsh_cmd_is_cancelled(ctx)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    nsh_io_put_string(ctx->io, "cancelled");
+    return NSH_STATUS_FAILURE;
+}
+
+// Shell running a script from memory, with a pool of workers for the background jobs
+class NshJob : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(nsh_posix_executor_init(&pool), NSH_STATUS_OK);
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+        nsh_register_command(&nsh, "print", cmd_print);
+        nsh_register_command(&nsh, "spin", cmd_spin);
+        nsh_set_executor(&nsh, &pool.executor);
+    }
+
+    void TearDown() override
+    {
+        nsh_posix_executor_destroy(&pool);
+    }
+
+    std::string run(const std::string& script) { return nsh_test::run(nsh, script); }
+
+    nsh_posix_executor_t pool;
+    nsh_t nsh;
+};
+
+} // namespace
+
+TEST_F(NshJob, SuccessRunInBackground)
+{
+    auto output = run("print hello &\nfg\n");
+
+    ASSERT_THAT(output, HasSubstr("[1]\r\n"));
+    ASSERT_THAT(output, HasSubstr("hello"));
+    ASSERT_THAT(output, HasSubstr("[1] Done print"));
+}
+
+TEST_F(NshJob, SuccessOperatorAttachedToLastArgument)
+{
+    auto output = run("print hello&\nfg\n");
+
+    ASSERT_THAT(output, HasSubstr("hello\r\n"));
+    ASSERT_THAT(output, HasSubstr("[1] Done print"));
+}
+
+TEST_F(NshJob, SuccessKill)
+{
+    auto output = run("spin &\nkill 1\nfg %1\n");
+
+    ASSERT_THAT(output, HasSubstr("cancelled"));
+    ASSERT_THAT(output, HasSubstr("[1] Exit " + std::to_string(NSH_STATUS_FAILURE) + " spin"));
+}
+
+TEST_F(NshJob, SuccessForegroundTimedOut)
+{
+    nsh_set_clock(&nsh, nsh_posix_clock_ms);
+    nsh_set_command_timeout(&nsh, 100);
+
+    auto output = run("spin &\nfg\njobs\n");
+
+    // The job is left running in the background
+    ASSERT_THAT(output, HasSubstr("ERROR: command 'fg' timed out"));
+    ASSERT_THAT(output, HasSubstr("[1] Running spin"));
+}
+
+TEST_F(NshJob, SuccessList)
+{
+    auto output = run("spin &\nspin &\njobs\n");
+
+    ASSERT_THAT(output, HasSubstr("[1] Running spin"));
+    ASSERT_THAT(output, HasSubstr("[2] Running spin"));
+}
+
+TEST_F(NshJob, SuccessCancelledOnExit)
+{
+    auto output = run("spin &\nexit\n");
+
+    ASSERT_THAT(output, HasSubstr("[1] Exit " + std::to_string(NSH_STATUS_FAILURE) + " spin"));
+}
+
+TEST_F(NshJob, FailureTooManyJobs)
+{
+    std::string script;
+    for (unsigned int i = 0; i < NSH_JOB_MAX_COUNT + 1; i++) {
+        script += "spin &\n";
+    }
+
+    auto output = run(script);
+
+    ASSERT_THAT(output, HasSubstr("ERROR: cannot start more background jobs"));
+}
+
+TEST_F(NshJob, FailureTooManyArguments)
+{
+    // Possible with runtime limits above NSH_CMD_ARGS_MAX_COUNT
+    std::vector<std::string> args(NSH_CMD_ARGS_MAX_COUNT + 1, "arg");
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(arg.data());
+    }
+    unsigned int id;
+
+    ASSERT_EQ(nsh_job_start(&nsh.jobs, &nsh, cmd_print, static_cast<unsigned int>(argv.size()), argv.data(), &id),
+        NSH_STATUS_MAX_ARGS_NB_REACH);
+    ASSERT_THAT(run("jobs\n"), testing::Not(HasSubstr("print")));
+}
+
+TEST_F(NshJob, FailureNoSuchJob)
+{
+    auto output = run("kill 3\nfg\n");
+
+    ASSERT_THAT(output, HasSubstr("no such job"));
+    ASSERT_THAT(output, HasSubstr("no current job"));
+}
+
+TEST(NshJobNoExecutor, FailureUnsupported)
+{
+    nsh_status_t status;
+    nsh_t nsh = nsh_init(&status);
+    nsh_register_command(&nsh, "print", cmd_print);
+
+    ASSERT_THAT(nsh_test::run(nsh, "print hello &\n"), HasSubstr("ERROR: no executor for background jobs"));
+}
+
+#endif // NSH_FEATURE_USE_JOBS == 1 && GTEST_HAS_PTHREAD
@@ -0,0 +1,236 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+
+#include <nsh/nsh_io_memory.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if GTEST_HAS_PTHREAD
+#include <thread>
+#endif
+
+using testing::HasSubstr;
+
+namespace {
+
+class NshLogQueue : public testing::Test {
+protected:
+    void SetUp() override { nsh_log_queue_init(&queue); }
+
+    bool push(const std::string& message)
+    {
+        return nsh_log_queue_push(&queue, message.data(), static_cast<unsigned int>(message.size()));
+    }
+
+    std::string pop()
+    {
+        char message[NSH_LOG_MESSAGE_SIZE];
+        unsigned int size = 0;
+        if (!nsh_log_queue_pop(&queue, message, &size)) {
+            return "<empty>";
+        }
+        return std::string(message, size);
+    }
+
+    nsh_log_queue_t queue;
+};
+
+/*
+ * Memory backend on which another thread logs a message while the line is
+ * being typed, once 'log_offset' input characters have been read.
+ */
+struct LoggingInput {
+    nsh_io_memory_t mem;
+    nsh_t* nsh;
+    unsigned int log_offset;
+    const char* message;
+    unsigned int max_timeout_ms;
+};
+
+int logging_input_read(void* ctx)
+{
+    return nsh_io_memory_backend.read(&static_cast<LoggingInput*>(ctx)->mem);
+}
+
+void logging_input_write(void* ctx, const char* data, unsigned int size)
+{
+    nsh_io_memory_backend.write(&static_cast<LoggingInput*>(ctx)->mem, data, size);
+}
+
+bool logging_input_wait(void* ctx, unsigned int timeout_ms)
+{
+    auto* input = static_cast<LoggingInput*>(ctx);
+    input->max_timeout_ms = std::max(input->max_timeout_ms, timeout_ms);
+    if (input->message != nullptr && input->mem.input_offset == input->log_offset) {
+        // The message is logged while the shell waits, no input is received before the timeout
+        nsh_log_async(input->nsh, input->message);
+        input->message = nullptr;
+        return false;
+    }
+    return true;
+}
+
+const nsh_io_backend_t logging_input_backend = {
+    .read = logging_input_read,
+    .write = logging_input_write,
+    .wait = logging_input_wait,
+};
+
+class NshLog : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+    }
+
+    std::string run(const std::string& script, unsigned int log_offset = 0, const char* message = nullptr)
+    {
+        std::vector<char> output(16 * 1024);
+        input.nsh = &nsh;
+        input.log_offset = log_offset;
+        input.message = message;
+        input.max_timeout_ms = 0;
+        nsh_io_memory_init(&input.mem, script.data(), static_cast<unsigned int>(script.size()), output.data(),
+            static_cast<unsigned int>(output.size()));
+        nsh_set_io(&nsh, &logging_input_backend, &input);
+        nsh_run(&nsh);
+        return std::string(output.data(), std::min<std::size_t>(input.mem.output_size, output.size()));
+    }
+
+    nsh_t nsh;
+    LoggingInput input;
+};
+
+} // namespace
+
+TEST_F(NshLogQueue, SuccessPushPopInOrder)
+{
+    ASSERT_TRUE(nsh_log_queue_is_empty(&queue));
+    ASSERT_TRUE(push("first"));
+    ASSERT_TRUE(push("second"));
+
+    ASSERT_FALSE(nsh_log_queue_is_empty(&queue));
+    ASSERT_EQ(pop(), "first");
+    ASSERT_EQ(pop(), "second");
+    ASSERT_EQ(pop(), "<empty>");
+    ASSERT_TRUE(nsh_log_queue_is_empty(&queue));
+}
+
+TEST_F(NshLogQueue, SuccessTruncateLongMessage)
+{
+    std::string message(NSH_LOG_MESSAGE_SIZE + 10, 'a');
+
+    ASSERT_TRUE(push(message));
+
+    ASSERT_EQ(pop(), std::string(NSH_LOG_MESSAGE_SIZE, 'a'));
+}
+
+TEST_F(NshLogQueue, FailureDropWhenFull)
+{
+    for (unsigned int i = 0; i < NSH_LOG_QUEUE_SIZE; i++) {
+        ASSERT_TRUE(push(std::to_string(i)));
+    }
+
+    ASSERT_FALSE(push("dropped"));
+    ASSERT_EQ(nsh_log_queue_dropped_count(&queue), 1u);
+    ASSERT_EQ(pop(), "0");
+    ASSERT_TRUE(push("reused"));
+}
+
+TEST_F(NshLogQueue, SuccessSeveralLaps)
+{
+    for (unsigned int i = 0; i < 3 * NSH_LOG_QUEUE_SIZE; i++) {
+        ASSERT_TRUE(push(std::to_string(i)));
+        ASSERT_EQ(pop(), std::to_string(i));
+    }
+    ASSERT_EQ(nsh_log_queue_dropped_count(&queue), 0u);
+}
+
+#if GTEST_HAS_PTHREAD
+// Each producer thread logs numbered messages, retrying the ones which were dropped
+TEST_F(NshLogQueue, SuccessConcurrentProducers)
+{
+    constexpr unsigned int producer_count = 4;
+    constexpr unsigned int message_count = 2000;
+    std::vector<std::thread> producers;
+    for (unsigned int p = 0; p < producer_count; p++) {
+        producers.emplace_back([this, p] {
+            for (unsigned int i = 0; i < message_count;) {
+                if (push(std::to_string(p) + ":" + std::to_string(i))) {
+                    i++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<unsigned int> next(producer_count, 0);
+    bool in_order = true;
+    unsigned int received = 0;
+    while (received < producer_count * message_count) {
+        std::string message = pop();
+        if (message == "<empty>") {
+            std::this_thread::yield();
+            continue;
+        }
+        std::size_t separator = message.find(':');
+        auto p = static_cast<unsigned int>(std::stoul(message.substr(0, separator)));
+        auto i = static_cast<unsigned int>(std::stoul(message.substr(separator + 1)));
+        in_order = in_order && (i == next[p]);
+        next[p] = i + 1;
+        received++;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    ASSERT_TRUE(in_order);
+    ASSERT_TRUE(nsh_log_queue_is_empty(&queue));
+}
+#endif
+
+TEST_F(NshLog, SuccessDisplayAboveTypedLine)
+{
+    auto output = run("help\n", 2, "sensor ready");
+
+    // The typed characters are erased, then redrawn below the message
+    ASSERT_THAT(output, HasSubstr("> he\x1b[2K\rsensor ready\r\n> help\r\n"));
+    ASSERT_LE(input.max_timeout_ms, NSH_LOG_POLL_PERIOD_MS);
+}
+
+TEST_F(NshLog, SuccessStripTrailingNewline)
+{
+    auto output = run("exit\n", 0, "boot done\r\n");
+
+    ASSERT_THAT(output, HasSubstr("\rboot done\r\n> exit"));
+}
+
+TEST_F(NshLog, SuccessDisplayOnExit)
+{
+    nsh_log_async(&nsh, "first");
+    auto output = run("");
+
+    ASSERT_THAT(output, HasSubstr("first\r\n"));
+}
+
+TEST_F(NshLog, FailureReportDroppedMessages)
+{
+    for (unsigned int i = 0; i < NSH_LOG_QUEUE_SIZE; i++) {
+        ASSERT_EQ(nsh_log_async(&nsh, "message"), NSH_STATUS_OK);
+    }
+    ASSERT_EQ(nsh_log_async(&nsh, "dropped"), NSH_STATUS_BUFFER_OVERFLOW);
+
+    auto output = run("exit\n");
+
+    ASSERT_THAT(output, HasSubstr("WARNING: 1 log messages dropped\r\n"));
+}
+
+#endif // NSH_FEATURE_USE_ASYNC_LOG == 1
@@ -0,0 +1,113 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+
+#include <nsh/nsh_mem.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if GTEST_HAS_PTHREAD
+#include <pthread.h>
+#endif
+
+using testing::HasSubstr;
+using testing::MatchesRegex;
+using testing::Not;
+
+namespace {
+
+using nsh_test::run;
+
+} // namespace
+
+TEST(NshMem, SuccessHighWaterMark)
+{
+    char buffer[16];
+    nsh_mem_paint(buffer, sizeof(buffer));
+    ASSERT_EQ(nsh_mem_high_water_mark(buffer, sizeof(buffer)), 0u);
+
+    std::memcpy(buffer, "hello", 5);
+    buffer[0] = '\0';
+
+    ASSERT_EQ(nsh_mem_high_water_mark(buffer, sizeof(buffer)), 5u);
+}
+
+TEST(NshMem, SuccessStackHighWaterMark)
+{
+    char stack[64];
+    nsh_mem_paint(stack, sizeof(stack));
+    ASSERT_EQ(nsh_mem_stack_high_water_mark(stack, sizeof(stack)), 0u);
+
+    // The stack grows downward, from the end of the buffer
+    stack[sizeof(stack) - 10] = 0;
+
+    ASSERT_EQ(nsh_mem_stack_high_water_mark(stack, sizeof(stack)), 10u);
+}
+
+TEST(NshMem, FailurePaintAnotherStack)
+{
+    static char stack[1024];
+
+    ASSERT_EQ(nsh_mem_paint_stack(stack, sizeof(stack)), NSH_STATUS_WRONG_ARG);
+}
+
+TEST(NshMem, SuccessReportBufferPeaks)
+{
+    nsh_status_t status;
+    nsh_t nsh = nsh_init(&status);
+
+    auto output = run(nsh, "version\nmem\n");
+
+    // The longest line is "version" with its null terminator
+    ASSERT_THAT(output, MatchesRegex(".*line +" + std::to_string(NSH_LINE_BUFFER_SIZE) + " +8 .*"));
+    ASSERT_THAT(output, HasSubstr("output "));
+#if NSH_FEATURE_USE_HISTORY == 1
+    ASSERT_THAT(output, HasSubstr("history "));
+#endif
+    // The stack is unknown
+    ASSERT_THAT(output, Not(HasSubstr("stack ")));
+}
+
+#if GTEST_HAS_PTHREAD
+TEST(NshMem, SuccessReportStackPeak)
+{
+    constexpr std::size_t stack_size = 256 * 1024;
+    std::vector<char> stack(stack_size);
+    struct Context {
+        char* stack;
+        nsh_status_t status;
+        std::string output;
+    } context { stack.data(), NSH_STATUS_FAILURE, "" };
+
+    // Run the shell on a thread whose stack is known
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack.data(), stack_size);
+    pthread_t thread;
+    pthread_create(
+        &thread, &attr,
+        [](void* arg) -> void* {
+            auto* ctx = static_cast<Context*>(arg);
+            static nsh_t nsh;
+            nsh_init_inplace(&nsh);
+            ctx->status = nsh_set_stack(&nsh, ctx->stack, stack_size);
+            ctx->output = run(nsh, "mem\n");
+            return nullptr;
+        },
+        &context);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+
+    ASSERT_EQ(context.status, NSH_STATUS_OK);
+    ASSERT_THAT(context.output, MatchesRegex(".*stack +262144 +[1-9][0-9]* +[1-9][0-9]*.*"));
+}
+#endif
+
+#endif // NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
@@ -0,0 +1,181 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_PIPES == 1
+
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using testing::EndsWith;
+using testing::HasSubstr;
+using testing::Not;
+
+namespace {
+
+unsigned int dumped_lines;
+
+// Print "line <i>" lines until cancelled, at most 1000
+nsh_status_t cmd_dump(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    for (dumped_lines = 0; dumped_lines < 1000; dumped_lines++) {
+        if (nsh_cmd_is_cancelled(ctx)) {
+            return NSH_STATUS_CANCELLED;
+        }
+        nsh_io_put_string(ctx->io, "line ");
+        nsh_io_put_unsigned(ctx->io, dumped_lines);
+        nsh_io_put_newline(ctx->io);
+    }
+    return NSH_STATUS_OK;
+}
+
+// Print a line longer than the line buffer of the filters, ending with "END"
+nsh_status_t cmd_long(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    std::string line(NSH_PIPE_LINE_SIZE, 'x');
+    nsh_io_put_string(ctx->io, line.c_str());
+    nsh_io_put_string(ctx->io, "END");
+    nsh_io_put_newline(ctx->io);
+    return NSH_STATUS_OK;
+}
+
+nsh_status_t cmd_echo(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    for (unsigned int i = 1; i < argc; i++) {
+        nsh_io_put_string(ctx->io, argv[i]);
+        nsh_io_put_newline(ctx->io);
+    }
+    return NSH_STATUS_OK;
+}
+
+class NshPipe : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+        nsh_register_command(&nsh, "dump", cmd_dump);
+        nsh_register_command(&nsh, "echo", cmd_echo);
+        nsh_register_command(&nsh, "long", cmd_long);
+    }
+
+    // Run a single command line, returning its output without the echoed line, the prompts and the return code
+    std::string run(const std::string& line)
+    {
+        std::string result = nsh_test::run(nsh, line + "\n", 64 * 1024);
+        std::string echoed = "> " + line + "\r\n";
+        std::size_t begin = result.find(echoed);
+        std::size_t end = result.rfind("> ");
+        if (begin == std::string::npos || end < begin + echoed.size()) {
+            return result;
+        }
+        begin += echoed.size();
+        result = result.substr(begin, end - begin);
+#if NSH_FEATURE_USE_RETURN_CODE_PRINTING == 1
+        std::size_t return_code = result.rfind("command '");
+        if (return_code != std::string::npos) {
+            result.erase(return_code);
+        }
+#endif
+        return result;
+    }
+
+    nsh_t nsh;
+};
+
+} // namespace
+
+TEST_F(NshPipe, SuccessWithoutPipe)
+{
+    ASSERT_EQ(run("echo a b"), "a\r\nb\r\n");
+}
+
+TEST_F(NshPipe, SuccessGrep)
+{
+    ASSERT_EQ(run("echo foo bar food | grep foo"), "foo\r\nfood\r\n");
+    ASSERT_EQ(run("echo foo bar food | grep -v foo"), "bar\r\n");
+}
+
+TEST_F(NshPipe, SuccessGrepLongLine)
+{
+    // Lines longer than NSH_PIPE_LINE_SIZE are filtered as several lines
+    ASSERT_EQ(run("long | grep END"), "END\r\n");
+    ASSERT_EQ(run("long | grep xx"), std::string(NSH_PIPE_LINE_SIZE, 'x') + "\r\n");
+}
+
+TEST_F(NshPipe, SuccessHeadStopsCommand)
+{
+    ASSERT_EQ(run("dump | head -n 3"), "line 0\r\nline 1\r\nline 2\r\n");
+    // The command stopped soon after, and no error was reported
+    ASSERT_LT(dumped_lines, 1000u);
+}
+
+TEST_F(NshPipe, SuccessHeadDefault)
+{
+    std::string output = run("dump | head");
+
+    ASSERT_THAT(output, EndsWith("line 9\r\n"));
+    ASSERT_THAT(output, Not(HasSubstr("line 10")));
+}
+
+TEST_F(NshPipe, SuccessWc)
+{
+    ASSERT_EQ(run("echo one two three | wc"), "3 3 17\r\n");
+}
+
+TEST_F(NshPipe, SuccessHex)
+{
+    ASSERT_EQ(run("echo hi | hex"),
+        "00000000  68 69 0d 0a                                      |hi..|\r\n");
+}
+
+TEST_F(NshPipe, SuccessChainFilters)
+{
+    ASSERT_EQ(run("dump | grep 7 | wc"), "271 542 2690\r\n");
+    ASSERT_EQ(run("dump | grep 5 | head -n 2"), "line 5\r\nline 15\r\n");
+}
+
+TEST_F(NshPipe, FailureUnknownFilter)
+{
+    ASSERT_EQ(run("dump | sort"), "ERROR: filter 'sort' not found\r\n");
+}
+
+TEST_F(NshPipe, FailureMissingCommand)
+{
+    ASSERT_THAT(run("| wc"), HasSubstr("ERROR: missing command around '|'"));
+    ASSERT_THAT(run("dump |"), HasSubstr("ERROR: missing command around '|'"));
+    ASSERT_THAT(run("dump | | wc"), HasSubstr("ERROR: missing command around '|'"));
+}
+
+TEST_F(NshPipe, FailureCommandNotFound)
+{
+    std::string output = run("nope | wc");
+
+    // The filters are closed even though no command ran
+    ASSERT_THAT(output, HasSubstr("0 0 0\r\n"));
+    ASSERT_EQ(nsh.pipeline.count, 0u);
+}
+
+TEST_F(NshPipe, FailureTooManyFilters)
+{
+    std::string line = "dump";
+    for (unsigned int i = 0; i <= NSH_PIPE_MAX_FILTERS; i++) {
+        line += " | wc";
+    }
+
+    ASSERT_EQ(run(line), "ERROR: too many filters\r\n");
+}
+
+TEST_F(NshPipe, FailureFilterUsage)
+{
+    ASSERT_EQ(run("dump | grep"), "usage: grep [-v] <pattern>\r\n");
+    ASSERT_EQ(run("dump | head -n x"), "usage: head [-n <lines>]\r\n");
+    ASSERT_EQ(run("dump | wc -l"), "usage: wc\r\n");
+}
+
+#endif // NSH_FEATURE_USE_PIPES == 1
@@ -0,0 +1,189 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_REDIRECTION == 1
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using testing::HasSubstr;
+using testing::Not;
+
+namespace {
+
+nsh_status_t cmd_echo(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    for (unsigned int i = 1; i < argc; i++) {
+        nsh_io_put_string(ctx->io, argv[i]);
+        nsh_io_put_newline(ctx->io);
+    }
+    return NSH_STATUS_OK;
+}
+
+// Print 1000 lines, several times the size of the output buffer
+nsh_status_t cmd_dump(nsh_cmd_ctx_t* ctx, unsigned int, char**)
+{
+    for (unsigned int i = 0; i < 1000; i++) {
+        nsh_io_put_string(ctx->io, "line ");
+        nsh_io_put_unsigned(ctx->io, i);
+        nsh_io_put_newline(ctx->io);
+    }
+    return NSH_STATUS_OK;
+}
+
+/*
+ * Backend recording the files in memory, the written bytes being buffered until the file is closed.
+ */
+struct MemoryFile {
+    std::string path;
+    bool append;
+    std::string buffered;
+    std::string content;
+    unsigned int writes = 0;
+    bool closed = false;
+};
+
+MemoryFile memory_file;
+bool memory_file_fails;
+
+const nsh_redirect_backend_t memory_backend = {
+    [](const char* path, bool append) -> void* {
+        memory_file = { path, append, "", "", 0, false };
+        return &memory_file;
+    },
+    [](void* file, const char* data, unsigned int size) {
+        auto* memory = static_cast<MemoryFile*>(file);
+        memory->buffered.append(data, size);
+        memory->writes++;
+    },
+    [](void* file) {
+        auto* memory = static_cast<MemoryFile*>(file);
+        memory->content = memory->buffered;
+        memory->closed = true;
+        return memory_file_fails ? NSH_STATUS_FAILURE : NSH_STATUS_OK;
+    },
+};
+
+class NshRedirect : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+        nsh_register_command(&nsh, "echo", cmd_echo);
+        nsh_register_command(&nsh, "dump", cmd_dump);
+        memory_file_fails = false;
+    }
+
+    std::string run(const std::string& script) { return nsh_test::run(nsh, script); }
+
+    nsh_t nsh;
+};
+
+std::string read_file(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+} // namespace
+
+TEST_F(NshRedirect, SuccessTruncateFile)
+{
+    // File names are arguments, at most NSH_MAX_STRING_SIZE - 1 characters long
+    const char* path = "redirect.txt";
+    std::remove(path);
+
+    auto output = run("echo old > redirect.txt\necho a b > redirect.txt\n");
+
+    ASSERT_THAT(output, Not(HasSubstr("a\r\nb\r\n")));
+    ASSERT_EQ(read_file(path), "a\r\nb\r\n");
+    std::remove(path);
+}
+
+TEST_F(NshRedirect, SuccessAppendFile)
+{
+    const char* path = "redirect.txt";
+    std::remove(path);
+
+    run("echo a > redirect.txt\necho b >> redirect.txt\n");
+
+    ASSERT_EQ(read_file(path), "a\r\nb\r\n");
+    std::remove(path);
+}
+
+TEST_F(NshRedirect, SuccessFileWrittenOnCompletion)
+{
+    nsh_set_redirect_backend(&nsh, &memory_backend);
+
+    auto output = run("dump >> dump.txt\n");
+
+    ASSERT_EQ(memory_file.path, "dump.txt");
+    ASSERT_TRUE(memory_file.append);
+    ASSERT_TRUE(memory_file.closed);
+    ASSERT_THAT(memory_file.content, HasSubstr("line 0\r\n"));
+    ASSERT_THAT(memory_file.content, HasSubstr("line 999\r\n"));
+    // The output is written by whole buffers, not per character
+    ASSERT_LE(memory_file.writes, memory_file.content.size() / NSH_IO_OUTPUT_BUFFER_SIZE + 1);
+    ASSERT_THAT(output, Not(HasSubstr("line 0")));
+}
+
+#if NSH_FEATURE_USE_PIPES == 1
+TEST_F(NshRedirect, SuccessRedirectPipeline)
+{
+    nsh_set_redirect_backend(&nsh, &memory_backend);
+
+    auto output = run("dump | grep 99 | wc > count\n");
+
+    ASSERT_EQ(memory_file.content, "19 38 189\r\n");
+    ASSERT_THAT(output, Not(HasSubstr("19 38 189")));
+}
+#endif
+
+TEST_F(NshRedirect, FailureMissingFileName)
+{
+    nsh_set_redirect_backend(&nsh, &memory_backend);
+    memory_file = {};
+
+    auto output = run("echo a >\necho a > b c\n");
+
+    ASSERT_THAT(output, HasSubstr("ERROR: a redirection must end the command line with a file name"));
+    ASSERT_FALSE(memory_file.closed);
+}
+
+TEST_F(NshRedirect, FailureCannotOpen)
+{
+    auto output = run("echo a > /no/such/dir\n");
+
+    ASSERT_THAT(output, HasSubstr("ERROR: cannot open '/no/such/dir'"));
+}
+
+#if NSH_FEATURE_USE_PIPES == 1
+TEST_F(NshRedirect, FailureCannotOpenPipeline)
+{
+    auto output = run("echo a | wc > /no/such/dir\n");
+
+    ASSERT_THAT(output, HasSubstr("ERROR: cannot open '/no/such/dir'"));
+    ASSERT_EQ(nsh.pipeline.count, 0u);
+}
+#endif
+
+TEST_F(NshRedirect, FailureCannotWrite)
+{
+    nsh_set_redirect_backend(&nsh, &memory_backend);
+    memory_file_fails = true;
+
+    auto output = run("echo a > full\n");
+
+    ASSERT_THAT(output, HasSubstr("ERROR: cannot write 'full'"));
+}
+
+#endif // NSH_FEATURE_USE_REDIRECTION == 1
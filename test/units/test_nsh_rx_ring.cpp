@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <nsh/nsh_rx_ring.h>
+
+#include <string>
+#include <vector>
+
+#if GTEST_HAS_PTHREAD
+#include <thread>
+#endif
+
+namespace {
+
+class NshRxRing : public testing::Test {
+protected:
+    void SetUp() override { nsh_rx_ring_init(&ring); }
+
+    std::string pop(unsigned int size)
+    {
+        std::string data(size, '\0');
+        data.resize(nsh_rx_ring_pop(&ring, data.data(), size));
+        return data;
+    }
+
+    nsh_rx_ring_t ring;
+};
+
+} // namespace
+
+TEST_F(NshRxRing, SuccessEmpty)
+{
+    ASSERT_EQ(nsh_rx_ring_count(&ring), 0u);
+    ASSERT_EQ(pop(16), "");
+}
+
+TEST_F(NshRxRing, SuccessPushPopInOrder)
+{
+    ASSERT_EQ(nsh_rx_ring_push(&ring, "hello", 5), 5u);
+    ASSERT_EQ(nsh_rx_ring_push(&ring, " world", 6), 6u);
+
+    ASSERT_EQ(nsh_rx_ring_count(&ring), 11u);
+    ASSERT_EQ(pop(3), "hel");
+    ASSERT_EQ(pop(100), "lo world");
+    ASSERT_EQ(nsh_rx_ring_count(&ring), 0u);
+}
+
+TEST_F(NshRxRing, SuccessWrapAround)
+{
+    std::string data(NSH_RX_RING_SIZE - 3, 'a');
+    nsh_rx_ring_push(&ring, data.data(), static_cast<unsigned int>(data.size()));
+    pop(NSH_RX_RING_SIZE);
+
+    ASSERT_EQ(nsh_rx_ring_push(&ring, "0123456789", 10), 10u);
+
+    ASSERT_EQ(pop(100), "0123456789");
+}
+
+TEST_F(NshRxRing, FailureOverrunWhenFull)
+{
+    std::string data(NSH_RX_RING_SIZE + 10, 'a');
+
+    ASSERT_EQ(nsh_rx_ring_push(&ring, data.data(), static_cast<unsigned int>(data.size())), NSH_RX_RING_SIZE);
+    ASSERT_EQ(nsh_rx_ring_push(&ring, "b", 1), 0u);
+
+    ASSERT_EQ(nsh_rx_ring_overrun_count(&ring), 11u);
+    ASSERT_EQ(nsh_rx_ring_high_water_mark(&ring), NSH_RX_RING_SIZE);
+    ASSERT_EQ(pop(NSH_RX_RING_SIZE + 10), std::string(NSH_RX_RING_SIZE, 'a'));
+}
+
+TEST_F(NshRxRing, SuccessHighWaterMark)
+{
+    nsh_rx_ring_push(&ring, "abcdef", 6);
+    pop(4);
+    nsh_rx_ring_push(&ring, "gh", 2);
+
+    ASSERT_EQ(nsh_rx_ring_high_water_mark(&ring), 6u);
+    ASSERT_EQ(nsh_rx_ring_count(&ring), 4u);
+}
+
+TEST_F(NshRxRing, SuccessAddOverruns)
+{
+    nsh_rx_ring_add_overruns(&ring, 3);
+
+    ASSERT_EQ(nsh_rx_ring_overrun_count(&ring), 3u);
+}
+
+#if GTEST_HAS_PTHREAD
+// A producer thread plays the UART interrupt, and retries the bytes which were dropped
+TEST_F(NshRxRing, SuccessConcurrentProducer)
+{
+    constexpr unsigned int byte_count = 100000;
+    unsigned int dropped = 0;
+    std::thread producer([&] {
+        unsigned int sent = 0;
+        while (sent < byte_count) {
+            char chunk[7];
+            unsigned int chunk_size = 0;
+            while (chunk_size < sizeof(chunk) && sent + chunk_size < byte_count) {
+                chunk[chunk_size] = static_cast<char>((sent + chunk_size) % 251u);
+                chunk_size++;
+            }
+            unsigned int pushed = nsh_rx_ring_push(&ring, chunk, chunk_size);
+            dropped += chunk_size - pushed;
+            sent += pushed;
+            if (pushed == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    unsigned int received = 0;
+    bool in_order = true;
+    std::vector<char> data(64);
+    while (received < byte_count) {
+        unsigned int size = nsh_rx_ring_pop(&ring, data.data(), static_cast<unsigned int>(data.size()));
+        for (unsigned int i = 0; i < size; i++) {
+            in_order = in_order && (data[i] == static_cast<char>((received + i) % 251u));
+        }
+        received += size;
+        if (size == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    ASSERT_TRUE(in_order);
+    ASSERT_EQ(nsh_rx_ring_count(&ring), 0u);
+    ASSERT_EQ(nsh_rx_ring_overrun_count(&ring), dropped);
+    ASSERT_LE(nsh_rx_ring_high_water_mark(&ring), NSH_RX_RING_SIZE);
+}
+#endif
@@ -0,0 +1,331 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_SCRIPTS == 1
+
+#include <nsh/nsh_io_memory.h>
+#include <nsh/nsh_script.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+using testing::HasSubstr;
+using testing::Not;
+
+namespace {
+
+nsh_status_t cmd_echo(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    for (unsigned int i = 1; i < argc; i++) {
+        nsh_io_put_string(ctx->io, argv[i]);
+        nsh_io_put_string(ctx->io, (i + 1 < argc) ? " " : "");
+    }
+    nsh_io_put_newline(ctx->io);
+    return NSH_STATUS_OK;
+}
+
+// Succeed if the argument is an even number
+nsh_status_t cmd_even(nsh_cmd_ctx_t*, unsigned int argc, char** argv)
+{
+    return (argc > 1 && std::stoi(argv[1]) % 2 == 0) ? NSH_STATUS_OK : NSH_STATUS_FAILURE;
+}
+
+// Reverse the order of its arguments before printing them
+nsh_status_t cmd_reverse(nsh_cmd_ctx_t* ctx, unsigned int argc, char** argv)
+{
+    std::reverse(argv + 1, argv + argc);
+    return cmd_echo(ctx, argc, argv);
+}
+
+class NshScript : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+        nsh_register_command(&nsh, "echo", cmd_echo);
+        nsh_register_command(&nsh, "even", cmd_even);
+        nsh_register_command(&nsh, "reverse", cmd_reverse);
+        nsh_cancel_token_init(&cancel, nullptr, 0);
+    }
+
+    nsh_status_t compile(const char* source)
+    {
+        return nsh_script_compile(&script, &nsh, source);
+    }
+
+    // Run the compiled script directly, returning its output
+    std::string run_script(nsh_status_t* status = nullptr)
+    {
+        std::vector<char> output(16 * 1024);
+        nsh_io_memory_t mem;
+        nsh_io_memory_init(&mem, "", 0, output.data(), static_cast<unsigned int>(output.size()));
+        nsh_io_t io;
+        nsh_io_init(&io, &nsh_io_memory_backend, &mem);
+        nsh_cmd_ctx_t ctx = { &nsh, &io, &cancel };
+        nsh_status_t run_status = nsh_script_run(&script, &ctx);
+        nsh_io_flush(&io);
+        if (status != nullptr) {
+            *status = run_status;
+        }
+        return std::string(output.data(), std::min<std::size_t>(mem.output_size, output.size()));
+    }
+
+    // Run command lines through the shell, returning its output
+    std::string run(const std::string& input) { return nsh_test::run(nsh, input); }
+
+    nsh_t nsh;
+    nsh_script_t script;
+    nsh_cancel_token_t cancel;
+};
+
+} // namespace
+
+TEST_F(NshScript, SuccessForLoop)
+{
+    ASSERT_EQ(compile("for i in 1..3\necho i $i\nend"), NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "i 1\r\ni 2\r\ni 3\r\n");
+}
+
+TEST_F(NshScript, SuccessForLoopBoundsEvaluatedOnce)
+{
+    ASSERT_EQ(compile("let n 2; for i in 0..$n; let n $n + 1; echo $i; end; echo $n"), NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "0\r\n1\r\n2\r\n5\r\n");
+}
+
+TEST_F(NshScript, SuccessEmptyRange)
+{
+    ASSERT_EQ(compile("for i in 3..1; echo $i; end; echo done"), NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "done\r\n");
+}
+
+TEST_F(NshScript, SuccessWhileLoop)
+{
+    ASSERT_EQ(compile("let n 1; while $n < 100; let n $n * 3; end; echo $n"), NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "243\r\n");
+}
+
+TEST_F(NshScript, SuccessIfElseOnStatus)
+{
+    ASSERT_EQ(compile("for i in 1..4; even $i; if $? == 0; echo $i even; else; echo $i odd; end; end"),
+        NSH_STATUS_OK);
+
+    nsh_status_t status;
+    ASSERT_EQ(run_script(&status), "1 odd\r\n2 even\r\n3 odd\r\n4 even\r\n");
+    ASSERT_EQ(status, NSH_STATUS_OK);
+}
+
+TEST_F(NshScript, SuccessStatusArgument)
+{
+    ASSERT_EQ(compile("even 3; echo $?; even 4; echo $?"), NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), std::to_string(NSH_STATUS_FAILURE) + "\r\n0\r\n");
+}
+
+TEST_F(NshScript, SuccessReturnLastStatus)
+{
+    ASSERT_EQ(compile("echo a; even 1"), NSH_STATUS_OK);
+
+    nsh_status_t status;
+    run_script(&status);
+    ASSERT_EQ(status, NSH_STATUS_FAILURE);
+}
+
+TEST_F(NshScript, SuccessArithmetic)
+{
+    ASSERT_EQ(compile("let a 17 / 5; let b 17 % 5; let c 0x10 - 20; let d -2147483648; let e $d - 1; let f $d / -1; "
+                      "echo $a $b $c $d $e $f"),
+        NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "3 2 -4 -2147483648 2147483647 -2147483648\r\n");
+}
+
+TEST_F(NshScript, SuccessComparisons)
+{
+    ASSERT_EQ(compile("let a 1 == 1; let b 1 != 1; let c 2 < 1; let d 2 <= 2; let e 2 > 1; let f 1 >= 2; "
+                      "echo $a $b $c $d $e $f"),
+        NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "1 0 0 1 1 0\r\n");
+
+    ASSERT_EQ(compile("let a 1 -eq 1; let b 1 -ne 1; let c 2 -lt 1; let d 2 -le 2; let e 2 -gt 1; let f 1 -ge 2; "
+                      "echo $a $b $c $d $e $f"),
+        NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "1 0 0 1 1 0\r\n");
+}
+
+TEST_F(NshScript, SuccessVariablesResetOnEachRun)
+{
+    // A variable cannot be used before it is declared
+    ASSERT_EQ(compile("let n $n + 1; echo $n"), NSH_STATUS_WRONG_ARG);
+    ASSERT_EQ(compile("let n 0; let n $n + 1; echo $n"), NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "1\r\n");
+    ASSERT_EQ(run_script(), "1\r\n");
+}
+
+TEST_F(NshScript, SuccessArgumentsKeptAcrossCalls)
+{
+    ASSERT_EQ(compile("for i in 1..2; reverse a b $i; end"), NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "1 b a\r\n2 b a\r\n");
+}
+
+TEST_F(NshScript, SuccessLongVariableNameAtEndOfPool)
+{
+    // Fill the pool so that only the slot of the last argument is left
+    std::string filler(sizeof(script.pool) - sizeof("echo") - 12 - 1, 'x');
+    std::string source = "let long_variable_n 42; echo " + filler + " $long_variable_n";
+    ASSERT_EQ(compile(source.c_str()), NSH_STATUS_OK);
+    ASSERT_EQ(script.pool_size, sizeof(script.pool));
+
+    ASSERT_EQ(run_script(), filler + " 42\r\n");
+}
+
+TEST_F(NshScript, SuccessHandlersResolvedOnce)
+{
+    ASSERT_EQ(compile("echo a"), NSH_STATUS_OK);
+    ASSERT_EQ(script.code[0].opcode, NSH_SCRIPT_OP_CALL);
+    ASSERT_EQ(script.code[0].u.handler, cmd_echo);
+    ASSERT_EQ(script.code[0].argc, 2u);
+    ASSERT_FALSE(script.code[0].has_variable_args);
+    ASSERT_STREQ(&script.pool[script.args[script.code[0].target + 1]], "a");
+}
+
+TEST_F(NshScript, SuccessBlankStatements)
+{
+    ASSERT_EQ(compile("\n  ;; echo a ;\n\t\n"), NSH_STATUS_OK);
+
+    ASSERT_EQ(run_script(), "a\r\n");
+}
+
+TEST_F(NshScript, SuccessQuitStopsScript)
+{
+    ASSERT_EQ(compile("echo a; exit; echo b"), NSH_STATUS_OK);
+
+    nsh_status_t status;
+    auto output = run_script(&status);
+
+    ASSERT_EQ(status, NSH_STATUS_QUIT);
+    ASSERT_THAT(output, Not(HasSubstr("b")));
+}
+
+TEST_F(NshScript, FailureCancelledLoop)
+{
+    ASSERT_EQ(compile("while 1; end"), NSH_STATUS_OK);
+    nsh_cancel_token_cancel(&cancel);
+
+    nsh_status_t status;
+    run_script(&status);
+
+    ASSERT_EQ(status, NSH_STATUS_CANCELLED);
+}
+
+TEST_F(NshScript, FailureDivisionByZero)
+{
+    ASSERT_EQ(compile("let a 0; let b 1 / $a; echo b"), NSH_STATUS_OK);
+
+    nsh_status_t status;
+    ASSERT_EQ(run_script(&status), "");
+    ASSERT_EQ(status, NSH_STATUS_WRONG_ARG);
+    ASSERT_STREQ(script.error, "division by zero");
+}
+
+TEST_F(NshScript, FailureCompile)
+{
+    const std::vector<std::pair<const char*, nsh_status_t>> sources = {
+        { "echo a; nope", NSH_STATUS_CMD_NOT_FOUND },
+        { "echo a; echo $x", NSH_STATUS_WRONG_ARG },
+        { "echo a; let 1x 2", NSH_STATUS_WRONG_ARG },
+        { "echo a; let x 1 ^ 2", NSH_STATUS_WRONG_ARG },
+        { "echo a; let x 1 +", NSH_STATUS_WRONG_ARG },
+        { "echo a; let x 12ab", NSH_STATUS_WRONG_ARG },
+        { "echo a; for i 1..2", NSH_STATUS_WRONG_ARG },
+        { "echo a; for i in 1", NSH_STATUS_WRONG_ARG },
+        { "echo a; else", NSH_STATUS_WRONG_ARG },
+        { "echo a; end", NSH_STATUS_WRONG_ARG },
+        { "echo a; if 1 2", NSH_STATUS_WRONG_ARG },
+        { "echo a; while 1", NSH_STATUS_WRONG_ARG },
+        { "echo a; script echo", NSH_STATUS_WRONG_ARG },
+    };
+    for (const auto& [source, expected] : sources) {
+        ASSERT_EQ(compile(source), expected) << source;
+        ASSERT_EQ(script.error_statement, 2u) << source;
+        ASSERT_NE(script.error, nullptr) << source;
+        ASSERT_EQ(script.code_size, 0u) << source;
+        ASSERT_EQ(run_script(), "") << source;
+    }
+
+    ASSERT_EQ(compile("if 1; else; else; end"), NSH_STATUS_WRONG_ARG);
+    ASSERT_EQ(script.error_statement, 3u);
+}
+
+TEST_F(NshScript, FailureTooLarge)
+{
+    std::string nested;
+    for (unsigned int i = 0; i <= NSH_SCRIPT_MAX_DEPTH; i++) {
+        nested += "while 0; ";
+    }
+    ASSERT_EQ(compile(nested.c_str()), NSH_STATUS_BUFFER_OVERFLOW);
+
+    std::string calls;
+    for (unsigned int i = 0; i < NSH_SCRIPT_MAX_INSTRUCTIONS; i++) {
+        calls += "let x 1; ";
+    }
+    ASSERT_EQ(compile(calls.c_str()), NSH_STATUS_BUFFER_OVERFLOW);
+
+    std::string variables;
+    for (unsigned int i = 0; i <= NSH_SCRIPT_MAX_VARIABLES; i++) {
+        variables += "let v" + std::to_string(i) + " 1; ";
+    }
+    ASSERT_EQ(compile(variables.c_str()), NSH_STATUS_BUFFER_OVERFLOW);
+
+    std::string args = "echo";
+    for (unsigned int i = 0; i < NSH_SCRIPT_MAX_ARGS; i++) {
+        args += " a";
+    }
+    ASSERT_EQ(compile(args.c_str()), NSH_STATUS_BUFFER_OVERFLOW);
+    ASSERT_STREQ(script.error, "too many arguments");
+}
+
+TEST_F(NshScript, SuccessScriptCommand)
+{
+    auto output = run("script for i in 1..2; echo $i; end\nscript\n");
+
+    ASSERT_THAT(output, HasSubstr("end\r\n1\r\n2\r\n"));
+    ASSERT_THAT(output, HasSubstr("script\r\n1\r\n2\r\n"));
+}
+
+TEST_F(NshScript, SuccessScriptCommandStatus)
+{
+    // The redirection operators cannot be used on the command line
+    auto output = run("script let x 3; while $x -gt 0; let x $x - 1; end; even $x\n");
+
+    ASSERT_THAT(output, Not(HasSubstr("ERROR")));
+#if NSH_FEATURE_USE_RETURN_CODE_PRINTING == 1
+    ASSERT_THAT(output, HasSubstr("command 'script' return 0"));
+#endif
+}
+
+TEST_F(NshScript, FailureScriptCommand)
+{
+    auto output = run("script\nscript echo a; nope\nscript let a 1 / 0\n");
+
+    ASSERT_THAT(output, HasSubstr("usage: script"));
+    ASSERT_THAT(output, HasSubstr("ERROR: statement 2: unknown command"));
+    ASSERT_THAT(output, Not(HasSubstr("not found")));
+    ASSERT_THAT(output, HasSubstr("ERROR: division by zero"));
+}
+
+#endif // NSH_FEATURE_USE_SCRIPTS == 1
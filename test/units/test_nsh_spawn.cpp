@@ -0,0 +1,109 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1 && defined(__unix__)
+
+#include <nsh/nsh_interrupt_posix.h>
+#include <nsh/nsh_spawn_posix.h>
+
+#include <chrono>
+#include <string>
+
+using testing::HasSubstr;
+using testing::Not;
+
+namespace {
+
+using nsh_test::run;
+
+class NshSpawn : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+        nsh_set_command_not_found_handler(&nsh, nsh_posix_spawn_command);
+    }
+
+    nsh_t nsh;
+};
+
+} // namespace
+
+TEST_F(NshSpawn, SuccessRunProgram)
+{
+    auto output = run(nsh, "echo hello world\n");
+
+    ASSERT_THAT(output, HasSubstr("\r\nhello world\r\n"));
+    ASSERT_THAT(output, Not(HasSubstr("not found")));
+}
+
+TEST_F(NshSpawn, SuccessRegisteredCommandFirst)
+{
+    auto output = run(nsh, "version\n");
+
+    ASSERT_THAT(output, Not(HasSubstr("not found")));
+}
+
+TEST_F(NshSpawn, SuccessProgramStatus)
+{
+    nsh_cmd_ctx_t ctx = { &nsh, &nsh.io, nullptr };
+    char true_program[] = "true";
+    char false_program[] = "false";
+    char* true_argv[] = { true_program };
+    char* false_argv[] = { false_program };
+
+    ASSERT_EQ(nsh_posix_spawn_command(&ctx, 1, true_argv), NSH_STATUS_OK);
+    ASSERT_EQ(nsh_posix_spawn_command(&ctx, 1, false_argv), NSH_STATUS_FAILURE);
+}
+
+TEST_F(NshSpawn, FailureProgramNotFound)
+{
+    // Arguments are at most NSH_MAX_STRING_SIZE - 1 characters long
+    auto output = run(nsh, "nsh-no-such\n");
+
+    ASSERT_THAT(output, HasSubstr("ERROR: command 'nsh-no-such' not found"));
+}
+
+TEST_F(NshSpawn, FailureUnknownCommandWithoutHandler)
+{
+    nsh_set_command_not_found_handler(&nsh, nullptr);
+
+    auto output = run(nsh, "echo hello world\n");
+
+    ASSERT_THAT(output, HasSubstr("ERROR: command 'echo' not found"));
+    ASSERT_THAT(output, Not(HasSubstr("\r\nhello world\r\n")));
+}
+
+TEST_F(NshSpawn, FailureProgramTimedOut)
+{
+    nsh_set_clock(&nsh, nsh_posix_clock_ms);
+    nsh_set_command_timeout(&nsh, 100);
+
+    auto output = run(nsh, "sleep 10\n");
+
+    ASSERT_THAT(output, HasSubstr("ERROR: command 'sleep' timed out"));
+}
+
+TEST_F(NshSpawn, FailureCancelledProgramIgnoringSigterm)
+{
+    // Cancelled once the program is running and ignoring SIGTERM
+    nsh_cancel_token_t cancel;
+    nsh_cancel_token_init(&cancel, nsh_posix_clock_ms, 300);
+    nsh_cmd_ctx_t ctx = { &nsh, &nsh.io, &cancel };
+    char shell[] = "sh";
+    char option[] = "-c";
+    char script[] = "trap '' TERM; echo started; exec sleep 10";
+    char* argv[] = { shell, option, script };
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(nsh_posix_spawn_command(&ctx, 3, argv), NSH_STATUS_CANCELLED);
+
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+#endif // NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1 && defined(__unix__)
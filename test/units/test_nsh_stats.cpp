@@ -0,0 +1,140 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_CMD_STATS == 1
+
+#include <cstdlib>
+#include <string>
+
+using testing::HasSubstr;
+using testing::Not;
+
+namespace {
+
+uint32_t fake_cycles;
+
+uint32_t fake_cycle_counter()
+{
+    return fake_cycles;
+}
+
+// Take the number of cycles given as first argument
+nsh_status_t cmd_work(nsh_cmd_ctx_t*, unsigned int argc, char** argv)
+{
+    fake_cycles += (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 0;
+    return NSH_STATUS_OK;
+}
+
+nsh_status_t cmd_fail(nsh_cmd_ctx_t*, unsigned int, char**)
+{
+    fake_cycles += 5;
+    return NSH_STATUS_FAILURE;
+}
+
+class NshStats : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        fake_cycles = 0;
+        nsh_status_t status;
+        nsh = nsh_init(&status);
+        nsh_register_command(&nsh, "work", cmd_work);
+        nsh_register_command(&nsh, "fail", cmd_fail);
+        nsh_set_cycle_counter(&nsh, fake_cycle_counter, 0);
+    }
+
+    std::string run(const std::string& script) { return nsh_test::run(nsh, script); }
+
+    const nsh_cmd_stats_t& stats(const char* name)
+    {
+        return nsh_cmd_array_find(&nsh.cmds, name)->stats;
+    }
+
+    nsh_t nsh;
+};
+
+} // namespace
+
+TEST(NshCmdStats, SuccessRecord)
+{
+    nsh_cmd_stats_t stats;
+    nsh_cmd_stats_reset(&stats);
+
+    nsh_cmd_stats_record(&stats, 10, false);
+    nsh_cmd_stats_record(&stats, 30, true);
+    nsh_cmd_stats_record(&stats, 20, false);
+
+    ASSERT_EQ(stats.call_count, 3u);
+    ASSERT_EQ(stats.error_count, 1u);
+    ASSERT_EQ(stats.min_cycles, 10u);
+    ASSERT_EQ(stats.max_cycles, 30u);
+    ASSERT_EQ(stats.total_cycles, 60u);
+}
+
+TEST_F(NshStats, SuccessCountCallsAndErrors)
+{
+    run("work 10\nwork 30\nfail\nunknown\n");
+
+    ASSERT_EQ(stats("work").call_count, 2u);
+    ASSERT_EQ(stats("work").error_count, 0u);
+    ASSERT_EQ(stats("work").min_cycles, 10u);
+    ASSERT_EQ(stats("work").max_cycles, 30u);
+    ASSERT_EQ(stats("work").total_cycles, 40u);
+    ASSERT_EQ(stats("fail").call_count, 1u);
+    ASSERT_EQ(stats("fail").error_count, 1u);
+}
+
+TEST_F(NshStats, SuccessWithoutCycleCounter)
+{
+    nsh_set_cycle_counter(&nsh, nullptr, 0);
+
+    run("work 10\n");
+
+    ASSERT_EQ(stats("work").call_count, 1u);
+    ASSERT_EQ(stats("work").total_cycles, 0u);
+}
+
+TEST_F(NshStats, SuccessDisplaySortedByTotalCycles)
+{
+    auto output = run("work 10\nwork 30\nfail\nfail\nstats\n");
+
+    auto table = output.substr(output.find("command"));
+    ASSERT_THAT(table, HasSubstr("mean(cyc)"));
+    ASSERT_THAT(table, HasSubstr("work                2      0        10        30        20"));
+    ASSERT_THAT(table, HasSubstr("fail                2      2         5         5         5"));
+    ASSERT_LT(table.find("work "), table.find("fail "));
+    // The commands never called are not listed
+    ASSERT_THAT(table, Not(HasSubstr("help ")));
+}
+
+TEST_F(NshStats, SuccessDisplayInMicroseconds)
+{
+    nsh_set_cycle_counter(&nsh, fake_cycle_counter, 2000000u);
+
+    auto output = run("work 100\nstats\n");
+
+    ASSERT_THAT(output, HasSubstr("mean(us)"));
+    ASSERT_THAT(output, HasSubstr("work                1      0        50        50        50"));
+}
+
+TEST_F(NshStats, SuccessReset)
+{
+    run("work 10\nstats reset\n");
+
+    ASSERT_EQ(stats("work").call_count, 0u);
+    ASSERT_EQ(stats("work").total_cycles, 0u);
+}
+
+TEST_F(NshStats, FailureWrongArgument)
+{
+    auto output = run("stats clear\n");
+
+    ASSERT_THAT(output, HasSubstr("usage: stats [reset]"));
+    ASSERT_EQ(stats("stats").error_count, 1u);
+}
+
+#endif // NSH_FEATURE_USE_CMD_STATS == 1
@@ -0,0 +1,233 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nsh/nsh.h>
+#include <nsh/nsh_trace.h>
+
+#include "nsh_test_shell.hpp"
+
+#if NSH_FEATURE_USE_TRACE == 1
+
+#include <nsh/nsh_trace_chrome.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+using testing::HasSubstr;
+
+namespace {
+
+uint32_t fake_time;
+
+uint32_t fake_clock()
+{
+    return fake_time;
+}
+
+nsh_status_t cmd_work(nsh_cmd_ctx_t*, unsigned int, char**)
+{
+    fake_time += 100;
+    return NSH_STATUS_OK;
+}
+
+class NshTrace : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        fake_time = 1000;
+        nsh_trace_start(&trace, fake_clock, 0);
+    }
+
+    std::vector<nsh_trace_record_t> records(nsh_trace_phase_t phase)
+    {
+        std::vector<nsh_trace_record_t> result;
+        for (unsigned int i = 0; i < nsh_trace_count(&trace); i++) {
+            if (nsh_trace_get(&trace, i)->phase == phase) {
+                result.push_back(*nsh_trace_get(&trace, i));
+            }
+        }
+        return result;
+    }
+
+    nsh_trace_t trace;
+};
+
+} // namespace
+
+TEST_F(NshTrace, SuccessRecordPhasesOfLine)
+{
+    nsh_status_t status;
+    nsh_t nsh = nsh_init(&status);
+    nsh_register_command(&nsh, "work", cmd_work);
+    nsh_set_trace(&nsh, &trace);
+    std::string script = "work\n";
+
+    nsh_test::run(nsh, script);
+
+    // One read per input byte, plus the end of input
+    ASSERT_EQ(records(NSH_TRACE_PHASE_READ).size(), script.size() + 1);
+    ASSERT_EQ(records(NSH_TRACE_PHASE_ECHO).size(), 4u);
+    ASSERT_EQ(records(NSH_TRACE_PHASE_SPLIT).size(), 1u);
+    ASSERT_EQ(records(NSH_TRACE_PHASE_LOOKUP).size(), 1u);
+    ASSERT_FALSE(records(NSH_TRACE_PHASE_FLUSH).empty());
+    auto handler = records(NSH_TRACE_PHASE_HANDLER);
+    ASSERT_EQ(handler.size(), 1u);
+    ASSERT_EQ(handler[0].start, 1000u);
+    ASSERT_EQ(handler[0].duration, 100u);
+    for (unsigned int i = 0; i < nsh_trace_count(&trace); i++) {
+        ASSERT_EQ(nsh_trace_get(&trace, i)->instance, &nsh.io);
+    }
+}
+
+TEST_F(NshTrace, SuccessRecordInstances)
+{
+    nsh_status_t status;
+    nsh_t first = nsh_init(&status);
+    nsh_t second = nsh_init(&status);
+    nsh_set_trace(&first, &trace);
+    nsh_set_trace(&second, &trace);
+
+    nsh_test::run(first, "version\n");
+    unsigned int first_count = nsh_trace_count(&trace);
+    nsh_test::run(second, "version\n");
+
+    ASSERT_GT(first_count, 0u);
+    ASSERT_EQ(nsh_trace_count(&trace), 2 * first_count);
+    for (unsigned int i = 0; i < nsh_trace_count(&trace); i++) {
+        ASSERT_EQ(nsh_trace_get(&trace, i)->instance, (i < first_count) ? &first.io : &second.io);
+    }
+}
+
+TEST_F(NshTrace, SuccessSeparateTraces)
+{
+    nsh_status_t status;
+    nsh_t first = nsh_init(&status);
+    nsh_t second = nsh_init(&status);
+    nsh_trace_t second_trace;
+    nsh_set_trace(&first, &trace);
+    nsh_set_trace(&second, &second_trace);
+
+    nsh_test::run(first, "version\n");
+    unsigned int first_count = nsh_trace_count(&trace);
+    // Starting the trace of a shell does not clear the one of another
+    nsh_trace_start(&second_trace, fake_clock, 0);
+    nsh_test::run(second, "version\n");
+
+    ASSERT_GT(first_count, 0u);
+    ASSERT_EQ(nsh_trace_count(&trace), first_count);
+    ASSERT_EQ(nsh_trace_count(&second_trace), first_count);
+    for (unsigned int i = 0; i < first_count; i++) {
+        ASSERT_EQ(nsh_trace_get(&trace, i)->instance, &first.io);
+        ASSERT_EQ(nsh_trace_get(&second_trace, i)->instance, &second.io);
+    }
+}
+
+TEST_F(NshTrace, SuccessNotTraced)
+{
+    nsh_status_t status;
+    nsh_t nsh = nsh_init(&status);
+
+    nsh_test::run(nsh, "version\n");
+
+    ASSERT_EQ(nsh_trace_count(&trace), 0u);
+}
+
+TEST_F(NshTrace, SuccessStopRecording)
+{
+    nsh_io_t io;
+    nsh_io_init(&io, &nsh_io_stdio_backend, nullptr);
+    io.trace = &trace;
+    NSH_TRACE_BEGIN(&io, SPLIT);
+    NSH_TRACE_END(&io, SPLIT);
+    nsh_trace_stop(&trace);
+    NSH_TRACE_BEGIN(&io, LOOKUP);
+    NSH_TRACE_END(&io, LOOKUP);
+
+    ASSERT_EQ(nsh_trace_count(&trace), 1u);
+    ASSERT_EQ(nsh_trace_get(&trace, 0)->phase, NSH_TRACE_PHASE_SPLIT);
+    ASSERT_EQ(nsh_trace_get(&trace, 0)->instance, &io);
+}
+
+TEST_F(NshTrace, SuccessOverwriteOldestRecords)
+{
+    for (unsigned int i = 0; i < NSH_TRACE_RING_SIZE + 3; i++) {
+        nsh_trace_push(&trace, nullptr, NSH_TRACE_PHASE_HANDLER, i);
+    }
+
+    ASSERT_EQ(nsh_trace_count(&trace), NSH_TRACE_RING_SIZE);
+    ASSERT_EQ(nsh_trace_overwritten_count(&trace), 3u);
+    ASSERT_EQ(nsh_trace_get(&trace, 0)->start, 3u);
+    ASSERT_EQ(nsh_trace_get(&trace, NSH_TRACE_RING_SIZE - 1)->start, NSH_TRACE_RING_SIZE + 2);
+}
+
+// The exporter is built on POSIX platforms only
+#if defined(__unix__) || defined(__APPLE__)
+TEST_F(NshTrace, SuccessExportChrome)
+{
+    int first = 0;
+    int second = 0;
+    nsh_trace_start(&trace, fake_clock, 2000000u);
+    fake_time = 500;
+    nsh_trace_push(&trace, &first, NSH_TRACE_PHASE_READ, 0);
+    fake_time = 3501;
+    nsh_trace_push(&trace, &second, NSH_TRACE_PHASE_HANDLER, 500);
+    nsh_trace_push(&trace, &first, NSH_TRACE_PHASE_FLUSH, 3501);
+    nsh_trace_stop(&trace);
+
+    const std::string path = testing::TempDir() + "nsh_trace_chrome_test.json";
+    ASSERT_EQ(nsh_trace_export_chrome_to_path(&trace, path.c_str()), NSH_STATUS_OK);
+    std::stringstream json;
+    json << std::ifstream(path).rdbuf();
+    std::remove(path.c_str());
+
+    ASSERT_THAT(json.str(), HasSubstr("\"traceEvents\":["));
+    const std::string pid = "\"pid\":" + std::to_string(getpid());
+    ASSERT_THAT(json.str(),
+        HasSubstr("{\"name\":\"read\",\"cat\":\"nsh\",\"ph\":\"X\",\"ts\":0.000,\"dur\":250.000," + pid + ",\"tid\":1}"));
+    ASSERT_THAT(json.str(),
+        HasSubstr("{\"name\":\"handler\",\"cat\":\"nsh\",\"ph\":\"X\",\"ts\":250.000,\"dur\":1500.500," + pid
+            + ",\"tid\":2}"));
+    ASSERT_THAT(json.str(), HasSubstr("{\"name\":\"flush\",\"cat\":\"nsh\",\"ph\":\"X\",\"ts\":1750.500,\"dur\":0.000,"
+                                      + pid + ",\"tid\":1}"));
+    ASSERT_THAT(json.str(), HasSubstr("\"overwritten\":0"));
+}
+
+TEST_F(NshTrace, SuccessExportChromeNestedAfterWrap)
+{
+    int instance = 0;
+    // The enclosing handler ends after the flushes nested in it, which fill the ring, the clock wrapping meanwhile
+    const uint32_t handler_start = UINT32_MAX - 99u;
+    fake_time = 0;
+    for (unsigned int i = 0; i < NSH_TRACE_RING_SIZE; i++) {
+        nsh_trace_push(&trace, &instance, NSH_TRACE_PHASE_FLUSH, i);
+    }
+    nsh_trace_push(&trace, &instance, NSH_TRACE_PHASE_HANDLER, handler_start);
+    nsh_trace_stop(&trace);
+
+    const std::string path = testing::TempDir() + "nsh_trace_chrome_nested_test.json";
+    ASSERT_EQ(nsh_trace_export_chrome_to_path(&trace, path.c_str()), NSH_STATUS_OK);
+    std::stringstream json;
+    json << std::ifstream(path).rdbuf();
+    std::remove(path.c_str());
+
+    ASSERT_THAT(json.str(), HasSubstr("{\"name\":\"handler\",\"cat\":\"nsh\",\"ph\":\"X\",\"ts\":0.000,"));
+    // The oldest flush kept started at 1
+    ASSERT_THAT(json.str(), HasSubstr("{\"name\":\"flush\",\"cat\":\"nsh\",\"ph\":\"X\",\"ts\":101.000,"));
+    ASSERT_THAT(json.str(), HasSubstr("\"overwritten\":1"));
+}
+
+TEST_F(NshTrace, FailureExportToMissingDirectory)
+{
+    ASSERT_EQ(nsh_trace_export_chrome_to_path(&trace, "/nonexistent-directory/trace.json"), NSH_STATUS_FAILURE);
+}
+#endif
+
+#endif // NSH_FEATURE_USE_TRACE == 1
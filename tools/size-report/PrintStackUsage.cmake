@@ -0,0 +1,160 @@
+# Distributed under the MIT License. See accompanying LICENSE file for details.
+
+#[=======================================================================[.rst:
+PrintStackUsage
+---------------
+
+Parse the callgraphs generated by GCC with -fcallgraph-info=su for a library
+and print the worst-case stack depth of each of its entry points, with the call
+chain reaching it. Fail if a depth exceeds the given budget.
+
+Variables to define on the command line:
+
+``NAME``
+  Name of the report.
+``OBJECT_DIR``
+  Directory searched recursively for the .ci callgraph files.
+``ENTRY_POINTS``
+  Comma-separated list of the functions to analyze, the missing ones are skipped.
+``BUDGET``
+  Maximum stack depth allowed in bytes, 0 to disable the check.
+``HANDLERS``
+  Regular expression matching the command handlers of the library.
+``HANDLER_CALLERS``
+  Comma-separated list of the functions calling the command handlers.
+
+The handler callers are counted as calling each handler, except the handlers
+already in the call chain: a script cannot run another script. Other indirect
+calls (I/O backends, application handlers...) and functions compiled without
+callgraph information (libc...) are counted as using no stack.
+
+#]=======================================================================]
+
+cmake_minimum_required(VERSION 3.17)
+
+file(GLOB_RECURSE callgraph_files ${OBJECT_DIR}/*.ci)
+if(NOT callgraph_files)
+    message(FATAL_ERROR
+        " No callgraph file found in ${OBJECT_DIR}.\n"
+        " Ensure the library has been built with -fcallgraph-info=su."
+    )
+endif()
+
+string(REPLACE "," ";" handler_callers "${HANDLER_CALLERS}")
+
+# Store the frame size and the callees of each function into global properties
+foreach(callgraph_file IN LISTS callgraph_files)
+    file(STRINGS ${callgraph_file} lines REGEX "^(node|edge):")
+    foreach(line IN LISTS lines)
+        if(line MATCHES "^node: { title: \"([^\"]+)\" label: \"[^\"]*\\\\n([0-9]+) bytes \\(([a-z,]+)\\)\"")
+            set(function ${CMAKE_MATCH_1})
+            set_property(GLOBAL PROPERTY nsh_su_frame:${function} ${CMAKE_MATCH_2})
+            if(CMAKE_MATCH_3 STREQUAL "dynamic")
+                set_property(GLOBAL APPEND PROPERTY nsh_su_unbounded ${function})
+            endif()
+            string(REGEX REPLACE "^.*:" "" function_name "${function}")
+            if(NOT "${HANDLERS}" STREQUAL "" AND function_name MATCHES "${HANDLERS}")
+                set_property(GLOBAL APPEND PROPERTY nsh_su_handlers ${function})
+            endif()
+            if(function_name IN_LIST handler_callers)
+                set_property(GLOBAL PROPERTY nsh_su_handler_caller:${function} TRUE)
+            endif()
+        elseif(line MATCHES "^edge: { sourcename: \"([^\"]+)\" targetname: \"([^\"]+)\"")
+            get_property(callees GLOBAL PROPERTY nsh_su_callees:${CMAKE_MATCH_1})
+            if(NOT CMAKE_MATCH_2 IN_LIST callees)
+                set_property(GLOBAL APPEND PROPERTY nsh_su_callees:${CMAKE_MATCH_1} ${CMAKE_MATCH_2})
+            endif()
+        endif()
+    endforeach()
+endforeach()
+
+# Compute the worst-case stack depth of 'function', remembering the deepest callee of each function
+function(nsh_stack_depth function result)
+    get_property(depth GLOBAL PROPERTY nsh_su_depth:${function})
+    if(NOT "${depth}" STREQUAL "")
+        set(${result} ${depth} PARENT_SCOPE)
+        return()
+    endif()
+    get_property(visiting GLOBAL PROPERTY nsh_su_visiting:${function})
+    if(visiting)
+        message(FATAL_ERROR "${NAME}: ${function} is recursive, its stack depth is unbounded")
+    endif()
+    set_property(GLOBAL PROPERTY nsh_su_visiting:${function} TRUE)
+
+    get_property(frame GLOBAL PROPERTY nsh_su_frame:${function})
+    if("${frame}" STREQUAL "")
+        set(frame 0)
+    endif()
+    set(deepest 0)
+    set(deepest_callee "")
+    get_property(callees GLOBAL PROPERTY nsh_su_callees:${function})
+    foreach(callee IN LISTS callees)
+        nsh_stack_depth(${callee} callee_depth)
+        if(callee_depth GREATER deepest)
+            set(deepest ${callee_depth})
+            set(deepest_callee ${callee})
+        endif()
+    endforeach()
+    get_property(handler_caller GLOBAL PROPERTY nsh_su_handler_caller:${function})
+    if(handler_caller)
+        get_property(handlers GLOBAL PROPERTY nsh_su_handlers)
+        foreach(handler IN LISTS handlers)
+            get_property(handler_visiting GLOBAL PROPERTY nsh_su_visiting:${handler})
+            if(handler_visiting)
+                continue()
+            endif()
+            nsh_stack_depth(${handler} handler_depth)
+            if(handler_depth GREATER deepest)
+                set(deepest ${handler_depth})
+                set(deepest_callee ${handler})
+            endif()
+        endforeach()
+    endif()
+    math(EXPR depth "${frame} + ${deepest}")
+
+    set_property(GLOBAL PROPERTY nsh_su_visiting:${function} FALSE)
+    set_property(GLOBAL PROPERTY nsh_su_depth:${function} ${depth})
+    set_property(GLOBAL PROPERTY nsh_su_deepest_callee:${function} ${deepest_callee})
+    set(${result} ${depth} PARENT_SCOPE)
+endfunction()
+
+string(REPLACE "," ";" entry_points "${ENTRY_POINTS}")
+set(over_budget "")
+message("${NAME}: worst-case stack usage")
+foreach(entry_point IN LISTS entry_points)
+    get_property(frame GLOBAL PROPERTY nsh_su_frame:${entry_point})
+    if("${frame}" STREQUAL "")
+        continue()
+    endif()
+    nsh_stack_depth(${entry_point} depth)
+
+    # Print the call chain reaching the worst-case depth, static functions being prefixed by their file
+    set(chain "")
+    set(function ${entry_point})
+    while(NOT "${function}" STREQUAL "")
+        get_property(frame GLOBAL PROPERTY nsh_su_frame:${function})
+        string(REGEX REPLACE "^.*:" "" function_name "${function}")
+        if("${frame}" STREQUAL "")
+            list(APPEND chain "${function_name} (?)")
+        else()
+            list(APPEND chain "${function_name} (${frame})")
+        endif()
+        get_property(function GLOBAL PROPERTY nsh_su_deepest_callee:${function})
+    endwhile()
+    list(JOIN chain " -> " chain)
+    message("  ${entry_point}: ${depth} bytes\n    ${chain}")
+
+    if(BUDGET GREATER 0 AND depth GREATER BUDGET)
+        list(APPEND over_budget ${entry_point})
+    endif()
+endforeach()
+
+get_property(unbounded GLOBAL PROPERTY nsh_su_unbounded)
+if(unbounded)
+    message(WARNING "${NAME}: unbounded dynamic stack allocation in ${unbounded}")
+endif()
+
+if(over_budget)
+    list(JOIN over_budget ", " over_budget)
+    message(FATAL_ERROR "${NAME}: stack usage of ${over_budget} exceeds the budget of ${BUDGET} bytes")
+endif()
@@ -0,0 +1,76 @@
+#include <nsh/nsh.h>
+
+#include <cstddef>
+#include <cstdio>
+
+namespace {
+
+#define NSH_PRINT_FIELD(field) \
+    std::printf("  %-24s offset %6zu  size %6zu\n", #field, offsetof(nsh_t, field), sizeof(nsh_t::field))
+
+// Print the size of each field of nsh_t, showing the RAM used by each feature
+void print_layout(const char* name)
+{
+    std::printf("%s: sizeof(nsh_t) = %zu\n", name, sizeof(nsh_t));
+    NSH_PRINT_FIELD(io);
+    NSH_PRINT_FIELD(line);
+    NSH_PRINT_FIELD(cmds);
+#if NSH_FEATURE_USE_RUNTIME_LIMITS == 1
+    NSH_PRINT_FIELD(args);
+    NSH_PRINT_FIELD(argv);
+    NSH_PRINT_FIELD(args_max_count);
+#endif
+    NSH_PRINT_FIELD(cancel);
+    NSH_PRINT_FIELD(clock);
+    NSH_PRINT_FIELD(command_timeout_ms);
+#if NSH_FEATURE_USE_CMD_STATS == 1
+    NSH_PRINT_FIELD(cycle_counter);
+    NSH_PRINT_FIELD(cycle_counter_frequency_hz);
+#endif
+#if NSH_FEATURE_USE_EXTERNAL_COMMANDS == 1
+    NSH_PRINT_FIELD(command_not_found_handler);
+#endif
+#if NSH_FEATURE_USE_PIPES == 1
+    NSH_PRINT_FIELD(pipeline);
+#endif
+#if NSH_FEATURE_USE_REDIRECTION == 1
+    NSH_PRINT_FIELD(redirect);
+#endif
+#if NSH_FEATURE_USE_SCRIPTS == 1
+    NSH_PRINT_FIELD(script);
+#endif
+#if NSH_FEATURE_USE_HIGH_WATER_MARKS == 1
+    NSH_PRINT_FIELD(stack_limit);
+    NSH_PRINT_FIELD(stack_size);
+#endif
+#if NSH_FEATURE_USE_HISTORY == 1
+    NSH_PRINT_FIELD(history);
+    NSH_PRINT_FIELD(current_history_entry);
+    NSH_PRINT_FIELD(history_entry_shown);
+    NSH_PRINT_FIELD(history_candidates);
+    NSH_PRINT_FIELD(history_candidate_count);
+    NSH_PRINT_FIELD(history_candidate_index);
+#endif
+#if NSH_FEATURE_USE_HISTORY_PERSISTENCE == 1
+    NSH_PRINT_FIELD(history_log);
+#endif
+#if NSH_FEATURE_USE_JOBS == 1
+    NSH_PRINT_FIELD(jobs);
+#endif
+#if NSH_FEATURE_USE_ASYNC_LOG == 1
+    NSH_PRINT_FIELD(log);
+    NSH_PRINT_FIELD(log_dropped_reported);
+#endif
+}
+
+} // namespace
+
+namespace nsh::tools {
+
+int main(int /*argc*/, char* argv[])
+{
+    print_layout(argv[0]);
+    return 0;
+}
+
+} // namespace nsh::tools
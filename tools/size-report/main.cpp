@@ -13,13 +13,19 @@ int main(int /*argc*/, char* /*argv*/[])
 
 #include <nsh/nsh.h>
 
+namespace {
+
+// Static storage, so that the shell is neither built on the stack nor copied
+nsh_t shell;
+
+} // namespace
+
 namespace nsh::tools {
 
 int main(int /*argc*/, char* /*argv*/[])
 {
-    nsh_status_t status = NSH_STATUS_OK;
-    nsh_t nsh = nsh_init(&status);
-    nsh_run(&nsh);
+    nsh_init_inplace(&shell);
+    nsh_run(&shell);
     return 0;
 }
 